@@ -0,0 +1,65 @@
+#include "BiCGSTAB.h"
+#include <cmath>
+
+// Solves A * x = b. Initial guess is taken from [x] (warm start) unless it is empty.
+bool BiCGSTAB::solve(const LinearOperator& A, const Matrix& b, Matrix& x)
+{
+	Matrix r = _start(A, b, x);
+
+	float normB = std::sqrt(_dot(b, b));
+	if (normB == 0.0f)
+		normB = 1.0f;
+
+	if (_record(std::sqrt(_dot(r, r)) / normB))
+		return true;
+
+	const Matrix rHat = r; // shadow residual
+	Matrix p = r;
+	Matrix v;
+	float rho = 1.0f, alpha = 1.0f, omega = 1.0f;
+
+	while (_iterations < maxIterations)
+	{
+		_iterations++;
+
+		const float rhoNew = _dot(rHat, r);
+		if (rhoNew == 0.0f)
+			break; // breakdown
+
+		if (_iterations > 1)
+			p = r + ((rhoNew / rho) * (alpha / omega)) * (p - omega * v);
+
+		const Matrix pHat = _precondition(p);
+		v = A.apply(pHat);
+
+		const float rv = _dot(rHat, v);
+		if (rv == 0.0f)
+			break; // breakdown
+
+		alpha = rhoNew / rv;
+		Matrix s = r - alpha * v;
+
+		const float normS = std::sqrt(_dot(s, s)) / normB;
+		if (normS <= tolerance)
+		{
+			x += alpha * pHat;
+			_record(normS);
+			break;
+		}
+
+		const Matrix sHat = _precondition(s);
+		const Matrix t = A.apply(sHat);
+
+		const float tt = _dot(t, t);
+		omega = (tt > 0.0f) ? _dot(t, s) / tt : 0.0f;
+
+		x += alpha * pHat + omega * sHat;
+		r = s - omega * t;
+		rho = rhoNew;
+
+		if (_record(std::sqrt(_dot(r, r)) / normB) || omega == 0.0f)
+			break;
+	}
+
+	return _converged;
+}
@@ -0,0 +1,14 @@
+#ifndef _BICGSTAB_H_
+#define _BICGSTAB_H_
+
+#include "IterativeSolver.h"
+
+// Implements right-preconditioned stabilized bi-conjugate gradient method for general (nonsymmetric) systems.
+class BiCGSTAB : public IterativeSolver
+{
+public:
+	// Solves A * x = b. Initial guess is taken from [x] (warm start) unless it is empty.
+	virtual bool solve(const LinearOperator& A, const Matrix& b, Matrix& x);
+};
+
+#endif // _BICGSTAB_H_
@@ -0,0 +1,43 @@
+#include "ConjugateGradient.h"
+#include <cmath>
+
+// Solves A * x = b. Initial guess is taken from [x] (warm start) unless it is empty.
+bool ConjugateGradient::solve(const LinearOperator& A, const Matrix& b, Matrix& x)
+{
+	Matrix r = _start(A, b, x);
+
+	float normB = std::sqrt(_dot(b, b));
+	if (normB == 0.0f)
+		normB = 1.0f;
+
+	if (_record(std::sqrt(_dot(r, r)) / normB))
+		return true;
+
+	Matrix z = _precondition(r);
+	Matrix p = z;
+	float rz = _dot(r, z);
+
+	while (_iterations < maxIterations)
+	{
+		_iterations++;
+
+		Matrix Ap = A.apply(p);
+		const float pAp = _dot(p, Ap);
+		if (pAp == 0.0f)
+			break; // breakdown
+
+		const float alpha = rz / pAp;
+		x += alpha * p;
+		r -= alpha * Ap;
+
+		if (_record(std::sqrt(_dot(r, r)) / normB))
+			break;
+
+		z = _precondition(r);
+		const float rzNew = _dot(r, z);
+		p = z + (rzNew / rz) * p;
+		rz = rzNew;
+	}
+
+	return _converged;
+}
@@ -0,0 +1,14 @@
+#ifndef _CONJUGATE_GRADIENT_H_
+#define _CONJUGATE_GRADIENT_H_
+
+#include "IterativeSolver.h"
+
+// Implements preconditioned conjugate gradient method for symmetric positive definite systems.
+class ConjugateGradient : public IterativeSolver
+{
+public:
+	// Solves A * x = b. Initial guess is taken from [x] (warm start) unless it is empty.
+	virtual bool solve(const LinearOperator& A, const Matrix& b, Matrix& x);
+};
+
+#endif // _CONJUGATE_GRADIENT_H_
@@ -0,0 +1,110 @@
+#include "GMRES.h"
+#include <cmath>
+#include <vector>
+
+// Creates solver with given restart length (dimension of the Krylov subspace).
+GMRES::GMRES(int restart)
+	: IterativeSolver(), restart(restart) {}
+
+// Solves A * x = b. Initial guess is taken from [x] (warm start) unless it is empty.
+bool GMRES::solve(const LinearOperator& A, const Matrix& b, Matrix& x)
+{
+	Matrix r = _start(A, b, x);
+
+	float normB = std::sqrt(_dot(b, b));
+	if (normB == 0.0f)
+		normB = 1.0f;
+
+	float beta = std::sqrt(_dot(r, r));
+	if (_record(beta / normB))
+		return true;
+
+	const int m = (restart > 0) ? restart : 1;
+
+	std::vector<Matrix> V(m + 1);			// orthonormal basis of the Krylov subspace
+	std::vector<float> H((m + 1) * m);		// Hessenberg matrix (row by row)
+	std::vector<float> cs(m), sn(m);		// Givens rotations
+	std::vector<float> g(m + 1);			// rotated right hand side
+	std::vector<float> y(m);
+
+	while (_iterations < maxIterations)
+	{
+		V[0] = r / beta;
+		g.assign(m + 1, 0.0f);
+		g[0] = beta;
+
+		int k = 0;
+		bool breakdown = false;
+		while (k < m && _iterations < maxIterations)
+		{
+			_iterations++;
+			const int j = k++;
+
+			// Arnoldi step with modified Gram-Schmidt
+			Matrix w = A.apply(_precondition(V[j]));
+			for (int i = 0; i <= j; i++)
+			{
+				const float h = _dot(w, V[i]);
+				H[i * m + j] = h;
+				w -= h * V[i];
+			}
+
+			const float hNext = std::sqrt(_dot(w, w));
+			H[(j + 1) * m + j] = hNext;
+			breakdown = (hNext == 0.0f);
+			if (!breakdown)
+				V[j + 1] = w / hNext;
+
+			// apply previous rotations to the new column
+			for (int i = 0; i < j; i++)
+			{
+				const float h0 = H[i * m + j];
+				const float h1 = H[(i + 1) * m + j];
+				H[i * m + j] = cs[i] * h0 + sn[i] * h1;
+				H[(i + 1) * m + j] = -sn[i] * h0 + cs[i] * h1;
+			}
+
+			// new rotation eliminating H[j+1, j]
+			const float h0 = H[j * m + j];
+			const float denom = std::hypot(h0, hNext);
+			cs[j] = (denom > 0.0f) ? h0 / denom : 1.0f;
+			sn[j] = (denom > 0.0f) ? hNext / denom : 0.0f;
+			H[j * m + j] = denom;
+			H[(j + 1) * m + j] = 0.0f;
+
+			g[j + 1] = -sn[j] * g[j];
+			g[j] = cs[j] * g[j];
+
+			if (_record(std::abs(g[j + 1]) / normB) || breakdown)
+				break;
+		}
+
+		// solve upper triangular system H * y = g
+		for (int i = k - 1; i >= 0; i--)
+		{
+			float s = g[i];
+			for (int l = i + 1; l < k; l++)
+				s -= H[i * m + l] * y[l];
+
+			y[i] = (H[i * m + i] != 0.0f) ? s / H[i * m + i] : 0.0f;
+		}
+
+		// x = x + inv(M) * V * y
+		Matrix update = y[0] * V[0];
+		for (int i = 1; i < k; i++)
+			update += y[i] * V[i];
+
+		x += _precondition(update);
+
+		if (_converged || breakdown)
+			break;
+
+		// restart from true residual
+		r = b - A.apply(x);
+		beta = std::sqrt(_dot(r, r));
+		if (beta == 0.0f)
+			break;
+	}
+
+	return _converged;
+}
@@ -0,0 +1,20 @@
+#ifndef _GMRES_H_
+#define _GMRES_H_
+
+#include "IterativeSolver.h"
+
+// Implements restarted generalized minimal residual method GMRES(m) with right preconditioning.
+class GMRES : public IterativeSolver
+{
+public:
+	// Creates solver with given restart length (dimension of the Krylov subspace).
+	GMRES(int restart = 30);
+
+	// Solves A * x = b. Initial guess is taken from [x] (warm start) unless it is empty.
+	virtual bool solve(const LinearOperator& A, const Matrix& b, Matrix& x);
+
+	// Number of iterations between restarts. Default value is 30
+	int restart;
+};
+
+#endif // _GMRES_H_
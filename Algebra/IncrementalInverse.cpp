@@ -0,0 +1,72 @@
+#include "IncrementalInverse.h"
+#include <stdexcept>
+
+// Creates empty inverse.
+IncrementalInverse::IncrementalInverse()
+	: _inv() {}
+
+// Creates inverse of given matrix. See reset().
+IncrementalInverse::IncrementalInverse(const Matrix& mat)
+	: _inv()
+{
+	reset(mat);
+}
+
+// Inverts given matrix from scratch (O(n^3)). Throws std::runtime_error when matrix is singular.
+void IncrementalInverse::reset(const Matrix& mat)
+{
+	_inv = mat.inv();
+}
+
+// Sets inverse directly (e.g. scaled unit matrix as a prior).
+void IncrementalInverse::setInverse(const Matrix& inv)
+{
+	if (inv.rows() != inv.columns())
+		throw std::invalid_argument("IncrementalInverse: Matrix is not square.");
+
+	_inv = inv;
+}
+
+// Updates inverse for A = A + u * trans(v), where [u] and [v] are column vectors.
+// Returns false (inverse unchanged) when the updated matrix is singular.
+bool IncrementalInverse::update(const Matrix& u, const Matrix& v)
+{
+	if (u.rows() != _inv.rows() || v.rows() != _inv.rows() || u.columns() != 1 || v.columns() != 1)
+		throw std::invalid_argument("IncrementalInverse: Dimension mismatch.");
+
+	// inv(A + u v') = inv(A) - inv(A) u v' inv(A) / (1 + v' inv(A) u)
+	Matrix Pu = _inv * u;
+	Matrix vP = v.t() * _inv;
+
+	const float denom = 1.0f + (float)(vP * u);
+	if (denom == 0.0f)
+		return false;
+
+	_inv -= (Pu / denom) * vP;
+	return true;
+}
+
+// Updates inverse for A = A + U * C * trans(V), where [U], [V] are (n x k) and [C] is (k x k).
+// Empty [C] stands for unit matrix. Returns false (inverse unchanged) when the updated matrix is singular.
+bool IncrementalInverse::update(const Matrix& U, const Matrix& C, const Matrix& V)
+{
+	const int k = U.columns();
+	if (U.rows() != _inv.rows() || V.size() != U.size() || (!C.empty() && C.size() != Size(k, k)))
+		throw std::invalid_argument("IncrementalInverse: Dimension mismatch.");
+
+	// inv(A + U C V') = inv(A) - inv(A) U inv(inv(C) + V' inv(A) U) V' inv(A)
+	Matrix PU = _inv * U;
+	Matrix VP = V.t() * _inv;
+
+	try
+	{
+		Matrix S = (C.empty() ? Matrix::eye(k) : C.inv()) + VP * U;
+		_inv -= PU * (S.inv() * VP);
+	}
+	catch (const std::runtime_error&)
+	{
+		return false; // capacitance matrix is singular
+	}
+
+	return true;
+}
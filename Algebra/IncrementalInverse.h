@@ -0,0 +1,41 @@
+#ifndef _INCREMENTAL_INVERSE_H_
+#define _INCREMENTAL_INVERSE_H_
+
+#include "../Matrix.h"
+
+// Maintains inverse of a square matrix under low-rank updates in O(n^2) per rank
+// (Sherman-Morrison and Sherman-Morrison-Woodbury formulas).
+class IncrementalInverse
+{
+private:
+	Matrix _inv;
+
+public:
+	// Creates empty inverse.
+	IncrementalInverse();
+
+	// Creates inverse of given matrix. See reset().
+	IncrementalInverse(const Matrix& mat);
+
+	// Inverts given matrix from scratch (O(n^3)). Throws std::runtime_error when matrix is singular.
+	void reset(const Matrix& mat);
+
+	// Sets inverse directly (e.g. scaled unit matrix as a prior).
+	void setInverse(const Matrix& inv);
+
+	// Updates inverse for A = A + u * trans(v), where [u] and [v] are column vectors.
+	// Returns false (inverse unchanged) when the updated matrix is singular.
+	bool update(const Matrix& u, const Matrix& v);
+
+	// Updates inverse for A = A + U * C * trans(V), where [U], [V] are (n x k) and [C] is (k x k).
+	// Empty [C] stands for unit matrix. Returns false (inverse unchanged) when the updated matrix is singular.
+	bool update(const Matrix& U, const Matrix& C, const Matrix& V);
+
+	// Returns current inverse.
+	const Matrix& inverse() const { return _inv; }
+
+	// Solves A * X = B using current inverse (O(n^2) per column).
+	Matrix solve(const Matrix& B) const { return _inv * B; }
+};
+
+#endif // _INCREMENTAL_INVERSE_H_
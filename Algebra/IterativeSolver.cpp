@@ -0,0 +1,38 @@
+#include "IterativeSolver.h"
+#include <cmath>
+#include <stdexcept>
+
+// Creates solver with default settings.
+IterativeSolver::IterativeSolver()
+	: _iterations(0), _converged(false), _residuals(), maxIterations(1000), tolerance(1e-5f), preconditioner(NULL) {}
+
+// Prepares initial guess [x] (zero when empty) and returns initial residual b - A * x.
+Matrix IterativeSolver::_start(const LinearOperator& A, const Matrix& b, Matrix& x)
+{
+	if (b.rows() != A.size() || b.columns() != 1)
+		throw std::invalid_argument("IterativeSolver: Dimension mismatch.");
+
+	_iterations = 0;
+	_converged = false;
+	_residuals.clear();
+
+	if (x.empty())
+	{
+		x = Matrix(b.rows(), 1);
+		x.clear();
+		return b;
+	}
+
+	if (x.size() != b.size())
+		throw std::invalid_argument("IterativeSolver: Initial guess has wrong dimensions.");
+
+	return b - A.apply(x);
+}
+
+// Records relative residual of the current iteration. Returns true when converged.
+bool IterativeSolver::_record(float residual)
+{
+	_residuals.push_back(residual);
+	_converged = (residual <= tolerance);
+	return _converged;
+}
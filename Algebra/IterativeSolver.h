@@ -0,0 +1,59 @@
+#ifndef _ITERATIVE_SOLVER_H_
+#define _ITERATIVE_SOLVER_H_
+
+#include "LinearOperator.h"
+#include "Preconditioner.h"
+#include <vector>
+
+// Abstract interface for iterative (Krylov) solvers of linear system A * x = b.
+// Collects convergence telemetry of the last solve (iterations and relative residual history).
+class IterativeSolver
+{
+protected:
+	int _iterations;
+	bool _converged;
+	std::vector<float> _residuals;
+
+	// Prepares initial guess [x] (zero when empty) and returns initial residual b - A * x.
+	Matrix _start(const LinearOperator& A, const Matrix& b, Matrix& x);
+
+	// Records relative residual of the current iteration. Returns true when converged.
+	bool _record(float residual);
+
+	// Applies preconditioner (identity when not set).
+	Matrix _precondition(const Matrix& r) const { return preconditioner ? preconditioner->apply(r) : r; }
+
+	// Returns dot product of two column vectors.
+	static float _dot(const Matrix& a, const Matrix& b) { return (float)(a.t() * b); }
+
+public:
+	// Creates solver with default settings.
+	IterativeSolver();
+
+	// Destroys the solver.
+	virtual ~IterativeSolver() {}
+
+	// Solves A * x = b. Initial guess is taken from [x] (warm start) unless it is empty.
+	// Returns true when relative residual reached the tolerance.
+	virtual bool solve(const LinearOperator& A, const Matrix& b, Matrix& x) = 0;
+
+	// Returns number of iterations of the last solve.
+	int iterations() const { return _iterations; }
+
+	// Returns true when the last solve converged.
+	bool converged() const { return _converged; }
+
+	// Returns relative residual norm |b - A * x| / |b| before the first and after each iteration.
+	const std::vector<float>& residuals() const { return _residuals; }
+
+	// Maximal number of iterations. Default value is 1000
+	int maxIterations;
+
+	// Relative residual tolerance. Default value is 1e-5
+	float tolerance;
+
+	// Preconditioner used by the solver or NULL. Not owned by the solver.
+	const Preconditioner* preconditioner;
+};
+
+#endif // _ITERATIVE_SOLVER_H_
@@ -0,0 +1,10 @@
+#include "LinearOperator.h"
+#include <stdexcept>
+
+// Wraps given square matrix (shares its storage).
+MatrixOperator::MatrixOperator(const Matrix& mat)
+	: _mat(mat)
+{
+	if (mat.rows() != mat.columns())
+		throw std::invalid_argument("MatrixOperator: Matrix is not square.");
+}
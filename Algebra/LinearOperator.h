@@ -0,0 +1,59 @@
+#ifndef _LINEAR_OPERATOR_H_
+#define _LINEAR_OPERATOR_H_
+
+#include "../Matrix.h"
+#include <functional>
+
+// Abstract square linear operator y = A * x used by matrix-free solvers.
+class LinearOperator
+{
+public:
+	virtual ~LinearOperator() {}
+
+	// Returns dimension of the operator (number of rows of x).
+	virtual int size() const = 0;
+
+	// Applies operator to column vector [x].
+	virtual Matrix apply(const Matrix& x) const = 0;
+};
+
+// Linear operator given by dense matrix.
+class MatrixOperator : public LinearOperator
+{
+private:
+	Matrix _mat;
+
+public:
+	// Wraps given square matrix (shares its storage).
+	MatrixOperator(const Matrix& mat);
+
+	// Returns dimension of the operator.
+	virtual int size() const { return _mat.rows(); }
+
+	// Returns A * x.
+	virtual Matrix apply(const Matrix& x) const { return _mat * x; }
+
+	// Returns wrapped matrix.
+	const Matrix& matrix() const { return _mat; }
+};
+
+// Linear operator given by user function (e.g. sparse matrix or stencil).
+class FunctionOperator : public LinearOperator
+{
+private:
+	int _size;
+	std::function<Matrix(const Matrix&)> _func;
+
+public:
+	// Wraps function computing A * x for column vectors of given size.
+	FunctionOperator(int size, const std::function<Matrix(const Matrix&)>& func)
+		: _size(size), _func(func) {}
+
+	// Returns dimension of the operator.
+	virtual int size() const { return _size; }
+
+	// Returns A * x.
+	virtual Matrix apply(const Matrix& x) const { return _func(x); }
+};
+
+#endif // _LINEAR_OPERATOR_H_
@@ -0,0 +1,80 @@
+#include "PCA.h"
+#include "SymmetricEigen.h"
+#include <cmath>
+#include <stdexcept>
+
+// Creates empty analysis.
+PCA::PCA()
+	: _mean(), _components(), _offset(), _variances() {}
+
+// Fits [count] principal components (all if count <= 0) to the dataset (features x samples).
+// When [whiten] is set, projected components are scaled to unit variance. [epsilon] regularizes the scaling.
+void PCA::fit(const Matrix& data, int count, bool whiten, float epsilon)
+{
+	const int features = data.rows();
+	const int samples = data.columns();
+
+	if (samples < 2)
+		throw std::invalid_argument("PCA: At least two samples are required.");
+
+	// mean sample
+	_mean = Matrix(features, 1);
+	for (int r = 0; r < features; r++)
+	{
+		float s = 0.0f;
+		for (int c = 0; c < samples; c++)
+			s += data.at(r, c);
+
+		_mean.at(r, 0) = s / samples;
+	}
+
+	// centered data
+	Matrix centered(features, samples);
+	for (int r = 0; r < features; r++)
+	{
+		const float m = _mean.at(r, 0);
+		for (int c = 0; c < samples; c++)
+			centered.at(r, c) = data.at(r, c) - m;
+	}
+
+	// covariance (lower triangle only, eigensolver does not read the upper one) and its largest eigenpairs
+	Matrix cov = Matrix::syrk(centered, false);
+	const float divisor = (float)(samples - 1);
+	for (int r = 0; r < features; r++)
+		for (int c = 0; c <= r; c++)
+			cov.at(r, c) /= divisor;
+	SymmetricEigen eig(cov, count, true);
+
+	_variances = eig.values();
+	_components = eig.vectors().t();
+
+	if (whiten)
+	{
+		for (int r = 0; r < _components.rows(); r++)
+		{
+			const float scale = 1.0f / std::sqrt(std::max(_variances.at(r, 0), 0.0f) + epsilon);
+			for (int c = 0; c < _components.columns(); c++)
+				_components.at(r, c) *= scale;
+		}
+	}
+
+	_offset = _components * _mean;
+}
+
+// Projects dataset (features x samples) to principal components (components x samples) using single matrix product.
+Matrix PCA::project(const Matrix& data) const
+{
+	if (data.rows() != _components.columns())
+		throw std::invalid_argument("PCA: Dimension mismatch.");
+
+	// W * (X - m) = W * X - W * m
+	Matrix res = _components * data;
+	for (int r = 0; r < res.rows(); r++)
+	{
+		const float o = _offset.at(r, 0);
+		for (int c = 0; c < res.columns(); c++)
+			res.at(r, c) -= o;
+	}
+
+	return res;
+}
@@ -0,0 +1,37 @@
+#ifndef _PCA_H_
+#define _PCA_H_
+
+#include "../Matrix.h"
+
+// Implements principal component analysis of a dataset stored column by column (one sample per column).
+// Fitted projection can also whiten the data (unit variance of each component).
+class PCA
+{
+private:
+	Matrix _mean;			// mean sample (column vector)
+	Matrix _components;		// principal directions stored in rows (scaled when whitening)
+	Matrix _offset;			// projection of the mean sample (column vector)
+	Matrix _variances;		// variance along each principal direction (column vector)
+
+public:
+	// Creates empty analysis.
+	PCA();
+
+	// Fits [count] principal components (all if count <= 0) to the dataset (features x samples).
+	// When [whiten] is set, projected components are scaled to unit variance. [epsilon] regularizes the scaling.
+	void fit(const Matrix& data, int count = 0, bool whiten = false, float epsilon = 1e-5f);
+
+	// Projects dataset (features x samples) to principal components (components x samples) using single matrix product.
+	Matrix project(const Matrix& data) const;
+
+	// Returns mean sample (column vector).
+	const Matrix& mean() const { return _mean; }
+
+	// Returns projection matrix, each row is one (possibly scaled) principal direction.
+	const Matrix& components() const { return _components; }
+
+	// Returns variance along each principal direction in descending order (column vector).
+	const Matrix& variances() const { return _variances; }
+};
+
+#endif // _PCA_H_
@@ -0,0 +1,185 @@
+#include "Preconditioner.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+// Creates preconditioner from square matrix (uses its diagonal) or from column vector holding the diagonal.
+JacobiPreconditioner::JacobiPreconditioner(const Matrix& mat)
+	: _invDiag(mat.rows(), 1)
+{
+	const bool square = (mat.rows() == mat.columns());
+	if (!square && mat.columns() != 1)
+		throw std::invalid_argument("JacobiPreconditioner: Expected square matrix or diagonal.");
+
+	for (int i = 0; i < mat.rows(); i++)
+	{
+		const float d = square ? mat.at(i, i) : mat.at(i, 0);
+		if (d == 0.0f)
+			throw std::runtime_error("JacobiPreconditioner: Zero on diagonal.");
+
+		_invDiag.at(i, 0) = 1.0f / d;
+	}
+}
+
+// Returns inv(diag(A)) .* r
+Matrix JacobiPreconditioner::apply(const Matrix& r) const
+{
+	return Matrix::elemProd(_invDiag, r);
+}
+
+// Factorizes given symmetric positive definite matrix.
+IncompleteCholesky::IncompleteCholesky(const Matrix& mat)
+	: _size(mat.rows()), _values(), _columns(), _rowStart(mat.rows() + 1)
+{
+	if (mat.rows() != mat.columns())
+		throw std::invalid_argument("IncompleteCholesky: Matrix is not square.");
+
+	// collect sparsity pattern of the lower triangle (diagonal is always present)
+	for (int r = 0; r < _size; r++)
+	{
+		_rowStart[r] = (int)_values.size();
+		for (int c = 0; c < r; c++)
+		{
+			const float x = mat.at(r, c);
+			if (x != 0.0f)
+			{
+				_values.push_back(x);
+				_columns.push_back(c);
+			}
+		}
+
+		_values.push_back(mat.at(r, r));
+		_columns.push_back(r);
+	}
+	_rowStart[_size] = (int)_values.size();
+
+	_factorize();
+}
+
+// Factorizes symmetric positive definite matrix of given size stored in compressed sparse rows.
+IncompleteCholesky::IncompleteCholesky(int size, const std::vector<int>& rowStart, const std::vector<int>& columns,
+	const std::vector<float>& values)
+	: _size(size), _values(), _columns(), _rowStart(size >= 0 ? size + 1 : 0)
+{
+	if (size < 0 || (int)rowStart.size() != size + 1 || rowStart[0] != 0 || rowStart[size] != (int)columns.size()
+		|| columns.size() != values.size())
+		throw std::invalid_argument("IncompleteCholesky: Invalid sparse matrix.");
+
+	// lower triangle of each row sorted by column, duplicates summed, diagonal last (always present)
+	std::vector<std::pair<int, float> > row;
+	for (int r = 0; r < _size; r++)
+	{
+		if (rowStart[r + 1] < rowStart[r] || rowStart[r + 1] > rowStart[_size])
+			throw std::invalid_argument("IncompleteCholesky: Invalid sparse matrix.");
+
+		row.clear();
+		for (int p = rowStart[r]; p < rowStart[r + 1]; p++)
+		{
+			if (columns[p] < 0 || columns[p] >= _size)
+				throw std::invalid_argument("IncompleteCholesky: Invalid sparse matrix.");
+			if (columns[p] <= r)
+				row.push_back(std::make_pair(columns[p], values[p]));
+		}
+		std::sort(row.begin(), row.end(),
+			[](const std::pair<int, float>& a, const std::pair<int, float>& b) { return a.first < b.first; });
+
+		_rowStart[r] = (int)_values.size();
+		float diagonal = 0.0f;
+		for (unsigned k = 0; k < row.size(); k++)
+		{
+			if (row[k].first == r)
+				diagonal += row[k].second;
+			else if (k > 0 && row[k].first == row[k - 1].first)
+				_values.back() += row[k].second;
+			else
+			{
+				_values.push_back(row[k].second);
+				_columns.push_back(row[k].first);
+			}
+		}
+
+		_values.push_back(diagonal);
+		_columns.push_back(r);
+	}
+	_rowStart[_size] = (int)_values.size();
+
+	_factorize();
+}
+
+// Factorizes lower triangle stored in _values in place
+void IncompleteCholesky::_factorize()
+{
+	// row oriented factorization restricted to the pattern
+	for (int i = 0; i < _size; i++)
+	{
+		const int iBegin = _rowStart[i];
+		const int iDiag = _rowStart[i + 1] - 1;
+
+		for (int p = iBegin; p < iDiag; p++)
+		{
+			const int k = _columns[p];
+			const int kBegin = _rowStart[k];
+			const int kDiag = _rowStart[k + 1] - 1;
+
+			// L[i,k] = (A[i,k] - sum_j<k L[i,j] * L[k,j]) / L[k,k]
+			float s = _values[p];
+			int a = iBegin;
+			int b = kBegin;
+			while (a < p && b < kDiag)
+			{
+				if (_columns[a] == _columns[b])
+					s -= _values[a++] * _values[b++];
+				else if (_columns[a] < _columns[b])
+					a++;
+				else
+					b++;
+			}
+
+			_values[p] = s / _values[kDiag];
+		}
+
+		// L[i,i] = sqrt(A[i,i] - sum_j<i L[i,j]^2)
+		float d = _values[iDiag];
+		for (int p = iBegin; p < iDiag; p++)
+			d -= _values[p] * _values[p];
+
+		if (d <= 0.0f)
+			throw std::runtime_error("IncompleteCholesky: Matrix is not positive definite.");
+
+		_values[iDiag] = std::sqrt(d);
+	}
+}
+
+// Returns inv(L * trans(L)) * r
+Matrix IncompleteCholesky::apply(const Matrix& r) const
+{
+	if (r.rows() != _size || r.columns() != 1)
+		throw std::invalid_argument("IncompleteCholesky: Dimension mismatch.");
+
+	std::vector<float> y(_size);
+
+	// forward substitution L * y = r
+	for (int i = 0; i < _size; i++)
+	{
+		const int iDiag = _rowStart[i + 1] - 1;
+		float s = r.at(i, 0);
+		for (int p = _rowStart[i]; p < iDiag; p++)
+			s -= _values[p] * y[_columns[p]];
+
+		y[i] = s / _values[iDiag];
+	}
+
+	// back substitution trans(L) * z = y (column oriented over rows of L)
+	for (int i = _size - 1; i >= 0; i--)
+	{
+		const int iDiag = _rowStart[i + 1] - 1;
+		const float z = y[i] / _values[iDiag];
+		y[i] = z;
+
+		for (int p = _rowStart[i]; p < iDiag; p++)
+			y[_columns[p]] -= _values[p] * z;
+	}
+
+	return Matrix(y);
+}
@@ -0,0 +1,61 @@
+#ifndef _PRECONDITIONER_H_
+#define _PRECONDITIONER_H_
+
+#include "../Matrix.h"
+#include <vector>
+
+// Abstract preconditioner z = inv(M) * r for iterative solvers.
+class Preconditioner
+{
+public:
+	virtual ~Preconditioner() {}
+
+	// Applies inverse of the preconditioner to column vector [r].
+	virtual Matrix apply(const Matrix& r) const = 0;
+};
+
+// Implements diagonal (Jacobi) preconditioner M = diag(A).
+class JacobiPreconditioner : public Preconditioner
+{
+private:
+	Matrix _invDiag;
+
+public:
+	// Creates preconditioner from square matrix (uses its diagonal) or from column vector holding the diagonal.
+	JacobiPreconditioner(const Matrix& mat);
+
+	// Returns inv(diag(A)) .* r
+	virtual Matrix apply(const Matrix& r) const;
+};
+
+// Implements incomplete Cholesky factorization with zero fill-in, M = L * trans(L).
+// Sparsity pattern of L follows nonzero elements of the lower triangle of A. Sparse matrices are factorized from
+// compressed sparse rows without forming the dense matrix (memory and time depend on the nonzeros only).
+class IncompleteCholesky : public Preconditioner
+{
+private:
+	int _size;
+	std::vector<float> _values;		// lower triangle row by row, diagonal is last in each row
+	std::vector<int> _columns;		// column index of each value
+	std::vector<int> _rowStart;		// index of the first value in each row (size + 1 items)
+
+	// Factorizes lower triangle stored in _values in place
+	void _factorize();
+
+public:
+	// Factorizes given symmetric positive definite matrix.
+	IncompleteCholesky(const Matrix& mat);
+
+	// Factorizes symmetric positive definite matrix of given size stored in compressed sparse rows: row r has
+	// [values] with column indices [columns] at positions rowStart[r] to rowStart[r + 1] - 1 (in any order,
+	// duplicates are summed, stored zeros are part of the pattern). Only the lower triangle is used, so the upper
+	// one may be omitted.
+	// Throws std::invalid_argument for invalid arrays.
+	IncompleteCholesky(int size, const std::vector<int>& rowStart, const std::vector<int>& columns,
+		const std::vector<float>& values);
+
+	// Returns inv(L * trans(L)) * r
+	virtual Matrix apply(const Matrix& r) const;
+};
+
+#endif // _PRECONDITIONER_H_
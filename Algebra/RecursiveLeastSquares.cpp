@@ -0,0 +1,74 @@
+#include "RecursiveLeastSquares.h"
+#include <stdexcept>
+
+// Creates estimator with given number of inputs and outputs.
+// Initial inverse correlation is [delta] * I (large value means weak prior).
+RecursiveLeastSquares::RecursiveLeastSquares(int inputs, int outputs, float delta)
+	: _weights(outputs, inputs), _P(), _samples(0), forgetting(1.0f)
+{
+	reset(delta);
+}
+
+// Resets parameters to zero and inverse correlation to [delta] * I.
+void RecursiveLeastSquares::reset(float delta)
+{
+	_weights.clear();
+	_P = Matrix::eye(_weights.columns()) * delta;
+	_samples = 0;
+}
+
+// Updates the model by one observation (column vectors [x] and [y]). Returns prediction error before the update.
+Matrix RecursiveLeastSquares::update(const Matrix& x, const Matrix& y)
+{
+	if (x.rows() != _weights.columns() || y.rows() != _weights.rows() || x.columns() != 1 || y.columns() != 1)
+		throw std::invalid_argument("RecursiveLeastSquares: Dimension mismatch.");
+
+	// gain k = P x / (lambda + x' P x)
+	Matrix Px = _P * x;
+	const float denom = forgetting + (float)(x.t() * Px);
+	Matrix k = Px / denom;
+
+	// W = W + e k'
+	Matrix err = y - _weights * x;
+	_weights += err * k.t();
+
+	// P = (P - k x' P) / lambda, P is symmetric so x' P = trans(P x)
+	_P -= k * Px.t();
+	if (forgetting != 1.0f)
+		_P /= forgetting;
+
+	_samples++;
+	return err;
+}
+
+// Updates the model by block of k observations stored in columns of [X] (inputs x k) and [Y] (outputs x k).
+// Uses Woodbury identity, costs O(n^2 k + k^3).
+void RecursiveLeastSquares::updateBlock(const Matrix& X, const Matrix& Y)
+{
+	if (X.rows() != _weights.columns() || Y.rows() != _weights.rows() || X.columns() != Y.columns())
+		throw std::invalid_argument("RecursiveLeastSquares: Dimension mismatch.");
+
+	const int k = X.columns();
+
+	// gain K = P X inv(L + X' P X), L = diag(lambda^(j+1)), i.e. observation j weighted by lambda^(k-1-j)
+	// relative to prior divided by lambda^k (same as k sequential updates)
+	Matrix PX = _P * X;
+	Matrix S = X.t() * PX;
+	float decay = 1.0f;
+	for (int j = 0; j < k; j++)
+	{
+		decay *= forgetting;
+		S.at(j, j) += decay;
+	}
+	Matrix K = PX * S.inv();
+
+	// W = W + (Y - W X) K'
+	_weights += (Y - _weights * X) * K.t();
+
+	// P = (P - K X' P) / lambda^k
+	_P -= K * PX.t();
+	if (forgetting != 1.0f)
+		_P /= decay;
+
+	_samples += k;
+}
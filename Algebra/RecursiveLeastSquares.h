@@ -0,0 +1,47 @@
+#ifndef _RECURSIVE_LEAST_SQUARES_H_
+#define _RECURSIVE_LEAST_SQUARES_H_
+
+#include "../Matrix.h"
+
+// Implements recursive least squares estimator of linear model y = W * x with exponential forgetting.
+// Each update costs O(n^2) in the number of inputs instead of re-solving normal equations in O(n^3).
+class RecursiveLeastSquares
+{
+private:
+	Matrix _weights;	// model parameters (outputs x inputs)
+	Matrix _P;			// inverse of the (weighted) input correlation matrix
+	int _samples;
+
+public:
+	// Creates estimator with given number of inputs and outputs.
+	// Initial inverse correlation is [delta] * I (large value means weak prior).
+	RecursiveLeastSquares(int inputs, int outputs = 1, float delta = 1000.0f);
+
+	// Resets parameters to zero and inverse correlation to [delta] * I.
+	void reset(float delta = 1000.0f);
+
+	// Updates the model by one observation (column vectors [x] and [y]). Returns prediction error before the update.
+	Matrix update(const Matrix& x, const Matrix& y);
+
+	// Updates the model by block of k observations stored in columns of [X] (inputs x k) and [Y] (outputs x k).
+	// Uses Woodbury identity, costs O(n^2 k + k^3). Equivalent to k calls of update() in column order (up to rounding):
+	// observation j is weighted by forgetting^(k-1-j) and inverse correlation is divided by forgetting^k.
+	void updateBlock(const Matrix& X, const Matrix& Y);
+
+	// Returns prediction W * x for given input(s).
+	Matrix predict(const Matrix& x) const { return _weights * x; }
+
+	// Returns model parameters (outputs x inputs).
+	const Matrix& weights() const { return _weights; }
+
+	// Returns inverse correlation matrix (proportional to parameter covariance).
+	const Matrix& covariance() const { return _P; }
+
+	// Returns number of processed observations.
+	int samples() const { return _samples; }
+
+	// Forgetting factor in (0, 1]. Value 1 means no forgetting. Default value is 1
+	float forgetting;
+};
+
+#endif // _RECURSIVE_LEAST_SQUARES_H_
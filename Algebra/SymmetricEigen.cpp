@@ -0,0 +1,527 @@
+#include "SymmetricEigen.h"
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <cmath>
+#include <stdexcept>
+
+// Reduces symmetric matrix [a] (n x n, row by row, full storage) to tridiagonal form T = trans(Q) * A * Q.
+// Diagonal is stored in [d], subdiagonal in [e] (e[i] couples d[i] and d[i+1]).
+// Householder vectors are left in columns of [a] bellow subdiagonal, their coefficients in [beta].
+static void tridiagonalize(std::vector<double>& a, int n, std::vector<double>& d, std::vector<double>& e, std::vector<double>& beta)
+{
+	std::vector<double> p(n);
+
+	for (int k = 0; k < n - 2; k++)
+	{
+		const int m = n - k - 1; // length of reflected part
+		double* col = &a[(k + 1) * n + k];
+
+		// norm of the column bellow diagonal
+		double sigma = 0.0;
+		for (int i = 0; i < m; i++)
+			sigma += col[i * n] * col[i * n];
+
+		const double x0 = col[0];
+		if (sigma - x0 * x0 <= 0.0)
+		{
+			// already tridiagonal in this column
+			beta[k] = 0.0;
+			e[k] = x0;
+			continue;
+		}
+
+		const double norm = std::sqrt(sigma);
+		const double alpha = (x0 >= 0.0) ? -norm : norm;
+
+		// v = x - alpha * e1, beta = 2 / (v' * v)
+		col[0] = x0 - alpha;
+		beta[k] = 1.0 / (norm * (norm + std::abs(x0)));
+		e[k] = alpha;
+
+		// p = beta * A22 * v
+		double* a22 = &a[(k + 1) * n + (k + 1)];
+		for (int i = 0; i < m; i++)
+		{
+			const double* row = a22 + i * n;
+			double s = 0.0;
+			for (int j = 0; j < m; j++)
+				s += row[j] * col[j * n];
+
+			p[i] = beta[k] * s;
+		}
+
+		// w = p - (beta / 2 * p' * v) * v
+		double pv = 0.0;
+		for (int i = 0; i < m; i++)
+			pv += p[i] * col[i * n];
+
+		const double coef = 0.5 * beta[k] * pv;
+		for (int i = 0; i < m; i++)
+			p[i] -= coef * col[i * n];
+
+		// A22 = A22 - v * w' - w * v'
+		for (int i = 0; i < m; i++)
+		{
+			double* row = a22 + i * n;
+			const double vi = col[i * n];
+			const double wi = p[i];
+			for (int j = 0; j < m; j++)
+				row[j] -= vi * p[j] + wi * col[j * n];
+		}
+	}
+
+	for (int k = 0; k < n; k++)
+		d[k] = a[k * n + k];
+
+	if (n >= 2)
+		e[n - 2] = a[(n - 1) * n + (n - 2)];
+
+	if (n >= 1)
+		e[n - 1] = 0.0;
+}
+
+// Applies Q = H(0) * H(1) * ... * H(n-3) to matrix [z] (n x cols, row by row), i.e. z = Q * z.
+static void applyReflectors(const std::vector<double>& a, int n, const std::vector<double>& beta, std::vector<double>& z, int cols)
+{
+	std::vector<double> s(cols);
+
+	for (int k = n - 3; k >= 0; k--)
+	{
+		if (beta[k] == 0.0)
+			continue;
+
+		const int m = n - k - 1;
+		const double* col = &a[(k + 1) * n + k];
+		double* zk = &z[(k + 1) * cols];
+
+		// s = beta * trans(v) * Z
+		std::fill(s.begin(), s.end(), 0.0);
+		for (int i = 0; i < m; i++)
+		{
+			const double vi = col[i * n];
+			const double* row = zk + i * cols;
+			for (int j = 0; j < cols; j++)
+				s[j] += vi * row[j];
+		}
+
+		for (int j = 0; j < cols; j++)
+			s[j] *= beta[k];
+
+		// Z = Z - v * s
+		for (int i = 0; i < m; i++)
+		{
+			const double vi = col[i * n];
+			double* row = zk + i * cols;
+			for (int j = 0; j < cols; j++)
+				row[j] -= vi * s[j];
+		}
+	}
+}
+
+// Finds eigenvalues of symmetric tridiagonal matrix [d, e] by implicit QL iteration with Wilkinson shifts.
+// When [zt] is not NULL, rotations are accumulated into its rows (each row is one eigenvector).
+static void tridiagonalQL(std::vector<double>& d, std::vector<double>& e, int n, double* zt)
+{
+	const double eps = std::numeric_limits<double>::epsilon();
+
+	for (int l = 0; l < n; l++)
+	{
+		int iter = 0;
+		int m;
+
+		do
+		{
+			// find small subdiagonal element
+			for (m = l; m < n - 1; m++)
+			{
+				const double dd = std::abs(d[m]) + std::abs(d[m + 1]);
+				if (std::abs(e[m]) <= eps * dd)
+					break;
+			}
+
+			if (m == l)
+				break;
+
+			if (iter++ == 30 * n)
+				throw std::runtime_error("SymmetricEigen: QL iteration does not converge.");
+
+			// Wilkinson shift
+			double g = (d[l + 1] - d[l]) / (2.0 * e[l]);
+			double r = std::hypot(g, 1.0);
+			g = d[m] - d[l] + e[l] / (g + ((g >= 0.0) ? r : -r));
+
+			double s = 1.0;
+			double c = 1.0;
+			double p = 0.0;
+			int i;
+
+			// chase the bulge from m to l
+			for (i = m - 1; i >= l; i--)
+			{
+				const double f = s * e[i];
+				const double b = c * e[i];
+				r = std::hypot(f, g);
+				e[i + 1] = r;
+
+				if (r == 0.0)
+				{
+					// recover from underflow
+					d[i + 1] -= p;
+					e[m] = 0.0;
+					break;
+				}
+
+				s = f / r;
+				c = g / r;
+				g = d[i + 1] - p;
+				r = (d[i] - g) * s + 2.0 * c * b;
+				p = s * r;
+				d[i + 1] = g + p;
+				g = c * r - b;
+
+				if (zt)
+				{
+					// rotate eigenvectors i and i+1
+					double* zi = zt + i * n;
+					double* zi1 = zt + (i + 1) * n;
+					for (int k = 0; k < n; k++)
+					{
+						const double x = zi1[k];
+						zi1[k] = s * zi[k] + c * x;
+						zi[k] = c * zi[k] - s * x;
+					}
+				}
+			}
+
+			if (r == 0.0 && i >= l)
+				continue;
+
+			d[l] -= p;
+			e[l] = g;
+			e[m] = 0.0;
+		} while (m != l);
+	}
+}
+
+// Returns true when subdiagonal element e[i] of tridiagonal matrix [d, e] is negligible (same test as QL iteration)
+static bool negligible(const std::vector<double>& d, const std::vector<double>& e, int i)
+{
+	const double eps = std::numeric_limits<double>::epsilon();
+	return std::abs(e[i]) <= eps * (std::abs(d[i]) + std::abs(d[i + 1]));
+}
+
+// Computes eigenvector of unreduced block [first, last) of tridiagonal matrix [d, e] for eigenvalue [lambda] by
+// inverse iteration. Result [x] (n elements, zero outside the block) is orthogonalized against all previous vectors
+// of the block (rows [prevRows] of [prev]), so vectors of repeated or close eigenvalues stay orthogonal.
+// Iterates until the residual is small and starts again from a new random vector when the iteration collapses.
+static void inverseIteration(const std::vector<double>& d, const std::vector<double>& e, int n, int first, int last,
+	double lambda, double tnorm, const std::vector<double>& prev, const std::vector<int>& prevRows, std::mt19937& random,
+	std::vector<double>& x)
+{
+	static const int maxIterations = 5;
+	static const int maxAttempts = 8;
+
+	const double eps = std::numeric_limits<double>::epsilon();
+	const double tiny = eps * tnorm + std::numeric_limits<double>::min();
+	const int m = last - first;
+	const double tol = 10.0 * m * eps * tnorm;
+	const double* dd = &d[first];
+	const double* ee = &e[first];
+
+	x.assign(n, 0.0);
+	if (m == 1)
+	{
+		x[first] = 1.0;
+		return;
+	}
+
+	// LU factorization of (T - lambda * I) with partial pivoting
+	std::vector<double> u1(m), u2(m), u3(m), l(m);
+	std::vector<char> piv(m);
+
+	u1[0] = dd[0] - lambda;
+	u2[0] = ee[0];
+	u3[0] = 0.0;
+
+	for (int i = 0; i < m - 1; i++)
+	{
+		const double sub = ee[i];
+		const double diag = dd[i + 1] - lambda;
+		const double sup = (i + 1 < m - 1) ? ee[i + 1] : 0.0;
+
+		if (std::abs(u1[i]) >= std::abs(sub))
+		{
+			const double f = (u1[i] != 0.0) ? sub / u1[i] : 0.0;
+			piv[i] = 0;
+			l[i] = f;
+			u1[i + 1] = diag - f * u2[i];
+			u2[i + 1] = sup;
+		}
+		else
+		{
+			const double f = u1[i] / sub;
+			piv[i] = 1;
+			l[i] = f;
+			u1[i + 1] = u2[i] - f * diag;
+			u2[i + 1] = -f * sup;
+			u1[i] = sub;
+			u2[i] = diag;
+			u3[i] = sup;
+		}
+
+		u3[i + 1] = 0.0;
+	}
+
+	for (int i = 0; i < m; i++)
+		if (std::abs(u1[i]) < tiny)
+			u1[i] = (u1[i] >= 0.0) ? tiny : -tiny;
+
+	std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+	std::vector<double> v(m);
+	for (int attempt = 0; attempt < maxAttempts; attempt++)
+	{
+		// random start vector (deterministic sequence)
+		for (int i = 0; i < m; i++)
+			v[i] = uniform(random);
+
+		bool collapsed = false;
+		for (int iter = 0; iter < maxIterations; iter++)
+		{
+			// forward substitution
+			for (int i = 0; i < m - 1; i++)
+			{
+				if (piv[i])
+					std::swap(v[i], v[i + 1]);
+
+				v[i + 1] -= l[i] * v[i];
+			}
+
+			// back substitution
+			for (int i = m - 1; i >= 0; i--)
+			{
+				double s = v[i];
+				if (i + 1 < m) s -= u2[i] * v[i + 1];
+				if (i + 2 < m) s -= u3[i] * v[i + 2];
+				v[i] = s / u1[i];
+			}
+
+			// orthogonalize against previous vectors of the block (twice, to remove rounding of the first pass)
+			for (int pass = 0; pass < 2; pass++)
+			{
+				for (unsigned j = 0; j < prevRows.size(); j++)
+				{
+					const double* p = &prev[(size_t)prevRows[j] * n + first];
+					double dot = 0.0;
+					for (int i = 0; i < m; i++)
+						dot += p[i] * v[i];
+
+					for (int i = 0; i < m; i++)
+						v[i] -= dot * p[i];
+				}
+			}
+
+			// normalize
+			double norm = 0.0;
+			for (int i = 0; i < m; i++)
+				norm += v[i] * v[i];
+
+			norm = std::sqrt(norm);
+			if (!(norm > 0.0) || !std::isfinite(norm))
+			{
+				collapsed = true;
+				break;
+			}
+
+			for (int i = 0; i < m; i++)
+				v[i] /= norm;
+
+			// residual |T v - lambda v|
+			double residual = 0.0;
+			for (int i = 0; i < m; i++)
+			{
+				double r = (dd[i] - lambda) * v[i];
+				if (i > 0) r += ee[i - 1] * v[i - 1];
+				if (i + 1 < m) r += ee[i] * v[i + 1];
+				residual += r * r;
+			}
+
+			if (std::sqrt(residual) <= tol)
+				break;
+		}
+
+		if (!collapsed)
+		{
+			std::copy(v.begin(), v.end(), x.begin() + first);
+			return;
+		}
+	}
+
+	throw std::runtime_error("SymmetricEigen: Inverse iteration failed.");
+}
+
+// Creates empty decomposition.
+SymmetricEigen::SymmetricEigen()
+	: _values(), _vectors() {}
+
+// Decomposes given symmetric matrix. See compute().
+SymmetricEigen::SymmetricEigen(const Matrix& mat, int count, bool computeVectors)
+	: _values(), _vectors()
+{
+	compute(mat, count, computeVectors);
+}
+
+// Decomposes given symmetric matrix. Only lower triangle of the matrix is used.
+// Keeps [count] largest eigenpairs (all if count <= 0). Eigenvectors are computed only when [computeVectors] is set.
+void SymmetricEigen::compute(const Matrix& mat, int count, bool computeVectors)
+{
+	if (mat.rows() != mat.columns())
+		throw std::invalid_argument("SymmetricEigen: Matrix is not square.");
+
+	const int n = mat.rows();
+	if (count <= 0 || count > n)
+		count = n;
+
+	_values = Matrix();
+	_vectors = Matrix();
+
+	if (n == 0)
+		return;
+
+	// copy lower triangle into symmetric working storage
+	std::vector<double> a(n * n);
+	for (int r = 0; r < n; r++)
+	{
+		for (int c = 0; c <= r; c++)
+		{
+			const double x = mat.at(r, c);
+			a[r * n + c] = x;
+			a[c * n + r] = x;
+		}
+	}
+
+	std::vector<double> d(n), e(n), beta(n);
+	tridiagonalize(a, n, d, e, beta);
+
+	// order of eigenvalues (descending)
+	std::vector<int> order(n);
+	std::vector<double> values;
+
+	if (computeVectors && count == n)
+	{
+		// all eigenpairs: accumulate Q explicitly and rotate it by QL iteration
+		std::vector<double> q(n * n, 0.0);
+		for (int i = 0; i < n; i++)
+			q[i * n + i] = 1.0;
+
+		applyReflectors(a, n, beta, q, n);
+
+		// transpose so that rows are rotated (eigenvectors in rows)
+		std::vector<double> zt(n * n);
+		for (int r = 0; r < n; r++)
+			for (int c = 0; c < n; c++)
+				zt[c * n + r] = q[r * n + c];
+
+		values = d;
+		tridiagonalQL(values, e, n, zt.data());
+
+		for (int i = 0; i < n; i++)
+			order[i] = i;
+
+		std::sort(order.begin(), order.end(), [&values](int i, int j) { return values[i] > values[j]; });
+
+		_values = Matrix(n, 1);
+		_vectors = Matrix(n, n);
+		for (int j = 0; j < n; j++)
+		{
+			_values.at(j, 0) = (float)values[order[j]];
+
+			const double* v = &zt[order[j] * n];
+			for (int r = 0; r < n; r++)
+				_vectors.at(r, j) = (float)v[r];
+		}
+
+		return;
+	}
+
+	if (!computeVectors)
+	{
+		// eigenvalues only
+		tridiagonalQL(d, e, n, NULL);
+		std::sort(d.begin(), d.end(), [](double x, double y) { return x > y; });
+
+		_values = Matrix(count, 1);
+		for (int j = 0; j < count; j++)
+			_values.at(j, 0) = (float)d[j];
+
+		return;
+	}
+
+	// top-k eigenpairs: tridiagonal matrix is split to unreduced blocks (negligible subdiagonal elements), eigenvalues
+	// of each block by QL iteration, eigenvectors by inverse iteration within the block of the eigenvalue
+	double tnorm = 0.0;
+	for (int i = 0; i < n; i++)
+		tnorm = std::max(tnorm, std::abs(d[i]) + std::abs(e[i]) + ((i > 0) ? std::abs(e[i - 1]) : 0.0));
+
+	std::vector<int> blockFirst, blockOf;	// first row of each block, block of each eigenvalue
+	std::vector<double> blockValues;
+	for (int first = 0; first < n; )
+	{
+		int last = first + 1;
+		while (last < n && !negligible(d, e, last - 1))
+			last++;
+
+		std::vector<double> db(d.begin() + first, d.begin() + last), eb(e.begin() + first, e.begin() + last);
+		eb[last - first - 1] = 0.0;
+		tridiagonalQL(db, eb, last - first, NULL);
+
+		for (int i = 0; i < last - first; i++)
+		{
+			blockValues.push_back(db[i]);
+			blockOf.push_back((int)blockFirst.size());
+		}
+
+		blockFirst.push_back(first);
+		first = last;
+	}
+	blockFirst.push_back(n);
+
+	for (int i = 0; i < n; i++)
+		order[i] = i;
+
+	std::stable_sort(order.begin(), order.end(), [&blockValues](int i, int j) { return blockValues[i] > blockValues[j]; });
+
+	std::mt19937 random(1);
+	std::vector<double> y(count * n); // eigenvectors of T, one per row
+	std::vector<double> x;
+	std::vector<int> prevRows;
+	_values = Matrix(count, 1);
+	for (int j = 0; j < count; j++)
+	{
+		const int block = blockOf[order[j]];
+		const double lambda = blockValues[order[j]];
+		_values.at(j, 0) = (float)lambda;
+
+		prevRows.clear();
+		for (int i = 0; i < j; i++)
+			if (blockOf[order[i]] == block)
+				prevRows.push_back(i);
+
+		inverseIteration(d, e, n, blockFirst[block], blockFirst[block + 1], lambda, tnorm, y, prevRows, random, x);
+		std::copy(x.begin(), x.end(), y.begin() + j * n);
+	}
+
+	// back transformation: V = Q * Y
+	std::vector<double> z(n * count);
+	for (int j = 0; j < count; j++)
+		for (int r = 0; r < n; r++)
+			z[r * count + j] = y[j * n + r];
+
+	applyReflectors(a, n, beta, z, count);
+
+	_vectors = Matrix(n, count);
+	for (int r = 0; r < n; r++)
+		for (int j = 0; j < count; j++)
+			_vectors.at(r, j) = (float)z[r * count + j];
+}
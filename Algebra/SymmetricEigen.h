@@ -0,0 +1,34 @@
+#ifndef _SYMMETRIC_EIGEN_H_
+#define _SYMMETRIC_EIGEN_H_
+
+#include "../Matrix.h"
+
+// Implements eigen decomposition of a symmetric matrix A = V * diag(values) * trans(V).
+// Matrix is reduced to tridiagonal form by Householder reflections, eigenvalues are found by implicit QL iteration.
+// When only top-k eigenpairs are requested, tridiagonal matrix is split to unreduced blocks and eigenvectors are
+// computed by inverse iteration within the block of each eigenvalue (orthogonal also for repeated eigenvalues).
+class SymmetricEigen
+{
+private:
+	Matrix _values;		// eigenvalues (column vector) in descending order
+	Matrix _vectors;	// eigenvectors stored in columns
+
+public:
+	// Creates empty decomposition.
+	SymmetricEigen();
+
+	// Decomposes given symmetric matrix. See compute().
+	SymmetricEigen(const Matrix& mat, int count = 0, bool computeVectors = true);
+
+	// Decomposes given symmetric matrix. Only lower triangle of the matrix is used.
+	// Keeps [count] largest eigenpairs (all if count <= 0). Eigenvectors are computed only when [computeVectors] is set.
+	void compute(const Matrix& mat, int count = 0, bool computeVectors = true);
+
+	// Returns eigenvalues in descending order (column vector).
+	const Matrix& values() const { return _values; }
+
+	// Returns eigenvectors (one per column) ordered as eigenvalues. Empty if not computed.
+	const Matrix& vectors() const { return _vectors; }
+};
+
+#endif // _SYMMETRIC_EIGEN_H_
@@ -0,0 +1,96 @@
+#include "SymmetricMatrix.h"
+#include <stdexcept>
+
+// Creates empty matrix.
+SymmetricMatrix::SymmetricMatrix()
+	: _size(0), _data() {}
+
+// Creates symmetric matrix of given size. Elements are set to zero.
+SymmetricMatrix::SymmetricMatrix(int size)
+	: _size(size), _data(size * (size + 1) / 2, 0.0f) {}
+
+// Creates symmetric matrix from lower triangle of given square matrix.
+SymmetricMatrix::SymmetricMatrix(const Matrix& mat)
+	: SymmetricMatrix(mat.rows())
+{
+	if (mat.rows() != mat.columns())
+		throw std::invalid_argument("SymmetricMatrix: Matrix is not square.");
+
+	float* dst = _data.data();
+	for (int r = 0; r < _size; r++)
+		for (int c = 0; c <= r; c++)
+			(*dst++) = mat.at(r, c);
+}
+
+// Computes M * trans(M) (e.g. scatter matrix of samples stored in columns). Use M.t() for trans(M) * M.
+SymmetricMatrix SymmetricMatrix::product(const Matrix& mat)
+{
+	// only lower triangle of the product is computed, directly to the packed storage
+	SymmetricMatrix res(mat.rows());
+	Matrix::syrkPacked(mat, res._data.data());
+	return res;
+}
+
+// Converts to full (dense) matrix.
+Matrix SymmetricMatrix::toMatrix() const
+{
+	Matrix res(_size, _size);
+	for (int r = 0; r < _size; r++)
+		for (int c = 0; c < _size; c++)
+			res.at(r, c) = this->at(r, c);
+
+	return res;
+}
+
+// Multiplies S * B.
+Matrix SymmetricMatrix::operator * (const Matrix& matB) const
+{
+	if (matB.rows() != _size)
+		throw std::invalid_argument("SymmetricMatrix: Dimension mismatch.");
+
+	const int n = _size;
+	const int m = matB.columns();
+	if (n == 0 || m == 0)
+		return Matrix();
+
+	std::vector<float> b(n * m);
+	for (int r = 0; r < n; r++)
+		for (int c = 0; c < m; c++)
+			b[r * m + c] = matB.at(r, c);
+
+	// each stored element S[r,k] (k < r) contributes to rows r and k
+	std::vector<float> y(n * m, 0.0f);
+	const float* s = _data.data();
+	for (int r = 0; r < n; r++)
+	{
+		float* yr = &y[r * m];
+		const float* br = &b[r * m];
+
+		for (int k = 0; k < r; k++)
+		{
+			const float coef = *s++;
+			float* yk = &y[k * m];
+			const float* bk = &b[k * m];
+			for (int j = 0; j < m; j++)
+			{
+				yr[j] += coef * bk[j];
+				yk[j] += coef * br[j];
+			}
+		}
+
+		const float d = *s++;
+		for (int j = 0; j < m; j++)
+			yr[j] += d * br[j];
+	}
+
+	return Matrix(y).reshape(n, m);
+}
+
+// Multiplies all elements by scalar.
+const SymmetricMatrix& SymmetricMatrix::operator *= (float val)
+{
+	for (unsigned i = 0; i < _data.size(); i++)
+		_data[i] *= val;
+
+	return (*this);
+}
@@ -0,0 +1,50 @@
+#ifndef _SYMMETRIC_MATRIX_H_
+#define _SYMMETRIC_MATRIX_H_
+
+#include "../Matrix.h"
+#include <vector>
+
+// Implements symmetric matrix in packed storage. Only lower triangle (n * (n + 1) / 2 elements) is stored row by row.
+class SymmetricMatrix
+{
+private:
+	int _size;
+	std::vector<float> _data;
+
+	// Returns index of the element within packed storage.
+	int _index(int row, int col) const { return (col <= row) ? (row * (row + 1) / 2 + col) : (col * (col + 1) / 2 + row); }
+
+public:
+	// Creates empty matrix.
+	SymmetricMatrix();
+
+	// Creates symmetric matrix of given size. Elements are set to zero.
+	SymmetricMatrix(int size);
+
+	// Creates symmetric matrix from lower triangle of given square matrix.
+	SymmetricMatrix(const Matrix& mat);
+
+	// Computes M * trans(M) (e.g. scatter matrix of samples stored in columns). Use M.t() for trans(M) * M.
+	static SymmetricMatrix product(const Matrix& mat);
+
+	// Returns number of rows (and columns).
+	int size() const { return _size; }
+
+	// Returns number of stored elements.
+	int count() const { return (int)_data.size(); }
+
+	// Element access (both [row, col] and [col, row] refer to the same element).
+	float at(int row, int col) const { return _data[_index(row, col)]; }
+	float& at(int row, int col) { return _data[_index(row, col)]; }
+
+	// Converts to full (dense) matrix.
+	Matrix toMatrix() const;
+
+	// Multiplies S * B.
+	Matrix operator * (const Matrix& matB) const;
+
+	// Multiplies all elements by scalar.
+	const SymmetricMatrix& operator *= (float val);
+};
+
+#endif // _SYMMETRIC_MATRIX_H_
@@ -0,0 +1,146 @@
+#include "TriangularMatrix.h"
+#include <stdexcept>
+
+// Creates empty matrix.
+TriangularMatrix::TriangularMatrix()
+	: _size(0), _upper(false), _data() {}
+
+// Creates lower (or upper) triangular matrix of given size. Elements are set to zero.
+TriangularMatrix::TriangularMatrix(int size, bool upper)
+	: _size(size), _upper(upper), _data(size * (size + 1) / 2, 0.0f) {}
+
+// Creates triangular matrix from lower (or upper) triangle of given square matrix.
+TriangularMatrix::TriangularMatrix(const Matrix& mat, bool upper)
+	: TriangularMatrix(mat.rows(), upper)
+{
+	if (mat.rows() != mat.columns())
+		throw std::invalid_argument("TriangularMatrix: Matrix is not square.");
+
+	float* dst = _data.data();
+	for (int r = 0; r < _size; r++)
+	{
+		const int cBegin = _upper ? r : 0;
+		const int cEnd = _upper ? _size : r + 1;
+		for (int c = cBegin; c < cEnd; c++)
+			(*dst++) = mat.at(r, c);
+	}
+}
+
+// Returns transposed matrix (lower becomes upper and vice versa).
+TriangularMatrix TriangularMatrix::t() const
+{
+	TriangularMatrix res(_size, !_upper);
+
+	for (int r = 0; r < _size; r++)
+	{
+		const int cBegin = _upper ? r : 0;
+		const int cEnd = _upper ? _size : r + 1;
+		for (int c = cBegin; c < cEnd; c++)
+			res.at(c, r) = this->at(r, c);
+	}
+
+	return res;
+}
+
+// Converts to full (dense) matrix.
+Matrix TriangularMatrix::toMatrix() const
+{
+	Matrix res(_size, _size);
+	for (int r = 0; r < _size; r++)
+		for (int c = 0; c < _size; c++)
+			res.at(r, c) = this->at(r, c);
+
+	return res;
+}
+
+// Solves T * X = B. When [unitDiag] is set, diagonal is assumed to be ones.
+Matrix TriangularMatrix::solve(const Matrix& matB, bool unitDiag) const
+{
+	if (matB.rows() != _size)
+		throw std::invalid_argument("TriangularMatrix: Dimension mismatch.");
+
+	const int n = _size;
+	const int m = matB.columns();
+	if (n == 0 || m == 0)
+		return Matrix();
+
+	// X = B (row by row)
+	std::vector<float> x(n * m);
+	for (int r = 0; r < n; r++)
+		for (int c = 0; c < m; c++)
+			x[r * m + c] = matB.at(r, c);
+
+	for (int i = 0; i < n; i++)
+	{
+		const int r = _upper ? n - 1 - i : i;
+		const float* row = &_data[_index(r, _upper ? r : 0)];
+		float* xr = &x[r * m];
+
+		// packed row holds T[r, 0..r] (lower) or T[r, r..n-1] (upper)
+		const int kBegin = _upper ? r + 1 : 0;
+		const int kEnd = _upper ? n : r;
+		const float* t = _upper ? row + 1 : row;
+		for (int k = kBegin; k < kEnd; k++)
+		{
+			const float coef = *t++;
+			if (coef == 0.0f)
+				continue;
+
+			const float* xk = &x[k * m];
+			for (int j = 0; j < m; j++)
+				xr[j] -= coef * xk[j];
+		}
+
+		if (!unitDiag)
+		{
+			const float d = _upper ? row[0] : row[r];
+			if (d == 0.0f)
+				throw std::runtime_error("TriangularMatrix: Matrix is singular.");
+
+			const float coef = 1.0f / d;
+			for (int j = 0; j < m; j++)
+				xr[j] *= coef;
+		}
+	}
+
+	return Matrix(x).reshape(n, m);
+}
+
+// Multiplies T * B.
+Matrix TriangularMatrix::operator * (const Matrix& matB) const
+{
+	if (matB.rows() != _size)
+		throw std::invalid_argument("TriangularMatrix: Dimension mismatch.");
+
+	const int n = _size;
+	const int m = matB.columns();
+	if (n == 0 || m == 0)
+		return Matrix();
+
+	std::vector<float> b(n * m);
+	for (int r = 0; r < n; r++)
+		for (int c = 0; c < m; c++)
+			b[r * m + c] = matB.at(r, c);
+
+	std::vector<float> y(n * m, 0.0f);
+	for (int r = 0; r < n; r++)
+	{
+		const int kBegin = _upper ? r : 0;
+		const int kEnd = _upper ? n : r + 1;
+		const float* t = &_data[_index(r, kBegin)];
+		float* yr = &y[r * m];
+
+		for (int k = kBegin; k < kEnd; k++)
+		{
+			const float coef = *t++;
+			if (coef == 0.0f)
+				continue;
+
+			const float* bk = &b[k * m];
+			for (int j = 0; j < m; j++)
+				yr[j] += coef * bk[j];
+		}
+	}
+
+	return Matrix(y).reshape(n, m);
+}
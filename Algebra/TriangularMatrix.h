@@ -0,0 +1,59 @@
+#ifndef _TRIANGULAR_MATRIX_H_
+#define _TRIANGULAR_MATRIX_H_
+
+#include "../Matrix.h"
+#include <vector>
+
+// Implements square triangular matrix in packed storage. Only n * (n + 1) / 2 elements of the triangle are stored row by row.
+class TriangularMatrix
+{
+private:
+	int _size;
+	bool _upper;
+	std::vector<float> _data;
+
+	// Returns index of the element within packed storage. Element has to be in the triangle.
+	int _index(int row, int col) const { return _upper ? (row * _size - row * (row - 1) / 2 + col - row) : (row * (row + 1) / 2 + col); }
+
+	// Returns true when element is within stored triangle.
+	bool _inside(int row, int col) const { return _upper ? (col >= row) : (col <= row); }
+
+public:
+	// Creates empty matrix.
+	TriangularMatrix();
+
+	// Creates lower (or upper) triangular matrix of given size. Elements are set to zero.
+	TriangularMatrix(int size, bool upper = false);
+
+	// Creates triangular matrix from lower (or upper) triangle of given square matrix.
+	TriangularMatrix(const Matrix& mat, bool upper = false);
+
+	// Returns number of rows (and columns).
+	int size() const { return _size; }
+
+	// Returns true for upper triangular matrix.
+	bool upper() const { return _upper; }
+
+	// Returns number of stored elements.
+	int count() const { return (int)_data.size(); }
+
+	// Element access. Elements outside of the triangle are zero.
+	float at(int row, int col) const { return _inside(row, col) ? _data[_index(row, col)] : 0.0f; }
+
+	// Element access. UNSAFE, element has to be within the triangle.
+	float& at(int row, int col) { return _data[_index(row, col)]; }
+
+	// Returns transposed matrix (lower becomes upper and vice versa).
+	TriangularMatrix t() const;
+
+	// Converts to full (dense) matrix.
+	Matrix toMatrix() const;
+
+	// Solves T * X = B. When [unitDiag] is set, diagonal is assumed to be ones.
+	Matrix solve(const Matrix& matB, bool unitDiag = false) const;
+
+	// Multiplies T * B.
+	Matrix operator * (const Matrix& matB) const;
+};
+
+#endif // _TRIANGULAR_MATRIX_H_
@@ -0,0 +1,162 @@
+#include "Batcher.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+// Queued requests and the worker thread
+struct Batcher::Queue
+{
+	// Single sample waiting for processing
+	struct Request
+	{
+		std::vector<float> input;
+		std::promise<std::vector<float>> result;
+		std::chrono::steady_clock::time_point arrival;
+	};
+
+	std::thread worker;
+	std::mutex lock;
+	std::condition_variable wake;		// request is queued, batch is full or batcher stops
+	std::deque<Request> pending;
+	bool stop;
+	long long batches;
+	long long requests;
+};
+
+// Creates batcher of given network and starts its worker thread.
+Batcher::Batcher(Net& net, int maxBatch, int maxDelay)
+	: _net(net), _maxBatch(maxBatch), _maxDelay(maxDelay), _queue(NULL)
+{
+	if (_net.layers().empty())
+		throw std::invalid_argument("Batcher: Network has no layers.");
+	if (_maxBatch <= 0 || _maxDelay < 0)
+		throw std::invalid_argument("Batcher: Invalid batch size or delay.");
+
+	_queue = new Queue();
+	_queue->stop = false;
+	_queue->batches = 0;
+	_queue->requests = 0;
+	_queue->worker = std::thread([this]() { _run(); });
+}
+
+// Processes all queued requests and stops the worker thread.
+Batcher::~Batcher()
+{
+	{
+		std::lock_guard<std::mutex> guard(_queue->lock);
+		_queue->stop = true;
+	}
+	_queue->wake.notify_all();
+
+	_queue->worker.join();
+	delete _queue;
+}
+
+// Queues input of a single sample.
+std::future<std::vector<float>> Batcher::submit(const std::vector<float>& input)
+{
+	if ((int)input.size() != _net.layers()[0]->size())
+		throw std::invalid_argument("Batcher: Input size does not match the network.");
+
+	Queue::Request request;
+	request.input = input;
+	request.arrival = std::chrono::steady_clock::now();
+	std::future<std::vector<float>> result = request.result.get_future();
+
+	bool notify;
+	{
+		std::lock_guard<std::mutex> guard(_queue->lock);
+		_queue->pending.push_back(std::move(request));
+
+		// worker waits either for the first request or for a full batch
+		const int size = (int)_queue->pending.size();
+		notify = (size == 1 || size == _maxBatch);
+	}
+	if (notify)
+		_queue->wake.notify_one();
+
+	return result;
+}
+
+// Processes batches until stopped (worker thread)
+void Batcher::_run()
+{
+	std::vector<Queue::Request> batch;
+	std::unique_lock<std::mutex> guard(_queue->lock);
+	while (true)
+	{
+		_queue->wake.wait(guard, [&]() { return _queue->stop || !_queue->pending.empty(); });
+		if (_queue->pending.empty())
+			return; // stopped and all requests processed
+
+		// wait for a full batch until the oldest request has waited long enough
+		const std::chrono::steady_clock::time_point deadline =
+			_queue->pending.front().arrival + std::chrono::microseconds(_maxDelay);
+		_queue->wake.wait_until(guard, deadline,
+			[&]() { return _queue->stop || (int)_queue->pending.size() >= _maxBatch; });
+
+		const int count = std::min((int)_queue->pending.size(), _maxBatch);
+		for (int i = 0; i < count; i++)
+		{
+			batch.push_back(std::move(_queue->pending.front()));
+			_queue->pending.pop_front();
+		}
+		guard.unlock();
+
+		// one forward pass, sample per column
+		std::exception_ptr error;
+		try
+		{
+			const int inputs = _net.layers()[0]->size();
+			Matrix in(inputs, count);
+			for (int c = 0; c < count; c++)
+				for (int r = 0; r < inputs; r++)
+					in.at(r, c) = batch[c].input[r];
+
+			_net.processInput(in);
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+
+		const Matrix& out = _net.output();
+		for (int c = 0; c < count; c++)
+		{
+			if (error)
+			{
+				batch[c].result.set_exception(error);
+				continue;
+			}
+
+			std::vector<float> res(out.rows());
+			for (int r = 0; r < out.rows(); r++)
+				res[r] = out.at(r, c);
+			batch[c].result.set_value(std::move(res));
+		}
+		batch.clear();
+
+		guard.lock();
+		_queue->batches++;
+		_queue->requests += count;
+	}
+}
+
+// Returns number of processed batches
+long long Batcher::batches() const
+{
+	std::lock_guard<std::mutex> guard(_queue->lock);
+	return _queue->batches;
+}
+
+// Returns number of processed requests
+long long Batcher::requests() const
+{
+	std::lock_guard<std::mutex> guard(_queue->lock);
+	return _queue->requests;
+}
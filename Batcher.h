@@ -0,0 +1,55 @@
+#ifndef _BATCHER_H_
+#define _BATCHER_H_
+
+#include "Net.h"
+#include <future>
+#include <vector>
+
+// Dynamic batcher of single-sample inference requests. Requests submitted by any number of threads are queued
+// and coalesced into batches (one sample per column), each batch is processed by a single forward pass of the
+// network on a worker thread, results complete futures of the callers.
+// A batch is processed when it has [maxBatch] requests or when its oldest request has waited [maxDelay]
+// microseconds, whichever comes first. Larger batches give higher throughput, shorter delay lower latency
+// at low load (maxBatch 1 processes each request alone).
+// The network is used only by the worker thread, do not use it elsewhere while the batcher exists.
+class Batcher
+{
+private:
+	struct Queue;
+
+	Net& _net;
+	int _maxBatch;
+	int _maxDelay;
+	Queue* _queue;			// requests and worker thread
+
+	// Processes batches until stopped (worker thread)
+	void _run();
+
+public:
+	// Creates batcher of given network and starts its worker thread.
+	Batcher(Net& net, int maxBatch = 32, int maxDelay = 1000);
+
+	// Processes all queued requests and stops the worker thread.
+	~Batcher();
+
+	// Returns maximal number of requests per batch
+	int maxBatch() const { return _maxBatch; }
+
+	// Returns maximal wait of a request for other requests (microseconds)
+	int maxDelay() const { return _maxDelay; }
+
+	// Queues input of a single sample. Returned future receives output of the network or the exception thrown
+	// by the forward pass. Throws std::invalid_argument when size of the input does not match the network.
+	std::future<std::vector<float>> submit(const std::vector<float>& input);
+
+	// Processes input of a single sample and waits for the result.
+	std::vector<float> process(const std::vector<float>& input) { return submit(input).get(); }
+
+	// Returns number of processed batches
+	long long batches() const;
+
+	// Returns number of processed requests
+	long long requests() const;
+};
+
+#endif // _BATCHER_H_
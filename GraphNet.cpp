@@ -0,0 +1,526 @@
+#include "GraphNet.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+
+// Pool of threads running nodes whose dependencies are finished
+struct GraphNet::Scheduler
+{
+	GraphNet* graph;
+	std::vector<std::thread> threads;
+	std::mutex lock;
+	std::condition_variable wake;		// work is available, pass is finished or pool stops
+
+	std::vector<int> ready;				// nodes ready to run
+	std::vector<int> pending;			// number of unfinished dependencies of each node
+	int remaining;						// number of unfinished nodes of the pass
+	bool backward;						// direction of the pass
+	bool stop;
+	std::exception_ptr error;			// first error of the pass
+
+	// Runs ready nodes until the pass is finished (caller) or the pool stops (workers)
+	void work(bool caller)
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		while (true)
+		{
+			wake.wait(guard, [&]() { return stop || !ready.empty() || (caller && remaining == 0); });
+			if (stop || (caller && remaining == 0))
+				return;
+
+			const int node = ready.back();
+			ready.pop_back();
+
+			// run without the lock, skip remaining nodes after an error
+			if (!error)
+			{
+				guard.unlock();
+				try
+				{
+					if (backward)
+						graph->_backward(node);
+					else
+						graph->_forward(node);
+				}
+				catch (...)
+				{
+					guard.lock();
+					if (!error)
+						error = std::current_exception();
+					guard.unlock();
+				}
+				guard.lock();
+			}
+
+			// release dependent nodes
+			const Node& n = graph->_nodes[node];
+			const std::vector<int>& next = backward ? n.inputs : n.consumers;
+			for (unsigned i = 0; i < next.size(); i++)
+				if (--pending[next[i]] == 0)
+					ready.push_back(next[i]);
+
+			remaining--;
+			wake.notify_all();
+		}
+	}
+};
+
+// Creates empty graph using given number of threads (0 for number of hardware threads).
+GraphNet::GraphNet(int threads)
+	: _nodes(), _inputs(), _outputs(), _outputErrors(), _threads(threads), _scheduler(NULL)
+{
+	if (_threads <= 0)
+		_threads = (int)std::thread::hardware_concurrency();
+	if (_threads <= 0)
+		_threads = 1;
+
+	if (_threads > 1)
+	{
+		_scheduler = new Scheduler();
+		_scheduler->graph = this;
+		_scheduler->remaining = 0;
+		_scheduler->backward = false;
+		_scheduler->stop = false;
+
+		// caller is one of the threads
+		for (int t = 1; t < _threads; t++)
+		{
+			_scheduler->threads.push_back(std::thread([this]()
+			{
+				// nodes already run in parallel, do not split kernels further
+				Matrix::setParallel(false);
+				_scheduler->work(false);
+			}));
+		}
+	}
+}
+
+// Destroys graph and all its layers
+GraphNet::~GraphNet()
+{
+	if (_scheduler)
+	{
+		{
+			std::lock_guard<std::mutex> guard(_scheduler->lock);
+			_scheduler->stop = true;
+		}
+		_scheduler->wake.notify_all();
+
+		for (unsigned t = 0; t < _scheduler->threads.size(); t++)
+			_scheduler->threads[t].join();
+
+		delete _scheduler;
+	}
+
+	for (unsigned i = 0; i < _nodes.size(); i++)
+	{
+		delete _nodes[i].layer;
+		delete _nodes[i].source;
+	}
+}
+
+// Returns index of new node of given kind with given inputs
+int GraphNet::_addNode(Node::Kind kind, const std::vector<int>& inputs, int size)
+{
+	const int index = (int)_nodes.size();
+	for (unsigned i = 0; i < inputs.size(); i++)
+	{
+		if (inputs[i] < 0 || inputs[i] >= index)
+			throw std::out_of_range("GraphNet: Invalid node.");
+	}
+
+	Node node;
+	node.kind = kind;
+	node.inputs = inputs;
+	node.size = size;
+	node.row = 0;
+	node.layer = NULL;
+	node.source = NULL;
+	node.inputErrors.resize(inputs.size());
+	node.external = false;
+	_nodes.push_back(node);
+
+	for (unsigned i = 0; i < inputs.size(); i++)
+		_nodes[inputs[i]].consumers.push_back(index);
+
+	return index;
+}
+
+// Adds graph input of given size. Returns index of the node.
+int GraphNet::addInput(int size)
+{
+	if (size <= 0)
+		throw std::invalid_argument("GraphNet: Invalid size.");
+
+	const int index = _addNode(Node::Input, std::vector<int>(), size);
+	_inputs.push_back(index);
+	return index;
+}
+
+// Adds layer using output of node [input] (last added node by default). Takes ownership of the layer.
+int GraphNet::addLayer(NetLayer* layer, int input)
+{
+	if (!layer)
+		throw std::invalid_argument("GraphNet: Layer cannot be null.");
+
+	if (input < 0)
+		input = (int)_nodes.size() - 1;
+	if (input < 0 || input >= (int)_nodes.size())
+	{
+		delete layer;
+		throw std::out_of_range("GraphNet: Invalid node.");
+	}
+
+	// layer is appended to its own source holding the input
+	NetLayer* source = new InputLayer(_nodes[input].size);
+	try
+	{
+		layer->appendTo(source);
+	}
+	catch (...)
+	{
+		delete layer;
+		delete source;
+		throw;
+	}
+
+	const int index = _addNode(Node::Layer, std::vector<int>(1, input), layer->size());
+	_nodes[index].layer = layer;
+	_nodes[index].source = source;
+	return index;
+}
+
+// Adds node summing outputs of given nodes (all of the same size). Returns index of the node.
+int GraphNet::addSum(const std::vector<int>& inputs)
+{
+	if (inputs.empty())
+		throw std::invalid_argument("GraphNet: Node has no inputs.");
+
+	const int size = nodeSize(inputs[0]);
+	for (unsigned i = 1; i < inputs.size(); i++)
+	{
+		if (nodeSize(inputs[i]) != size)
+			throw std::invalid_argument("GraphNet: Dimension mismatch.");
+	}
+
+	return _addNode(Node::Sum, inputs, size);
+}
+
+// Adds node concatenating outputs of given nodes. Returns index of the node.
+int GraphNet::addConcat(const std::vector<int>& inputs)
+{
+	if (inputs.empty())
+		throw std::invalid_argument("GraphNet: Node has no inputs.");
+
+	int size = 0;
+	for (unsigned i = 0; i < inputs.size(); i++)
+		size += nodeSize(inputs[i]);
+
+	return _addNode(Node::Concat, inputs, size);
+}
+
+// Adds node taking [rows] rows of node [input] starting at [row]. Returns index of the node.
+int GraphNet::addSplit(int input, int row, int rows)
+{
+	if (row < 0 || rows <= 0 || row + rows > nodeSize(input))
+		throw std::invalid_argument("GraphNet: Invalid rows.");
+
+	const int index = _addNode(Node::Split, std::vector<int>(1, input), rows);
+	_nodes[index].row = row;
+	return index;
+}
+
+// Marks node as an output of the graph.
+void GraphNet::addOutput(int node)
+{
+	if (node < 0 || node >= (int)_nodes.size())
+		throw std::out_of_range("GraphNet: Invalid node.");
+
+	_nodes[node].external = true;
+	_outputs.push_back(node);
+	_outputErrors.resize(_outputs.size());
+}
+
+// Returns size of the output of given node
+int GraphNet::nodeSize(int node) const
+{
+	if (node < 0 || node >= (int)_nodes.size())
+		throw std::out_of_range("GraphNet: Invalid node.");
+
+	return _nodes[node].size;
+}
+
+// Returns output of given node (after processInput())
+const Matrix& GraphNet::nodeOutput(int node) const
+{
+	if (node < 0 || node >= (int)_nodes.size())
+		throw std::out_of_range("GraphNet: Invalid node.");
+
+	return _nodes[node].output;
+}
+
+// Returns layers of the graph in order of nodes.
+std::vector<NetLayer*> GraphNet::layers() const
+{
+	std::vector<NetLayer*> res;
+	for (unsigned i = 0; i < _nodes.size(); i++)
+	{
+		if (_nodes[i].layer)
+			res.push_back(_nodes[i].layer);
+	}
+
+	return res;
+}
+
+// Computes output of the node (forward pass)
+void GraphNet::_forward(int index)
+{
+	Node& node = _nodes[index];
+	switch (node.kind)
+	{
+	case Node::Input:
+		break; // set by processInput()
+
+	case Node::Layer:
+		node.source->output() = _nodes[node.inputs[0]].output;
+		node.layer->processInput();
+		node.output = node.layer->output();
+		break;
+
+	case Node::Sum:
+		node.output = _nodes[node.inputs[0]].output;
+		for (unsigned i = 1; i < node.inputs.size(); i++)
+			node.output = node.output + _nodes[node.inputs[i]].output;
+		break;
+
+	case Node::Concat:
+	{
+		const int cols = _nodes[node.inputs[0]].output.columns();
+		Matrix res(node.size, cols);
+
+		int row = 0;
+		for (unsigned i = 0; i < node.inputs.size(); i++)
+		{
+			const Matrix& in = _nodes[node.inputs[i]].output;
+			if (in.columns() != cols)
+				throw std::invalid_argument("GraphNet: Inputs of concatenation have different batch sizes.");
+
+			for (int r = 0; r < in.rows(); r++, row++)
+				for (int c = 0; c < cols; c++)
+					res.at(row, c) = in.at(r, c);
+		}
+
+		node.output = res;
+		break;
+	}
+
+	case Node::Split:
+	{
+		const Matrix& in = _nodes[node.inputs[0]].output;
+		node.output = in.block(node.row, 0, node.size, in.columns());
+		break;
+	}
+	}
+}
+
+// Sums errors from consumers and computes errors of inputs (backward pass)
+void GraphNet::_backward(int index)
+{
+	Node& node = _nodes[index];
+
+	// error of the output, sum in order of consumers (independent of scheduling)
+	bool first = true;
+	if (node.external)
+	{
+		for (unsigned i = 0; i < _outputs.size(); i++)
+		{
+			if (_outputs[i] != index)
+				continue;
+
+			node.error = first ? _outputErrors[i] : node.error + _outputErrors[i];
+			first = false;
+		}
+	}
+
+	for (unsigned i = 0; i < node.consumers.size(); i++)
+	{
+		// consumer may use the node more times (each use once in consumers)
+		const Node& consumer = _nodes[node.consumers[i]];
+		if (i > 0 && node.consumers[i] == node.consumers[i - 1])
+			continue;
+
+		for (unsigned k = 0; k < consumer.inputs.size(); k++)
+		{
+			if (consumer.inputs[k] != index)
+				continue;
+
+			node.error = first ? consumer.inputErrors[k] : node.error + consumer.inputErrors[k];
+			first = false;
+		}
+	}
+
+	if (first)
+	{
+		// output is not used, no error
+		node.error = Matrix(node.size, node.output.columns());
+		node.error.clear();
+	}
+
+	// errors of the inputs
+	switch (node.kind)
+	{
+	case Node::Input:
+		break;
+
+	case Node::Layer:
+		node.layer->error() = node.error;
+		node.layer->processError();
+		node.inputErrors[0] = node.source->error();
+		break;
+
+	case Node::Sum:
+		for (unsigned i = 0; i < node.inputs.size(); i++)
+			node.inputErrors[i] = node.error;
+		break;
+
+	case Node::Concat:
+	{
+		int row = 0;
+		for (unsigned i = 0; i < node.inputs.size(); i++)
+		{
+			const int rows = _nodes[node.inputs[i]].size;
+			node.inputErrors[i] = node.error.block(row, 0, rows, node.error.columns());
+			row += rows;
+		}
+		break;
+	}
+
+	case Node::Split:
+	{
+		// error of the taken rows, zero elsewhere
+		const int cols = node.error.columns();
+		Matrix res(_nodes[node.inputs[0]].size, cols);
+		res.clear();
+
+		for (int r = 0; r < node.size; r++)
+			for (int c = 0; c < cols; c++)
+				res.at(node.row + r, c) = node.error.at(r, c);
+
+		node.inputErrors[0] = res;
+		break;
+	}
+	}
+}
+
+// Runs forward or backward pass over all nodes
+void GraphNet::_run(bool backward)
+{
+	const int count = (int)_nodes.size();
+
+	if (!_scheduler)
+	{
+		// nodes are in topological order
+		for (int i = 0; i < count; i++)
+		{
+			if (backward)
+				_backward(count - 1 - i);
+			else
+				_forward(i);
+		}
+		return;
+	}
+
+	Scheduler& s = *_scheduler;
+	{
+		std::lock_guard<std::mutex> guard(s.lock);
+		s.backward = backward;
+		s.error = NULL;
+		s.remaining = count;
+		s.pending.resize(count);
+		s.ready.clear();
+
+		// nodes without dependencies are ready, first nodes on top
+		for (int i = count - 1; i >= 0; i--)
+		{
+			const int node = backward ? count - 1 - i : i;
+			s.pending[node] = backward ? (int)_nodes[node].consumers.size() : (int)_nodes[node].inputs.size();
+			if (s.pending[node] == 0)
+				s.ready.push_back(node);
+		}
+	}
+
+	s.wake.notify_all();
+	s.work(true);
+
+	if (s.error)
+		std::rethrow_exception(s.error);
+}
+
+// Runs graph forward. One matrix per graph input, batch of samples in columns.
+void GraphNet::processInput(const std::vector<Matrix>& inputs)
+{
+	if (inputs.size() != _inputs.size())
+		throw std::invalid_argument("GraphNet: Invalid number of inputs.");
+
+	for (unsigned i = 0; i < inputs.size(); i++)
+	{
+		if (inputs[i].rows() != _nodes[_inputs[i]].size)
+			throw std::invalid_argument("GraphNet: Dimension mismatch.");
+
+		_nodes[_inputs[i]].output = inputs[i];
+	}
+
+	_run(false);
+}
+
+// Runs graph with single input forward.
+void GraphNet::processInput(const Matrix& in)
+{
+	processInput(std::vector<Matrix>(1, in));
+}
+
+// Returns given output of the graph.
+const Matrix& GraphNet::output(int index) const
+{
+	if (index < 0 || index >= (int)_outputs.size())
+		throw std::out_of_range("GraphNet: Invalid output.");
+
+	return _nodes[_outputs[index]].output;
+}
+
+// Processes errors of the outputs backward.
+void GraphNet::processError(const std::vector<Matrix>& errors)
+{
+	if (errors.size() != _outputs.size())
+		throw std::invalid_argument("GraphNet: Invalid number of errors.");
+
+	_outputErrors = errors;
+	_run(true);
+}
+
+// Processes error of the single output backward.
+void GraphNet::processError(const Matrix& err)
+{
+	processError(std::vector<Matrix>(1, err));
+}
+
+// Returns error of given graph input (after processError()).
+const Matrix& GraphNet::inputError(int index) const
+{
+	if (index < 0 || index >= (int)_inputs.size())
+		throw std::out_of_range("GraphNet: Invalid input.");
+
+	return _nodes[_inputs[index]].error;
+}
+
+// Updates parameters of all layers. Call after each batch.
+void GraphNet::updateParameters()
+{
+	for (int i = (int)_nodes.size() - 1; i >= 0; i--)
+	{
+		if (_nodes[i].layer)
+			_nodes[i].layer->updateParameters();
+	}
+}
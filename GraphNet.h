@@ -0,0 +1,119 @@
+#ifndef _GRAPH_NET_H_
+#define _GRAPH_NET_H_
+
+#include "Net.h"
+#include <vector>
+
+// Network with topology of a directed acyclic graph (skip connections, multiple inputs and outputs, parallel
+// branches). Nodes are graph inputs, layers (any chain layer except InputLayer), sums, concatenations and splits.
+// Node may be used by any number of later nodes, their errors are summed in backward pass.
+// Nodes are identified by indices returned by add methods; inputs of a node have to be added before it.
+//
+// Forward and backward passes are scheduled topologically: a node runs when all its inputs (or all its consumers
+// in backward pass) are finished, independent branches run concurrently on a pool of threads. Results do not
+// depend on the number of threads (errors of shared nodes are summed in fixed order).
+class GraphNet
+{
+private:
+	// Node of the graph
+	struct Node
+	{
+		enum Kind { Input, Layer, Sum, Concat, Split } kind;
+		std::vector<int> inputs;			// input nodes
+		std::vector<int> consumers;			// nodes using the output (once for each use)
+		int size;							// size of the output
+		int row;							// first row of the input (split)
+		NetLayer* layer;					// layer of the node (owned)
+		NetLayer* source;					// input of the layer (owned), receives error of the input
+		Matrix output;						// output of the node
+		Matrix error;						// error of the output
+		std::vector<Matrix> inputErrors;	// error of each input (backward pass)
+		bool external;						// output error is given by processError()
+	};
+
+	struct Scheduler;
+
+	std::vector<Node> _nodes;
+	std::vector<int> _inputs;				// input nodes
+	std::vector<int> _outputs;				// output nodes
+	std::vector<Matrix> _outputErrors;		// errors of the outputs (backward pass)
+	int _threads;
+	Scheduler* _scheduler;					// thread pool (NULL when single-threaded)
+
+	// Returns index of new node of given kind with given inputs
+	int _addNode(Node::Kind kind, const std::vector<int>& inputs, int size);
+
+	// Computes output of the node (forward pass)
+	void _forward(int node);
+
+	// Sums errors from consumers and computes errors of inputs (backward pass)
+	void _backward(int node);
+
+	// Runs forward or backward pass over all nodes
+	void _run(bool backward);
+
+public:
+	// Creates empty graph using given number of threads (0 for number of hardware threads).
+	GraphNet(int threads = 1);
+
+	// Destroys graph and all its layers
+	~GraphNet();
+
+	// Adds graph input of given size. Returns index of the node.
+	int addInput(int size);
+
+	// Adds layer using output of node [input] (last added node by default). Takes ownership of the layer.
+	// Returns index of the node.
+	int addLayer(NetLayer* layer, int input = -1);
+
+	// Adds node summing outputs of given nodes (all of the same size). Returns index of the node.
+	int addSum(const std::vector<int>& inputs);
+
+	// Adds node concatenating outputs of given nodes (rows of the first one followed by rows of the others).
+	// Returns index of the node.
+	int addConcat(const std::vector<int>& inputs);
+
+	// Adds node taking [rows] rows of node [input] starting at [row]. Returns index of the node.
+	int addSplit(int input, int row, int rows);
+
+	// Marks node as an output of the graph (outputs are numbered in order of the calls).
+	void addOutput(int node);
+
+	// Returns number of nodes
+	int nodes() const { return (int)_nodes.size(); }
+
+	// Returns size of the output of given node
+	int nodeSize(int node) const;
+
+	// Returns output of given node (after processInput())
+	const Matrix& nodeOutput(int node) const;
+
+	// Returns layers of the graph in order of nodes (e.g. for BinaryModel or Checkpoint).
+	std::vector<NetLayer*> layers() const;
+
+	// Returns number of threads
+	int threads() const { return _threads; }
+
+	// Runs graph forward. One matrix per graph input (in order of addInput()), batch of samples in columns.
+	void processInput(const std::vector<Matrix>& inputs);
+
+	// Runs graph with single input forward.
+	void processInput(const Matrix& in);
+
+	// Returns given output of the graph (in order of addOutput()).
+	const Matrix& output(int index = 0) const;
+
+	// Processes errors of the outputs (one per output, in order of addOutput()) backward.
+	void processError(const std::vector<Matrix>& errors);
+
+	// Processes error of the single output backward.
+	void processError(const Matrix& err);
+
+	// Returns error of given graph input (after processError()).
+	const Matrix& inputError(int index = 0) const;
+
+	// Updates parameters of all layers. Call after each batch.
+	void updateParameters();
+};
+
+#endif // _GRAPH_NET_H_
@@ -0,0 +1,297 @@
+#include "BinaryModel.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+static const char magic[4] = { 'L', 'M', 'N', 'T' };
+static const size_t fileHeaderSize = 32;
+static const size_t layerHeaderSize = 8;
+static const size_t tensorHeaderSize = 24;
+
+// Returns true when host stores numbers little-endian (tensors can be wrapped without conversion).
+static bool hostLittleEndian()
+{
+	const uint32_t x = 1;
+	unsigned char b;
+	memcpy(&b, &x, 1);
+	return (b == 1);
+}
+
+// Appends 32-bit value to given buffer (little-endian).
+void BinaryModel::put32(std::vector<unsigned char>& buf, uint32_t x)
+{
+	for (int i = 0; i < 4; i++)
+		buf.push_back((unsigned char)(x >> (8 * i)));
+}
+
+// Appends 64-bit value to given buffer (little-endian).
+void BinaryModel::put64(std::vector<unsigned char>& buf, uint64_t x)
+{
+	for (int i = 0; i < 8; i++)
+		buf.push_back((unsigned char)(x >> (8 * i)));
+}
+
+// Reads 32-bit little-endian value.
+uint32_t BinaryModel::get32(const unsigned char* p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Reads 64-bit little-endian value.
+uint64_t BinaryModel::get64(const unsigned char* p)
+{
+	return (uint64_t)get32(p) | ((uint64_t)get32(p + 4) << 32);
+}
+
+// Rounds offset up to the tensor alignment
+static uint64_t alignOffset(uint64_t offset)
+{
+	return (offset + BinaryModel::alignment - 1) / BinaryModel::alignment * BinaryModel::alignment;
+}
+
+// Converts matrix to little-endian floats stored row by row
+static void encodeTensor(const Matrix& mat, std::vector<unsigned char>& buf)
+{
+	buf.resize((size_t)mat.count() * 4);
+
+	unsigned char* dst = buf.data();
+	for (int r = 0; r < mat.rows(); r++)
+	{
+		for (int c = 0; c < mat.columns(); c++)
+		{
+			const float x = mat.at(r, c);
+			uint32_t bits;
+			memcpy(&bits, &x, 4);
+			for (int i = 0; i < 4; i++)
+				(*dst++) = (unsigned char)(bits >> (8 * i));
+		}
+	}
+}
+
+// Lookup table of CRC32 (IEEE 802.3, reflected polynomial 0xEDB88320)
+struct CrcTable
+{
+	uint32_t table[256];
+
+	CrcTable()
+	{
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+
+			table[i] = c;
+		}
+	}
+};
+
+// Computes CRC32 (IEEE 802.3) of given data, continuing from [crc].
+uint32_t BinaryModel::checksum(const void* data, size_t size, uint32_t crc)
+{
+	// built once by the first call (thread-safe initialization of local static)
+	static const CrcTable crc32;
+	const uint32_t* table = crc32.table;
+
+	const unsigned char* src = (const unsigned char*)data;
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+		crc = table[(crc ^ src[i]) & 0xFF] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+// Returns true when given file starts with the binary model signature.
+bool BinaryModel::isBinary(const char* filename)
+{
+	FILE* file = fopen(filename, "rb");
+	if (!file)
+		return false;
+
+	char buf[4];
+	const bool res = (fread(buf, 1, 4, file) == 4 && memcmp(buf, magic, 4) == 0);
+	fclose(file);
+
+	return res;
+}
+
+// Writes parameters of given layers to file. Returns false when the file cannot be written.
+bool BinaryModel::save(const std::vector<NetLayer*>& layers, const char* filename)
+{
+	// collect tensors and compute layout
+	std::vector<std::vector<Matrix*> > params(layers.size());
+	uint32_t tensorCount = 0;
+	for (unsigned i = 0; i < layers.size(); i++)
+	{
+		params[i] = layers[i]->parameters();
+		tensorCount += (uint32_t)params[i].size();
+	}
+
+	const uint64_t headersSize = layers.size() * layerHeaderSize + tensorCount * tensorHeaderSize;
+	const uint64_t dataOffset = alignOffset(fileHeaderSize + headersSize);
+
+	// layer and tensor headers with checksums of the data
+	std::vector<unsigned char> headers;
+	std::vector<std::vector<unsigned char> > tensors;
+	uint64_t offset = dataOffset;
+	for (unsigned i = 0; i < layers.size(); i++)
+	{
+		put32(headers, i);
+		put32(headers, (uint32_t)params[i].size());
+
+		for (unsigned j = 0; j < params[i].size(); j++)
+		{
+			const Matrix& mat = *params[i][j];
+			tensors.push_back(std::vector<unsigned char>());
+			encodeTensor(mat, tensors.back());
+
+			put32(headers, (uint32_t)mat.rows());
+			put32(headers, (uint32_t)mat.columns());
+			put64(headers, offset);
+			put32(headers, checksum(tensors.back().data(), tensors.back().size()));
+			put32(headers, 0); // reserved
+
+			offset = alignOffset(offset + tensors.back().size());
+		}
+	}
+
+	// file header
+	std::vector<unsigned char> header(magic, magic + 4);
+	put32(header, version);
+	put32(header, (uint32_t)layers.size());
+	put32(header, tensorCount);
+	put64(header, dataOffset);
+	put32(header, checksum(headers.data(), headers.size()));
+	put32(header, 0); // reserved
+
+	FILE* file = fopen(filename, "wb");
+	if (!file)
+		return false;
+
+	bool ok = (fwrite(header.data(), 1, header.size(), file) == header.size());
+	ok = ok && (fwrite(headers.data(), 1, headers.size(), file) == headers.size());
+
+	// tensor data with alignment padding
+	static const unsigned char padding[alignment] = { 0 };
+	uint64_t pos = fileHeaderSize + headers.size();
+	for (unsigned i = 0; i < tensors.size() && ok; i++)
+	{
+		const size_t pad = (size_t)(alignOffset(pos) - pos);
+		ok = ok && (fwrite(padding, 1, pad, file) == pad);
+		ok = ok && (fwrite(tensors[i].data(), 1, tensors[i].size(), file) == tensors[i].size());
+		pos += pad + tensors[i].size();
+	}
+
+	ok = (fclose(file) == 0) && ok;
+	return ok;
+}
+
+// Loads parameters of given layers (structure has to be set first). Returns false when the file cannot be opened.
+// Throws std::runtime_error when the file is corrupted (checksums are tested when [verify] is set) or does not match the layers.
+bool BinaryModel::load(const std::vector<NetLayer*>& layers, const char* filename, bool verify)
+{
+	MappedFile* file = MappedFile::open(filename);
+	if (!file)
+		return false;
+
+	try
+	{
+		const unsigned char* base = (const unsigned char*)file->data();
+		const size_t size = file->size();
+
+		if (size < fileHeaderSize || memcmp(base, magic, 4) != 0)
+			throw std::runtime_error("BinaryModel: Invalid file signature.");
+
+		if (get32(base + 4) != version)
+			throw std::runtime_error("BinaryModel: Unsupported version.");
+
+		const uint32_t layerCount = get32(base + 8);
+		const uint32_t tensorCount = get32(base + 12);
+		const uint64_t headersSize = (uint64_t)layerCount * layerHeaderSize + (uint64_t)tensorCount * tensorHeaderSize;
+
+		if (layerCount != layers.size())
+			throw std::runtime_error("BinaryModel: Network structure does not match the file.");
+
+		if (fileHeaderSize + headersSize > size)
+			throw std::runtime_error("BinaryModel: File is truncated.");
+
+		const unsigned char* p = base + fileHeaderSize;
+		if (verify && checksum(p, (size_t)headersSize) != get32(base + 24))
+			throw std::runtime_error("BinaryModel: Header checksum mismatch.");
+
+		// validate everything first, so that corrupted file does not leave the network half loaded
+		std::vector<Matrix*> targets;
+		std::vector<const unsigned char*> sources;
+		uint32_t tensorsLeft = tensorCount;
+		for (uint32_t i = 0; i < layerCount; i++)
+		{
+			const uint32_t count = get32(p + 4);
+			p += layerHeaderSize;
+
+			std::vector<Matrix*> params = layers[i]->parameters();
+			if (get32(p - layerHeaderSize) != i || count != params.size() || count > tensorsLeft)
+				throw std::runtime_error("BinaryModel: Network structure does not match the file.");
+
+			tensorsLeft -= count;
+			for (uint32_t j = 0; j < count; j++, p += tensorHeaderSize)
+			{
+				const int rows = (int)get32(p);
+				const int cols = (int)get32(p + 4);
+				const uint64_t offset = get64(p + 8);
+				const uint64_t bytes = (uint64_t)rows * (uint64_t)cols * 4;
+
+				if (rows != params[j]->rows() || cols != params[j]->columns())
+					throw std::runtime_error("BinaryModel: Tensor dimensions do not match the network.");
+
+				if (offset % 4 != 0 || offset > size || bytes > size - offset)
+					throw std::runtime_error("BinaryModel: File is truncated.");
+
+				if (verify && checksum(base + offset, (size_t)bytes) != get32(p + 16))
+					throw std::runtime_error("BinaryModel: Tensor checksum mismatch.");
+
+				targets.push_back(params[j]);
+				sources.push_back(base + offset);
+			}
+		}
+
+		// assign tensors
+		const bool wrap = hostLittleEndian();
+		for (unsigned i = 0; i < targets.size(); i++)
+		{
+			Matrix& mat = *targets[i];
+			const int rows = mat.rows();
+			const int cols = mat.columns();
+
+			if (wrap)
+			{
+				// zero copy, matrix keeps the mapping alive
+				file->retain();
+				mat = Matrix((const float*)sources[i], rows, cols, cols, 1, MappedFile::releaseMatrix, file);
+			}
+			else
+			{
+				// convert byte order
+				Matrix res(rows, cols);
+				const unsigned char* src = sources[i];
+				for (int r = 0; r < rows; r++)
+				{
+					for (int c = 0; c < cols; c++, src += 4)
+					{
+						const uint32_t bits = get32(src);
+						memcpy(&res.at(r, c), &bits, 4);
+					}
+				}
+				mat = res;
+			}
+		}
+	}
+	catch (...)
+	{
+		file->release();
+		throw;
+	}
+
+	file->release();
+	return true;
+}
@@ -0,0 +1,49 @@
+#ifndef _BINARY_MODEL_H_
+#define _BINARY_MODEL_H_
+
+#include "../Layers/NetLayer.h"
+#include <vector>
+#include <cstdint>
+
+// Implements versioned binary format of network parameters.
+// All values are little-endian. File consists of:
+//	- file header: magic "LMNT", version, layer count, tensor count, data offset, CRC32 of the layer and tensor headers
+//	- for each layer: layer header (layer index, tensor count) followed by its tensor headers (rows, columns, offset, CRC32 of data)
+//	- tensor data (floats row by row), each tensor aligned to 64 bytes
+// Loader maps the file to memory and wraps tensors by matrices without copying (copied on first change).
+class BinaryModel
+{
+public:
+	// Current version of the format
+	static const uint32_t version = 1;
+
+	// Alignment of tensor data within the file
+	static const uint32_t alignment = 64;
+
+	// Returns true when given file starts with the binary model signature.
+	static bool isBinary(const char* filename);
+
+	// Writes parameters of given layers to file. Returns false when the file cannot be written.
+	static bool save(const std::vector<NetLayer*>& layers, const char* filename);
+
+	// Loads parameters of given layers (structure has to be set first). Returns false when the file cannot be opened.
+	// Throws std::runtime_error when the file is corrupted (checksums are tested when [verify] is set) or does not match the layers.
+	static bool load(const std::vector<NetLayer*>& layers, const char* filename, bool verify = true);
+
+	// Computes CRC32 (IEEE 802.3) of given data, continuing from [crc].
+	static uint32_t checksum(const void* data, size_t size, uint32_t crc = 0);
+
+	// Appends 32-bit value to given buffer (little-endian).
+	static void put32(std::vector<unsigned char>& buf, uint32_t x);
+
+	// Appends 64-bit value to given buffer (little-endian).
+	static void put64(std::vector<unsigned char>& buf, uint64_t x);
+
+	// Reads 32-bit little-endian value.
+	static uint32_t get32(const unsigned char* p);
+
+	// Reads 64-bit little-endian value.
+	static uint64_t get64(const unsigned char* p);
+};
+
+#endif // _BINARY_MODEL_H_
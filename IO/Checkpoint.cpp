@@ -0,0 +1,385 @@
+#include "Checkpoint.h"
+#include "BinaryModel.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define CHECKPOINT_FSYNC
+#endif
+
+static const char magic[4] = { 'L', 'M', 'C', 'K' };
+static const size_t fileHeaderSize = 32;
+static const size_t tensorHeaderSize = 24;
+
+// Returns name of the checkpoint file with given sequence number.
+static std::string sequenceName(const std::string& filename, uint32_t sequence)
+{
+	return (sequence == 0) ? filename : filename + "." + std::to_string(sequence);
+}
+
+// Returns new identifier of a full checkpoint.
+static uint64_t newId()
+{
+	std::random_device device;
+	const uint64_t time = (uint64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+	return (((uint64_t)device() << 32) | device()) ^ time;
+}
+
+// Reads whole file. Returns false when it cannot be opened.
+static bool readFile(const std::string& filename, std::vector<unsigned char>& buf)
+{
+	FILE* file = fopen(filename.c_str(), "rb");
+	if (!file)
+		return false;
+
+	buf.clear();
+	unsigned char chunk[1 << 16];
+	size_t count;
+	while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0)
+		buf.insert(buf.end(), chunk, chunk + count);
+
+	fclose(file);
+	return true;
+}
+
+// Tensors read from checkpoint files (per layer and slot)
+struct StagedTensors
+{
+	std::vector<std::vector<Matrix> > tensors;
+	std::vector<std::vector<uint32_t> > owners;
+	std::vector<std::vector<bool> > present;
+};
+
+// Parses checkpoint file to staged tensors. Returns sequence number and base id of the file.
+static void parseFile(const std::vector<unsigned char>& buf, uint32_t& sequence, uint64_t& baseId, StagedTensors& staged)
+{
+	const unsigned char* base = buf.data();
+	const size_t size = buf.size();
+
+	if (size < fileHeaderSize || memcmp(base, magic, 4) != 0)
+		throw std::runtime_error("Checkpoint: Invalid file signature.");
+
+	const uint32_t version = BinaryModel::get32(base + 4);
+	if (version != 1 && version != Checkpoint::version)
+		throw std::runtime_error("Checkpoint: Unsupported version.");
+
+	sequence = BinaryModel::get32(base + 8);
+	const uint32_t tensorCount = BinaryModel::get32(base + 12);
+	baseId = BinaryModel::get64(base + 16);
+
+	size_t pos = fileHeaderSize;
+	for (uint32_t t = 0; t < tensorCount; t++)
+	{
+		if (size - pos < tensorHeaderSize)
+			throw std::runtime_error("Checkpoint: Truncated file.");
+
+		const unsigned char* header = base + pos;
+		const uint32_t layer = BinaryModel::get32(header);
+		const uint32_t slot = BinaryModel::get32(header + 4);
+		const uint32_t rows = BinaryModel::get32(header + 8);
+		const uint32_t cols = BinaryModel::get32(header + 12);
+		const uint32_t crc = BinaryModel::get32(header + 16);
+		const uint32_t owner = (version == 1) ? 0 : BinaryModel::get32(header + 20);
+		pos += tensorHeaderSize;
+
+		const uint64_t bytes = (uint64_t)rows * cols * 4;
+		if (layer >= staged.tensors.size() || slot > 1024 || rows > INT32_MAX || cols > INT32_MAX)
+			throw std::runtime_error("Checkpoint: Checkpoint does not match the network.");
+
+		if (bytes > size - pos)
+			throw std::runtime_error("Checkpoint: Truncated file.");
+
+		const unsigned char* data = base + pos;
+		if (BinaryModel::checksum(data, (size_t)bytes) != crc)
+			throw std::runtime_error("Checkpoint: Checksum mismatch.");
+
+		Matrix mat((int)rows, (int)cols);
+		for (uint32_t r = 0; r < rows; r++)
+		{
+			for (uint32_t c = 0; c < cols; c++, data += 4)
+			{
+				const uint32_t bits = BinaryModel::get32(data);
+				float x;
+				memcpy(&x, &bits, 4);
+				mat.at(r, c) = x;
+			}
+		}
+		pos += (size_t)bytes;
+
+		if (staged.tensors[layer].size() <= slot)
+		{
+			staged.tensors[layer].resize(slot + 1);
+			staged.owners[layer].resize(slot + 1, 0);
+			staged.present[layer].resize(slot + 1, false);
+		}
+
+		staged.tensors[layer][slot] = mat;
+		staged.owners[layer][slot] = owner;
+		staged.present[layer][slot] = true;
+	}
+}
+
+// Creates checkpoint writer of given file.
+Checkpoint::Checkpoint(const char* filename)
+	: _filename(filename), _thread(), _ok(true), _snapshot(), _owners(), _baseId(0), _sequence(0) {}
+
+// Waits for the pending write.
+Checkpoint::~Checkpoint()
+{
+	wait();
+}
+
+// Waits for the pending write. Returns false when the last write failed.
+bool Checkpoint::wait()
+{
+	if (_thread.joinable())
+		_thread.join();
+
+	return _ok;
+}
+
+// Takes snapshot of given layers and writes it in background. Waits for the previous write first.
+// Incremental checkpoint writes only tensors changed since the previous snapshot (full one is written when
+// there is none yet or the structure changed).
+void Checkpoint::save(const std::vector<NetLayer*>& layers, bool incremental)
+{
+	wait();
+
+	// copy-on-write snapshot, further updates of the layers copy their tensors
+	std::vector<std::vector<Matrix> > snapshot(layers.size());
+	std::vector<std::vector<uint32_t> > owners(layers.size());
+	for (unsigned i = 0; i < layers.size(); i++)
+	{
+		const std::vector<Matrix*> params = layers[i]->parameters();
+		for (unsigned j = 0; j < params.size(); j++)
+			snapshot[i].push_back(*params[j]);
+		owners[i].resize(snapshot[i].size(), 0);
+
+		const std::vector<LearningRule*> rules = layers[i]->learningRules();
+		for (unsigned k = 0; k < rules.size(); k++)
+		{
+			const std::vector<Matrix> state = rules[k]->state();
+			snapshot[i].insert(snapshot[i].end(), state.begin(), state.end());
+			owners[i].resize(snapshot[i].size(), k + 1);
+		}
+	}
+
+	bool full = !incremental || _baseId == 0 || owners != _owners;
+
+	// tensors still sharing data with the previous snapshot were not changed
+	std::vector<std::vector<bool> > changed(snapshot.size());
+	for (unsigned i = 0; i < snapshot.size(); i++)
+	{
+		changed[i].resize(snapshot[i].size(), true);
+		for (unsigned j = 0; j < snapshot[i].size() && !full; j++)
+			changed[i][j] = !snapshot[i][j].shares(_snapshot[i][j]);
+	}
+
+	if (full)
+	{
+		_baseId = newId();
+		_sequence = 0;
+	}
+	else
+	{
+		_sequence++;
+	}
+
+	// previous snapshot is released here (the writer thread never copies or releases matrices)
+	_snapshot.swap(snapshot);
+	_owners.swap(owners);
+	_ok = true;
+	_thread = std::thread(&Checkpoint::_write, this, changed);
+}
+
+// Writes tensors of the snapshot selected by [changed] (background thread)
+void Checkpoint::_write(std::vector<std::vector<bool> > changed)
+{
+	const std::string filename = sequenceName(_filename, _sequence);
+	const std::string tmpName = filename + ".tmp";
+
+	FILE* file = NULL;
+	try
+	{
+		uint32_t tensorCount = 0;
+		for (unsigned i = 0; i < changed.size(); i++)
+			for (unsigned j = 0; j < changed[i].size(); j++)
+				tensorCount += changed[i][j] ? 1 : 0;
+
+		std::vector<unsigned char> buf(magic, magic + 4);
+		BinaryModel::put32(buf, version);
+		BinaryModel::put32(buf, _sequence);
+		BinaryModel::put32(buf, tensorCount);
+		BinaryModel::put64(buf, _baseId);
+		BinaryModel::put64(buf, 0); // reserved
+
+		file = fopen(tmpName.c_str(), "wb");
+		bool ok = (file != NULL) && (fwrite(buf.data(), 1, buf.size(), file) == buf.size());
+
+		for (unsigned i = 0; i < changed.size() && ok; i++)
+		{
+			for (unsigned j = 0; j < changed[i].size() && ok; j++)
+			{
+				if (!changed[i][j])
+					continue;
+
+				// tensor data as little-endian floats (snapshot is only read here)
+				const Matrix& mat = _snapshot[i][j];
+				std::vector<unsigned char> data;
+				data.reserve((size_t)mat.count() * 4);
+				for (int r = 0; r < mat.rows(); r++)
+				{
+					for (int c = 0; c < mat.columns(); c++)
+					{
+						const float x = mat.at(r, c);
+						uint32_t bits;
+						memcpy(&bits, &x, 4);
+						BinaryModel::put32(data, bits);
+					}
+				}
+
+				buf.clear();
+				BinaryModel::put32(buf, i);
+				BinaryModel::put32(buf, j);
+				BinaryModel::put32(buf, (uint32_t)mat.rows());
+				BinaryModel::put32(buf, (uint32_t)mat.columns());
+				BinaryModel::put32(buf, BinaryModel::checksum(data.data(), data.size()));
+				BinaryModel::put32(buf, _owners[i][j]);
+
+				ok = (fwrite(buf.data(), 1, buf.size(), file) == buf.size());
+				ok = ok && (fwrite(data.data(), 1, data.size(), file) == data.size());
+			}
+		}
+
+		ok = ok && (fflush(file) == 0);
+#ifdef CHECKPOINT_FSYNC
+		ok = ok && (fsync(fileno(file)) == 0);
+#endif
+		if (file)
+			ok = (fclose(file) == 0) && ok;
+		file = NULL;
+
+		// atomic replace (rename does not replace existing file on some platforms)
+		if (ok && rename(tmpName.c_str(), filename.c_str()) != 0)
+		{
+			remove(filename.c_str());
+			ok = (rename(tmpName.c_str(), filename.c_str()) == 0);
+		}
+
+		// incremental checkpoints of the previous full one are obsolete
+		if (ok && _sequence == 0)
+			for (uint32_t n = 1; remove(sequenceName(_filename, n).c_str()) == 0; n++);
+
+		if (!ok)
+			remove(tmpName.c_str());
+
+		_ok = ok;
+	}
+	catch (...)
+	{
+		if (file)
+			fclose(file);
+
+		remove(tmpName.c_str());
+		_ok = false;
+	}
+}
+
+// Loads parameters and learning rule states of given layers (structure has to be set first).
+// Returns false when the file cannot be opened. Throws std::runtime_error when the checkpoint is corrupted
+// or does not match the layers. Nothing is changed on failure.
+bool Checkpoint::load(const std::vector<NetLayer*>& layers, const char* filename)
+{
+	std::vector<unsigned char> buf;
+	if (!readFile(filename, buf))
+		return false;
+
+	StagedTensors staged;
+	staged.tensors.resize(layers.size());
+	staged.owners.resize(layers.size());
+	staged.present.resize(layers.size());
+
+	uint32_t sequence;
+	uint64_t baseId;
+	parseFile(buf, sequence, baseId, staged);
+	if (sequence != 0)
+		throw std::runtime_error("Checkpoint: Not a full checkpoint.");
+
+	// apply incremental checkpoints of this full one in order
+	for (uint32_t n = 1; readFile(sequenceName(filename, n), buf); n++)
+	{
+		if (buf.size() < fileHeaderSize || BinaryModel::get32(buf.data() + 8) != n || BinaryModel::get64(buf.data() + 16) != baseId)
+			break; // obsolete file of an older checkpoint
+
+		parseFile(buf, sequence, baseId, staged);
+	}
+
+	// validate everything before any change, states are grouped by their rules
+	std::vector<std::vector<LearningRule*> > rules(layers.size());
+	std::vector<std::vector<std::vector<Matrix> > > states(layers.size());
+	for (unsigned i = 0; i < layers.size(); i++)
+	{
+		const std::vector<Matrix*> params = layers[i]->parameters();
+		rules[i] = layers[i]->learningRules();
+		states[i].resize(rules[i].size());
+		if (staged.tensors[i].size() < params.size())
+			throw std::runtime_error("Checkpoint: Checkpoint does not match the network.");
+
+		for (unsigned j = 0; j < staged.present[i].size(); j++)
+			if (!staged.present[i][j])
+				throw std::runtime_error("Checkpoint: Missing tensor.");
+
+		for (unsigned j = 0; j < params.size(); j++)
+			if (staged.tensors[i][j].size() != params[j]->size())
+				throw std::runtime_error("Checkpoint: Checkpoint does not match the network.");
+
+		// states of each rule follow those of the previous one (version 1 has owner 0 for the first rule)
+		uint32_t last = 0;
+		for (unsigned j = (unsigned)params.size(); j < staged.tensors[i].size(); j++)
+		{
+			const uint32_t rule = std::max(staged.owners[i][j], (uint32_t)1) - 1;
+			if (rule >= rules[i].size() || rule < last)
+				throw std::runtime_error("Checkpoint: Checkpoint does not match the network.");
+
+			states[i][rule].push_back(staged.tensors[i][j]);
+			last = rule;
+		}
+	}
+
+	// learning rules validate their states, restore the previous ones on failure
+	std::vector<LearningRule*> changed;
+	std::vector<std::vector<Matrix> > previous;
+	try
+	{
+		for (unsigned i = 0; i < layers.size(); i++)
+		{
+			for (unsigned k = 0; k < rules[i].size(); k++)
+			{
+				previous.push_back(rules[i][k]->state());
+				changed.push_back(rules[i][k]);
+				rules[i][k]->setState(states[i][k]);
+			}
+		}
+	}
+	catch (...)
+	{
+		for (unsigned k = 0; k < changed.size(); k++)
+			changed[k]->setState(previous[k]);
+
+		throw;
+	}
+
+	for (unsigned i = 0; i < layers.size(); i++)
+	{
+		const std::vector<Matrix*> params = layers[i]->parameters();
+		for (unsigned j = 0; j < params.size(); j++)
+			*params[j] = staged.tensors[i][j];
+	}
+
+	return true;
+}
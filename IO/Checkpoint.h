@@ -0,0 +1,63 @@
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_
+
+#include "../Layers/NetLayer.h"
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+// Writes training checkpoints: parameters of the layers together with the state of their learning rules.
+// save() only takes a copy-on-write snapshot of the tensors (no data are copied), the file is written on
+// a background thread while training continues. Files are written to a temporary file and renamed, so
+// a crash never leaves a partially written checkpoint.
+//
+// Full checkpoint is stored in [filename]. Incremental checkpoints are stored in [filename].1, [filename].2, ...
+// and contain only tensors changed since the previous snapshot. load() applies the full checkpoint and
+// all its incremental ones in order.
+//
+// File format (little-endian): header (magic "LMCK", version, sequence number, tensor count, base id u64,
+// reserved u64) followed by tensors, each with header (layer index, slot, rows, columns, CRC32 of data, owner)
+// and data (floats row by row). Slots are numbered by NetLayer::parameters() followed by LearningRule::state()
+// of each rule of NetLayer::learningRules(). Owner is 0 for parameters, k + 1 for state of the k-th rule
+// (version 1 files store state of the first rule only, with owner 0).
+class Checkpoint
+{
+private:
+	std::string _filename;
+	std::thread _thread;					// background writer
+	bool _ok;								// result of the last write
+
+	std::vector<std::vector<Matrix> > _snapshot;	// tensors of the last snapshot (per layer)
+	std::vector<std::vector<uint32_t> > _owners;	// owner of each tensor of the snapshot (see file format)
+	uint64_t _baseId;						// identifier of the last full checkpoint
+	uint32_t _sequence;						// number of incremental checkpoints since the full one
+
+	// Writes tensors of the snapshot selected by [changed] (background thread)
+	void _write(std::vector<std::vector<bool> > changed);
+
+public:
+	// Current version of the format
+	static const uint32_t version = 2;
+
+	// Creates checkpoint writer of given file.
+	Checkpoint(const char* filename);
+
+	// Waits for the pending write.
+	~Checkpoint();
+
+	// Takes snapshot of given layers and writes it in background. Waits for the previous write first.
+	// Incremental checkpoint writes only tensors changed since the previous snapshot (full one is written when
+	// there is none yet or the structure changed).
+	void save(const std::vector<NetLayer*>& layers, bool incremental = false);
+
+	// Waits for the pending write. Returns false when the last write failed.
+	bool wait();
+
+	// Loads parameters and learning rule states of given layers (structure has to be set first).
+	// Returns false when the file cannot be opened. Throws std::runtime_error when the checkpoint is corrupted
+	// or does not match the layers. Nothing is changed on failure.
+	static bool load(const std::vector<NetLayer*>& layers, const char* filename);
+};
+
+#endif // _CHECKPOINT_H_
@@ -0,0 +1,454 @@
+#include "CodeExporter.h"
+#include "../Layers/InputLayer.h"
+#include "../Layers/WeightLayer.h"
+#include "../Layers/BiasLayer.h"
+#include "../Layers/TanhLayer.h"
+#include "../Layers/RectifierLayer.h"
+#include "../Layers/SoftplusLayer.h"
+#include "../Layers/DenseLayer.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <stdexcept>
+
+// Entries of activation lookup tables (fixed-point mode)
+static const int tableSize = 256;
+
+// Forward operation of one layer
+struct Step
+{
+	enum Kind { Weights, Bias, Tanh, Rectifier, Softplus };
+
+	Kind kind;
+	int index;				// index of the layer (used in symbol names)
+	const Matrix* params;	// weights or bias
+};
+
+// Returns float as C literal which reads back exactly.
+static std::string floatLiteral(float val)
+{
+	if (!std::isfinite(val))
+		throw std::invalid_argument("CodeExporter: Parameter is not finite.");
+
+	char buf[32];
+	std::string res(buf, std::to_chars(buf, buf + sizeof(buf), val).ptr - buf);
+	if (res.find_first_of(".e") == std::string::npos)
+		res += ".0";
+
+	return res + "f";
+}
+
+// Returns float converted to fixed point with [bits] fractional bits as C literal.
+static std::string fixedLiteral(double val, int bits)
+{
+	const double q = std::round(val * std::ldexp(1.0, bits));
+	if (!(q >= (double)INT32_MIN && q <= (double)INT32_MAX))
+		throw std::invalid_argument("CodeExporter: Parameter out of fixed-point range.");
+
+	return std::to_string((long long)q);
+}
+
+// Appends formatted text.
+static void append(std::string& text, const char* format, const std::string& a = std::string(), int b = 0, int c = 0)
+{
+	char buf[512];
+	snprintf(buf, sizeof(buf), format, a.c_str(), b, c);
+	text += buf;
+}
+
+// Appends elements of given row as comma separated list.
+static void appendRow(std::string& text, const Matrix& mat, int r, bool fixedPoint, int bits)
+{
+	for (int c = 0; c < mat.columns(); c++)
+	{
+		text += fixedPoint ? fixedLiteral(mat.at(r, c), bits) : floatLiteral(mat.at(r, c));
+		if (c + 1 < mat.columns())
+			text += ", ";
+	}
+}
+
+// Appends lookup table of function [f] on [-range, range] with [tableSize] intervals.
+static void appendTable(std::string& text, const std::string& symbol, double (*f)(double), double range, int bits)
+{
+	text += "static const int32_t " + symbol + "[" + std::to_string(tableSize + 1) + "] = {";
+	for (int i = 0; i <= tableSize; i++)
+	{
+		text += (i % 8 == 0) ? "\n\t" : " ";
+		text += fixedLiteral(f(-range + 2.0 * range * i / tableSize), bits);
+		if (i < tableSize)
+			text += ",";
+	}
+	text += "\n};\n\n";
+}
+
+// Softplus used for fixed-point tables
+static double softplus(double x)
+{
+	return std::log1p(std::exp(x));
+}
+
+// Hyperbolic tangent used for fixed-point tables
+static double tangent(double x)
+{
+	return std::tanh(x);
+}
+
+// Returns upper case copy of the string.
+static std::string upper(const std::string& str)
+{
+	std::string res = str;
+	for (unsigned i = 0; i < res.size(); i++)
+		res[i] = (char)toupper((unsigned char)res[i]);
+
+	return res;
+}
+
+// Creates exporter, [name] is the prefix of generated symbols.
+CodeExporter::CodeExporter(const char* name)
+	: name(name), fixedPoint(false), fractionBits(16), unrollLimit(1024) {}
+
+// Returns C source of the forward pass of given layers. Throws std::invalid_argument for unsupported layers.
+std::string CodeExporter::source(const std::vector<NetLayer*>& layers) const
+{
+	if (layers.empty())
+		throw std::invalid_argument("CodeExporter: Network has no layers.");
+
+	if (fixedPoint && (fractionBits < 5 || fractionBits > 24))
+		throw std::invalid_argument("CodeExporter: Unsupported number of fraction bits.");
+
+	// forward operations
+	std::vector<Step> steps;
+	bool useTanh = false, useSoftplus = false;
+	for (unsigned i = 0; i < layers.size(); i++)
+	{
+		NetLayer* layer = layers[i];
+		Step step = { Step::Weights, (int)i, NULL };
+
+		if (WeightLayer* weightLayer = dynamic_cast<WeightLayer*>(layer))
+			step.params = &weightLayer->weights();
+		else if (BiasLayer* biasLayer = dynamic_cast<BiasLayer*>(layer))
+			step.kind = Step::Bias, step.params = &biasLayer->bias();
+		else if (dynamic_cast<TanhLayer*>(layer))
+			step.kind = Step::Tanh, useTanh = true;
+		else if (dynamic_cast<RectifierLayer*>(layer))
+			step.kind = Step::Rectifier;
+		else if (dynamic_cast<SoftplusLayer*>(layer))
+			step.kind = Step::Softplus, useSoftplus = true;
+		else if (DenseLayer* denseLayer = dynamic_cast<DenseLayer*>(layer))
+		{
+			// fused layer is emitted as separate steps
+			step.params = &denseLayer->weights();
+			steps.push_back(step);
+			step.kind = Step::Bias, step.params = &denseLayer->bias();
+			if (denseLayer->activation() == Matrix::Identity)
+			{
+				steps.push_back(step);
+				continue;
+			}
+
+			steps.push_back(step);
+			step.params = NULL;
+			if (denseLayer->activation() == Matrix::Tanh)
+				step.kind = Step::Tanh, useTanh = true;
+			else if (denseLayer->activation() == Matrix::Rectifier)
+				step.kind = Step::Rectifier;
+			else
+				step.kind = Step::Softplus, useSoftplus = true;
+		}
+		else if (dynamic_cast<InputLayer*>(layer) && i == 0)
+			continue;
+		else
+			throw std::invalid_argument("CodeExporter: Unsupported layer.");
+
+		steps.push_back(step);
+	}
+
+	const std::string type = fixedPoint ? "int32_t" : "float";
+	const std::string macro = upper(name);
+	const int inputs = layers.front()->size();
+	const int outputs = layers.back()->size();
+
+	// last layer computing from other buffer writes directly to the output, buffers hold any other output
+	// (element-wise steps on the input write to a buffer too)
+	int lastWeights = -1;
+	int bufferSize = inputs;
+	for (unsigned i = 0; i < steps.size(); i++)
+	{
+		if (steps[i].kind == Step::Weights)
+			lastWeights = (int)i;
+		bufferSize = std::max(bufferSize, layers[steps[i].index]->size());
+	}
+
+	std::string text;
+	append(text, "/* Forward pass of network %s generated by CodeExporter. */\n", name);
+	if (!fixedPoint && (useTanh || useSoftplus))
+		text += "#include <math.h>\n";
+	text += "#include <stdint.h>\n\n";
+
+	append(text, "#define %s_INPUTS %d\n", macro, inputs);
+	append(text, "#define %s_OUTPUTS %d\n", macro, outputs);
+	if (fixedPoint)
+		append(text, "#define %s_FRACTION_BITS %d\n", macro, fractionBits);
+	text += "\n";
+
+	// parameters
+	for (unsigned i = 0; i < steps.size(); i++)
+	{
+		const Step& step = steps[i];
+		if (step.kind == Step::Weights)
+		{
+			const Matrix& w = *step.params;
+			append(text, "static const %s ", type);
+			append(text, "%s_w%d[%d]", name, step.index, w.rows());
+			text += "[" + std::to_string(w.columns()) + "] = {\n";
+			for (int r = 0; r < w.rows(); r++)
+			{
+				text += "\t{ ";
+				appendRow(text, w, r, fixedPoint, fractionBits);
+				text += (r + 1 < w.rows()) ? " },\n" : " }\n";
+			}
+			text += "};\n\n";
+		}
+		else if (step.kind == Step::Bias)
+		{
+			const Matrix b = step.params->t();
+			append(text, "static const %s ", type);
+			append(text, "%s_b%d[%d] = { ", name, step.index, b.columns());
+			appendRow(text, b, 0, fixedPoint, fractionBits);
+			text += " };\n\n";
+		}
+	}
+
+	// fixed-point helpers
+	if (fixedPoint)
+	{
+		append(text, "/* Saturates 64-bit value to 32 bits. */\nstatic int32_t %s_sat(int64_t x)\n{\n", name);
+		text += "\treturn (x > INT32_MAX) ? INT32_MAX : ((x < INT32_MIN) ? INT32_MIN : (int32_t)x);\n}\n\n";
+
+		if (useTanh || useSoftplus)
+		{
+			append(text, "/* Interpolates lookup table covering [-range, range). */\n"
+				"static int32_t %s_lut(const int32_t* tab, int32_t x, int32_t range, int shift)\n{\n", name);
+			text += "\tconst uint32_t u = (uint32_t)((int64_t)x + range);\n";
+			text += "\tconst uint32_t i = u >> shift;\n";
+			text += "\tconst int64_t f = (int64_t)(u & ((1u << shift) - 1u));\n";
+			text += "\treturn tab[i] + (int32_t)(((int64_t)(tab[i + 1] - tab[i]) * f) >> shift);\n}\n\n";
+		}
+
+		if (useTanh)
+			appendTable(text, name + "_tanh", tangent, 4.0, fractionBits);
+
+		if (useSoftplus)
+			appendTable(text, name + "_softplus", softplus, 8.0, fractionBits);
+	}
+
+	// forward function
+	std::string body;
+	bool loops = false;
+	std::string src = "in";
+	for (unsigned i = 0; i < steps.size(); i++)
+	{
+		const Step& step = steps[i];
+		const int size = layers[step.index]->size();
+		const std::string idx = std::to_string(step.index);
+
+		std::string dst = src;
+		if (step.kind == Step::Weights || src == "in")
+			dst = ((int)i >= lastWeights) ? "out" : ((src == "a") ? "b" : "a");
+
+		const char* kinds[] = { "weights", "bias", "tanh", "rectifier", "softplus" };
+		append(body, "\n\t/* layer %s: %d ", idx, size);
+		append(body, "%s */\n", kinds[step.kind]);
+
+		if (step.kind == Step::Weights)
+		{
+			const int cols = step.params->columns();
+			const std::string w = name + "_w" + idx;
+
+			if ((long long)size * cols <= unrollLimit)
+			{
+				for (int r = 0; r < size; r++)
+				{
+					body += "\t" + dst + "[" + std::to_string(r) + "] = ";
+					body += fixedPoint ? name + "_sat((" : "";
+					for (int c = 0; c < cols; c++)
+					{
+						const std::string term = w + "[" + std::to_string(r) + "][" + std::to_string(c) + "] * " + src + "[" + std::to_string(c) + "]";
+						body += (c > 0) ? " + " : "";
+						body += fixedPoint ? "(int64_t)" + term : term;
+					}
+					if (fixedPoint)
+						append(body, " + %s) >> %d)", "(1 << " + std::to_string(fractionBits - 1) + ")", fractionBits);
+					body += ";\n";
+				}
+			}
+			else
+			{
+				loops = true;
+				append(body, "\tfor (i = 0; i < %s; i++)\n\t{\n", std::to_string(size));
+				body += fixedPoint ? "\t\tint64_t s = 0;\n" : "\t\tfloat s = 0.0f;\n";
+				append(body, "\t\tfor (k = 0; k < %s; k++)\n", std::to_string(cols));
+				body += fixedPoint ? "\t\t\ts += (int64_t)" : "\t\t\ts += ";
+				body += w + "[i][k] * " + src + "[k];\n";
+				if (fixedPoint)
+					append(body, "\t\t%s[i] = ", dst), append(body, "%s_sat((s + (1 << %d)) >> %d);\n\t}\n", name, fractionBits - 1, fractionBits);
+				else
+					body += "\t\t" + dst + "[i] = s;\n\t}\n";
+			}
+		}
+		else
+		{
+			loops = true;
+			const std::string x = src + "[i]";
+			std::string expr;
+			if (step.kind == Step::Bias)
+				expr = fixedPoint ? name + "_sat((int64_t)" + x + " + " + name + "_b" + idx + "[i])" : x + " + " + name + "_b" + idx + "[i]";
+			else if (step.kind == Step::Rectifier)
+				expr = "(" + x + " > 0) ? " + x + " : 0";
+			else if (step.kind == Step::Tanh && !fixedPoint)
+				expr = "tanhf(" + x + ")";
+			else if (step.kind == Step::Softplus && !fixedPoint)
+				expr = "(" + x + " > 20.0f) ? " + x + " : ((" + x + " < -20.0f) ? 0.0f : logf(expf(" + x + ") + 1.0f))";
+			else
+			{
+				// lookup table, saturated outside of its range
+				const int range = (step.kind == Step::Tanh) ? 4 : 8;
+				const int shift = fractionBits - ((step.kind == Step::Tanh) ? 5 : 4);
+				const std::string tab = name + ((step.kind == Step::Tanh) ? "_tanh" : "_softplus");
+				const std::string limit = "(" + std::to_string(range) + " << " + std::to_string(fractionBits) + ")";
+				expr = "(" + x + " <= -" + limit + ") ? " + tab + "[0] : ((" + x + " >= " + limit + ") ? "
+					+ ((step.kind == Step::Tanh) ? tab + "[" + std::to_string(tableSize) + "]" : x)
+					+ " : " + name + "_lut(" + tab + ", " + x + ", " + limit + ", " + std::to_string(shift) + "))";
+			}
+
+			append(body, "\tfor (i = 0; i < %s; i++)\n", std::to_string(size));
+			body += "\t\t" + dst + "[i] = " + expr + ";\n";
+		}
+
+		src = dst;
+	}
+
+	if (src == "in")
+	{
+		loops = true;
+		append(body, "\n\tfor (i = 0; i < %s; i++)\n\t\tout[i] = in[i];\n", std::to_string(outputs));
+	}
+
+	append(text, "/* Computes output of the network. */\nvoid %s_forward(", name);
+	append(text, "const %s* in, ", type);
+	append(text, "%s* out)\n{\n", type);
+	if (lastWeights > 0)
+	{
+		append(text, "\t%s a[%d], ", type, bufferSize);
+		text += "b[" + std::to_string(bufferSize) + "];\n";
+	}
+	if (loops)
+		text += "\tint i, k;\n\t(void)k;\n";
+	text += body;
+	text += "}\n";
+
+	return text;
+}
+
+// Writes C source of given layers to file. Returns false when the file cannot be written.
+bool CodeExporter::save(const char* filename, const std::vector<NetLayer*>& layers) const
+{
+	const std::string text = source(layers);
+
+	FILE* file = fopen(filename, "w");
+	if (!file)
+		return false;
+
+	bool ok = (fwrite(text.data(), 1, text.size(), file) == text.size());
+	ok = (fclose(file) == 0) && ok;
+	return ok;
+}
+
+// Returns C source of a test program, which includes generated source [sourceName], runs it on [inputs]
+// (one sample per column), compares results to [outputs] and measures latency. Program returns 0 when
+// maximal difference is within [tolerance].
+std::string CodeExporter::testSource(const char* sourceName, const Matrix& inputs, const Matrix& outputs, float tolerance) const
+{
+	if (inputs.columns() != outputs.columns() || inputs.columns() == 0)
+		throw std::invalid_argument("CodeExporter: Number of inputs and outputs differs.");
+
+	const std::string type = fixedPoint ? "int32_t" : "float";
+	const std::string macro = upper(name);
+	const Matrix in = inputs.t();
+	const Matrix out = outputs.t();
+
+	std::string text;
+	append(text, "/* Test of network %s generated by CodeExporter. */\n", name);
+	text += "#include <math.h>\n#include <stdio.h>\n#include <time.h>\n";
+	append(text, "#include \"%s\"\n\n", sourceName);
+
+	append(text, "static const float test_in[%s][", std::to_string(in.rows()));
+	append(text, "%s_INPUTS] = {\n", macro);
+	for (int r = 0; r < in.rows(); r++)
+	{
+		text += "\t{ ";
+		appendRow(text, in, r, false, 0);
+		text += " },\n";
+	}
+	text += "};\n\n";
+
+	append(text, "static const float test_out[%s][", std::to_string(out.rows()));
+	append(text, "%s_OUTPUTS] = {\n", macro);
+	for (int r = 0; r < out.rows(); r++)
+	{
+		text += "\t{ ";
+		appendRow(text, out, r, false, 0);
+		text += " },\n";
+	}
+	text += "};\n\n";
+
+	append(text, "int main(void)\n{\n\t%s in[", type);
+	append(text, "%s_INPUTS], out[", macro);
+	append(text, "%s_OUTPUTS];\n", macro);
+	text += "\tconst int count = sizeof(test_in) / sizeof(test_in[0]);\n";
+	append(text, "\tconst float scale = %s;\n", fixedPoint ? floatLiteral(std::ldexp(1.0f, fractionBits)) : std::string("1.0f"));
+	text += "\tfloat maxDiff = 0.0f;\n\tint mismatches = 0, n, i;\n\tlong runs = 0;\n\tvolatile float sink = 0.0f;\n\tclock_t start;\n\n";
+
+	// comparison
+	text += "\tfor (n = 0; n < count; n++)\n\t{\n";
+	append(text, "\t\tfor (i = 0; i < %s_INPUTS; i++)\n", macro);
+	append(text, "\t\t\tin[i] = (%s)", type);
+	text += fixedPoint ? "lrintf(test_in[n][i] * scale);\n" : "test_in[n][i];\n";
+	append(text, "\t\t%s_forward(in, out);\n", name);
+	append(text, "\t\tfor (i = 0; i < %s_OUTPUTS; i++)\n\t\t{\n", macro);
+	text += "\t\t\tconst float diff = fabsf((float)out[i] / scale - test_out[n][i]);\n";
+	text += "\t\t\tmaxDiff = (diff > maxDiff) ? diff : maxDiff;\n";
+	text += "\t\t\tmismatches += ((float)out[i] / scale != test_out[n][i]);\n\t\t}\n\t}\n\n";
+
+	// latency
+	text += "\tstart = clock();\n";
+	text += "\twhile (clock() - start < CLOCKS_PER_SEC / 2)\n\t{\n";
+	text += "\t\tfor (n = 0; n < count; n++, runs++)\n\t\t{\n";
+	append(text, "\t\t\tfor (i = 0; i < %s_INPUTS; i++)\n", macro);
+	append(text, "\t\t\t\tin[i] = (%s)", type);
+	text += fixedPoint ? "(test_in[n][i] * scale);\n" : "test_in[n][i];\n";
+	append(text, "\t\t\t%s_forward(in, out);\n", name);
+	text += "\t\t\tsink += (float)out[0];\n\t\t}\n\t}\n\n";
+
+	text += "\tprintf(\"samples %d, max difference %g, mismatches %d, latency %.1f ns\\n\", count, maxDiff, mismatches,\n";
+	text += "\t\t1e9 * (double)(clock() - start) / CLOCKS_PER_SEC / (double)runs);\n";
+	append(text, "\treturn (maxDiff <= %s) ? 0 : 1;\n}\n", floatLiteral(tolerance));
+
+	return text;
+}
+
+// Writes test program (see testSource()) to file. Returns false when the file cannot be written.
+bool CodeExporter::saveTest(const char* filename, const char* sourceName, const Matrix& inputs, const Matrix& outputs, float tolerance) const
+{
+	const std::string text = testSource(sourceName, inputs, outputs, tolerance);
+
+	FILE* file = fopen(filename, "w");
+	if (!file)
+		return false;
+
+	bool ok = (fwrite(text.data(), 1, text.size(), file) == text.size());
+	ok = (fclose(file) == 0) && ok;
+	return ok;
+}
@@ -0,0 +1,42 @@
+#ifndef _CODE_EXPORTER_H_
+#define _CODE_EXPORTER_H_
+
+#include "../Layers/NetLayer.h"
+#include <string>
+#include <vector>
+
+// Generates self-contained C source of the forward pass of a trained network (no library, no heap, no vtables).
+// Supported layers: InputLayer, WeightLayer, BiasLayer, TanhLayer, RectifierLayer, SoftplusLayer and DenseLayer.
+// Parameters are emitted as const arrays (placed to flash by MCU toolchains). Generated function is
+//	void <name>_forward(const float* in, float* out);
+// or, in fixed-point mode (Q format with [fractionBits] fractional bits, activations by lookup tables),
+//	void <name>_forward(const int32_t* in, int32_t* out);
+// Float variant performs the same operations in the same order as the library, so results are bit-exact
+// unless the compiler contracts multiply-add (use -ffp-contract=off).
+class CodeExporter
+{
+public:
+	// Creates exporter, [name] is the prefix of generated symbols.
+	CodeExporter(const char* name = "net");
+
+	// Returns C source of the forward pass of given layers. Throws std::invalid_argument for unsupported layers.
+	std::string source(const std::vector<NetLayer*>& layers) const;
+
+	// Writes C source of given layers to file. Returns false when the file cannot be written.
+	bool save(const char* filename, const std::vector<NetLayer*>& layers) const;
+
+	// Returns C source of a test program, which includes generated source [sourceName], runs it on [inputs]
+	// (one sample per column), compares results to [outputs] and measures latency. Program returns 0 when
+	// maximal difference is within [tolerance].
+	std::string testSource(const char* sourceName, const Matrix& inputs, const Matrix& outputs, float tolerance = 0.0f) const;
+
+	// Writes test program (see testSource()) to file. Returns false when the file cannot be written.
+	bool saveTest(const char* filename, const char* sourceName, const Matrix& inputs, const Matrix& outputs, float tolerance = 0.0f) const;
+
+	std::string name;	// prefix of generated symbols
+	bool fixedPoint;	// generate integer arithmetic only
+	int fractionBits;	// fractional bits of fixed-point values (5 - 24)
+	int unrollLimit;	// weight layers with at most this number of weights are fully unrolled
+};
+
+#endif // _CODE_EXPORTER_H_
@@ -0,0 +1,483 @@
+#include "DatasetReader.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+
+static const char magic[4] = { 'L', 'M', 'D', 'S' };
+static const uint32_t version = 1;
+static const size_t headerSize = 16;
+static const size_t textChunk = 1 << 20;
+static const int maxValueLength = 32;
+
+// Returns true when host stores numbers little-endian.
+static bool hostLittleEndian()
+{
+	const uint32_t x = 1;
+	unsigned char b;
+	memcpy(&b, &x, 1);
+	return (b == 1);
+}
+
+// Converts 32-bit words between little-endian and host order (in place).
+static void swapToHost(void* data, size_t count)
+{
+	if (hostLittleEndian())
+		return;
+
+	unsigned char* p = (unsigned char*)data;
+	for (size_t i = 0; i < count; i++, p += 4)
+	{
+		unsigned char t = p[0]; p[0] = p[3]; p[3] = t;
+		t = p[1]; p[1] = p[2]; p[2] = t;
+	}
+}
+
+// Parses number of CSV record (locale-independent, like MatrixText). Returns end of the number, [p] if invalid.
+static const char* parseValue(const char* p, const char* end, float& value)
+{
+	const char* start = (p < end && *p == '+') ? p + 1 : p;
+
+	std::from_chars_result res = std::from_chars(start, end, value);
+	if (res.ec == std::errc::invalid_argument)
+		return p;
+
+	if (res.ec == std::errc::result_out_of_range)
+	{
+		// overflow or underflow, strtof rounds to infinity or zero (value is copied, text need not be terminated)
+		char buf[maxValueLength + 1];
+		const size_t len = std::min((size_t)(res.ptr - start), (size_t)maxValueLength);
+		memcpy(buf, start, len);
+		buf[len] = '\0';
+		value = std::strtof(buf, NULL);
+	}
+
+	return res.ptr;
+}
+
+// Pool of batch buffers shared by the reader and batches handed out.
+struct DatasetReader::State
+{
+	// Batch buffer, returns to the pool when both views (inputs and targets) are released
+	struct Buffer
+	{
+		State* state;
+		float* data;
+		std::atomic<int> views;
+	};
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::vector<Buffer*> buffers;				// all buffers
+	std::vector<Buffer*> free;					// buffers to be filled
+	std::deque<std::pair<Buffer*, int> > ready;	// filled buffers and their sample counts
+	bool finished;								// reader reached the end of the data
+	bool stop;									// reader is requested to stop
+	std::exception_ptr error;					// exception raised by the reader
+	bool filling;								// reader holds a buffer
+	int usage;									// reader + buffers handed out
+	size_t floats;								// size of a buffer
+
+	State(int count, size_t floats)
+		: finished(false), stop(false), error(), filling(false), usage(1), floats(floats)
+	{
+		for (int i = 0; i < count; i++)
+			add();
+	}
+
+	// Adds new buffer to the pool (mutex must be locked if the reader runs)
+	void add()
+	{
+		Buffer* buf = new Buffer();
+		buf->state = this;
+		buf->data = new float[floats];
+		buf->views = 0;
+		buffers.push_back(buf);
+		free.push_back(buf);
+	}
+
+	~State()
+	{
+		for (unsigned i = 0; i < buffers.size(); i++)
+		{
+			delete[] buffers[i]->data;
+			delete buffers[i];
+		}
+	}
+
+	// Decreases usage, deletes the pool when not used anymore
+	void release()
+	{
+		bool last;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			last = (--usage == 0);
+		}
+
+		if (last)
+			delete this;
+	}
+
+	// Release function of batch matrices, context is the Buffer
+	static void releaseView(float* data, void* context)
+	{
+		Buffer* buf = static_cast<Buffer*>(context);
+		if (--buf->views > 0)
+			return;
+
+		State* state = buf->state;
+		{
+			std::lock_guard<std::mutex> lock(state->mutex);
+			state->free.push_back(buf);
+			state->cond.notify_all();
+		}
+
+		state->release();
+	}
+};
+
+// Opens given file and starts reading in background. Throws std::runtime_error when the file cannot be opened.
+DatasetReader::DatasetReader(const char* filename, Format format, int inputs, int targets, int batchSize,
+	int bufferCount, int shuffleWindow, unsigned seed)
+	: _file(NULL), _format(format), _inputs(inputs), _targets(targets), _batchSize(batchSize), _dataStart(0),
+	  _state(NULL), _thread(), _text(), _textPos(0), _textLen(0), _textEof(false),
+	  _window(), _windowCount(0), _random(seed)
+{
+	if (inputs <= 0 || targets < 0 || batchSize <= 0)
+		throw std::invalid_argument("DatasetReader: Invalid dimensions.");
+
+	_file = fopen(filename, (format == Binary) ? "rb" : "r");
+	if (!_file)
+		throw std::runtime_error("DatasetReader: Cannot open file.");
+
+	if (format == Binary)
+	{
+		unsigned char header[headerSize];
+		uint32_t fields[3];
+		if (fread(header, 1, headerSize, _file) != headerSize || memcmp(header, magic, 4) != 0)
+		{
+			fclose(_file);
+			throw std::runtime_error("DatasetReader: Invalid binary dataset.");
+		}
+
+		memcpy(fields, header + 4, sizeof(fields));
+		swapToHost(fields, 3);
+		if (fields[0] != version || (int)fields[1] != inputs || (int)fields[2] != targets)
+		{
+			fclose(_file);
+			throw std::runtime_error("DatasetReader: Dataset dimensions do not match.");
+		}
+
+		_dataStart = (long)headerSize;
+	}
+	else
+	{
+		_text.resize(textChunk + 1);
+	}
+
+	if (shuffleWindow > 1)
+		_window.resize((size_t)shuffleWindow * (inputs + targets));
+
+	if (bufferCount < 1)
+		bufferCount = 1;
+
+	_state = new State(bufferCount, (size_t)batchSize * (inputs + targets));
+	_start();
+}
+
+// Stops reading and closes the file. Batches may outlive the reader.
+DatasetReader::~DatasetReader()
+{
+	_stop();
+	fclose(_file);
+	_state->release();
+}
+
+// Starts background thread
+void DatasetReader::_start()
+{
+	_thread = std::thread(&DatasetReader::_run, this);
+}
+
+// Stops background thread
+void DatasetReader::_stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(_state->mutex);
+		_state->stop = true;
+		_state->cond.notify_all();
+	}
+
+	if (_thread.joinable())
+		_thread.join();
+
+	std::lock_guard<std::mutex> lock(_state->mutex);
+	_state->stop = false;
+}
+
+// Background thread loop
+void DatasetReader::_run()
+{
+	try
+	{
+		// initial fill of the shuffle window
+		const int windowSize = (int)(_window.size() / (_inputs + _targets));
+		if (windowSize > 0)
+			_windowCount = _readRecords(_window.data(), windowSize);
+
+		while (true)
+		{
+			State::Buffer* buf;
+			{
+				std::unique_lock<std::mutex> lock(_state->mutex);
+				_state->cond.wait(lock, [this] { return !_state->free.empty() || _state->stop; });
+				if (_state->stop)
+					return;
+
+				buf = _state->free.back();
+				_state->free.pop_back();
+				_state->filling = true;
+			}
+
+			const int count = _fill(buf->data);
+
+			std::lock_guard<std::mutex> lock(_state->mutex);
+			_state->filling = false;
+			if (count > 0)
+				_state->ready.push_back(std::make_pair(buf, count));
+			else
+				_state->free.push_back(buf);
+
+			if (count < _batchSize)
+				_state->finished = true;
+
+			_state->cond.notify_all();
+			if (_state->finished)
+				return;
+		}
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock(_state->mutex);
+		_state->error = std::current_exception();
+		_state->filling = false;
+		_state->finished = true;
+		_state->cond.notify_all();
+	}
+}
+
+// Fills the buffer with next (possibly shuffled) samples. Returns number of samples.
+int DatasetReader::_fill(float* dst)
+{
+	if (_window.empty())
+		return _readRecords(dst, _batchSize);
+
+	// draw random samples from the window and replace them by the new ones
+	const int rec = _inputs + _targets;
+	int count = 0;
+	while (count < _batchSize && _windowCount > 0)
+	{
+		const int j = (int)(_random() % (unsigned)_windowCount);
+		float* sample = &_window[(size_t)j * rec];
+		memcpy(dst + (size_t)count * rec, sample, rec * sizeof(float));
+		count++;
+
+		if (_readRecords(sample, 1) == 0)
+		{
+			// end of file, shrink the window
+			_windowCount--;
+			if (j != _windowCount)
+				memcpy(sample, &_window[(size_t)_windowCount * rec], rec * sizeof(float));
+		}
+	}
+
+	return count;
+}
+
+// Reads up to [count] records to [dst]. Returns number of records read.
+int DatasetReader::_readRecords(float* dst, int count)
+{
+	const int rec = _inputs + _targets;
+
+	if (_format == Binary)
+	{
+		const int res = (int)fread(dst, rec * sizeof(float), count, _file);
+		swapToHost(dst, (size_t)res * rec);
+		return res;
+	}
+
+	int res = 0;
+	while (res < count && _readLine(dst + (size_t)res * rec))
+		res++;
+
+	return res;
+}
+
+// Reads one CSV record. Returns false at the end of the file.
+bool DatasetReader::_readLine(float* dst)
+{
+	const int rec = _inputs + _targets;
+
+	while (true)
+	{
+		char* data = _text.data();
+		char* begin = data + _textPos;
+		char* end = (char*)memchr(begin, '\n', _textLen - _textPos);
+
+		if (!end)
+		{
+			if (!_textEof)
+			{
+				// move incomplete line to the beginning and read next chunk
+				const size_t rest = _textLen - _textPos;
+				if (rest + 1 >= _text.size())
+					_text.resize(_text.size() * 2); // line longer than the chunk
+
+				data = _text.data();
+				memmove(data, data + _textPos, rest);
+				_textPos = 0;
+				_textLen = rest + fread(data + rest, 1, _text.size() - rest - 1, _file);
+				_textEof = (_textLen < _text.size() - 1);
+				data[_textLen] = '\0';
+				continue;
+			}
+
+			if (_textPos >= _textLen)
+				return false;
+
+			end = data + _textLen; // last line without new line
+		}
+
+		_textPos = (end - data) + ((end < data + _textLen) ? 1 : 0);
+
+		// skip empty lines and lines not starting with a number (header, comments)
+		const char* p = begin;
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+			p++;
+
+		if (p >= end || !(isdigit((unsigned char)*p) || *p == '-' || *p == '+' || *p == '.'))
+			continue;
+
+		for (int i = 0; i < rec; i++)
+		{
+			while (p < end && (*p == ',' || *p == ';' || *p == ' ' || *p == '\t' || *p == '\r'))
+				p++;
+
+			const char* next = (p < end) ? parseValue(p, end, dst[i]) : p;
+			if (next == p)
+				throw std::runtime_error("DatasetReader: Invalid CSV line.");
+
+			p = next;
+		}
+
+		return true;
+	}
+}
+
+// Returns next batch (blocks until it is read). Last batch of the file may be smaller.
+bool DatasetReader::next(Batch& batch)
+{
+	State::Buffer* buf;
+	int count;
+	{
+		std::unique_lock<std::mutex> lock(_state->mutex);
+		while (_state->ready.empty() && !_state->finished)
+		{
+			// caller keeps all buffers, the pool grows instead of waiting forever
+			if (_state->free.empty() && !_state->filling)
+			{
+				_state->add();
+				_state->cond.notify_all();
+			}
+
+			_state->cond.wait(lock);
+		}
+
+		if (_state->error)
+		{
+			std::exception_ptr error = _state->error;
+			_state->error = std::exception_ptr();
+			std::rethrow_exception(error);
+		}
+
+		if (_state->ready.empty())
+			return false;
+
+		buf = _state->ready.front().first;
+		count = _state->ready.front().second;
+		_state->ready.pop_front();
+		_state->usage++;
+	}
+
+	// samples are stored record by record, i.e. column by column in the batch matrices
+	const int rec = _inputs + _targets;
+	buf->views = 2;
+	batch.inputs = Matrix((const float*)buf->data, _inputs, count, 1, rec, State::releaseView, buf);
+	batch.targets = Matrix((const float*)buf->data + _inputs, _targets, count, 1, rec, State::releaseView, buf);
+
+	return true;
+}
+
+// Restarts reading from the beginning of the file (next epoch).
+void DatasetReader::rewind()
+{
+	_stop();
+
+	{
+		std::lock_guard<std::mutex> lock(_state->mutex);
+		while (!_state->ready.empty())
+		{
+			_state->free.push_back(_state->ready.front().first);
+			_state->ready.pop_front();
+		}
+
+		_state->finished = false;
+		_state->error = std::exception_ptr();
+	}
+
+	fseek(_file, _dataStart, SEEK_SET);
+	_textPos = 0;
+	_textLen = 0;
+	_textEof = false;
+	_windowCount = 0;
+
+	_start();
+}
+
+// Writes samples (stored in columns) to a binary dataset file. Returns false when the file cannot be written.
+bool DatasetReader::writeBinary(const char* filename, const Matrix& inputs, const Matrix& targets)
+{
+	if (inputs.columns() != targets.columns() && !targets.empty())
+		throw std::invalid_argument("DatasetReader: Number of inputs and targets differs.");
+
+	FILE* file = fopen(filename, "wb");
+	if (!file)
+		return false;
+
+	uint32_t fields[3] = { version, (uint32_t)inputs.rows(), (uint32_t)targets.rows() };
+	swapToHost(fields, 3);
+
+	bool ok = (fwrite(magic, 1, 4, file) == 4) && (fwrite(fields, 4, 3, file) == 3);
+
+	std::vector<float> record(inputs.rows() + targets.rows());
+	for (int c = 0; c < inputs.columns() && ok; c++)
+	{
+		for (int r = 0; r < inputs.rows(); r++)
+			record[r] = inputs.at(r, c);
+
+		for (int r = 0; r < targets.rows(); r++)
+			record[inputs.rows() + r] = targets.at(r, c);
+
+		swapToHost(record.data(), record.size());
+		ok = (fwrite(record.data(), sizeof(float), record.size(), file) == record.size());
+	}
+
+	ok = (fclose(file) == 0) && ok;
+	return ok;
+}
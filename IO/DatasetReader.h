@@ -0,0 +1,105 @@
+#ifndef _DATASET_READER_H_
+#define _DATASET_READER_H_
+
+#include "../Matrix.h"
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <random>
+#include <cstdint>
+
+// Streams samples (input and target vectors) from a file and provides minibatches.
+// Reading and parsing runs on a background thread which fills a pool of buffers (double or triple buffering),
+// so that I/O overlaps with computation. Batch matrices wrap the buffers without copying, a buffer returns
+// to the pool when all matrices of its batch are released (the pool grows when the caller keeps all of them).
+//
+// Supported formats:
+//	- CSV: one sample per line, input values followed by target values. Delimiters ',', ';', tab or space.
+//	  Lines which do not start with a number (e.g. header) are skipped.
+//	- Binary: header (magic "LMDS", version, inputs, targets as little-endian uint32) followed by
+//	  records of little-endian floats (inputs followed by targets). See writeBinary().
+class DatasetReader
+{
+public:
+	// File format
+	enum Format { CSV, Binary };
+
+	// Minibatch of samples stored in columns.
+	struct Batch
+	{
+		Matrix inputs;		// inputs x size
+		Matrix targets;		// targets x size
+
+		// Returns number of samples in the batch.
+		int size() const { return inputs.columns(); }
+	};
+
+private:
+	struct State;
+
+	FILE* _file;
+	Format _format;
+	int _inputs;
+	int _targets;
+	int _batchSize;
+	long _dataStart;			// offset of the first sample in the file
+
+	State* _state;				// buffer pool shared with batches
+	std::thread _thread;		// background reader
+
+	std::vector<char> _text;	// CSV read chunk
+	size_t _textPos;
+	size_t _textLen;
+	bool _textEof;
+
+	std::vector<float> _window;	// shuffle window
+	int _windowCount;
+	std::mt19937 _random;
+
+	// Background thread loop
+	void _run();
+
+	// Reads up to [count] records to [dst]. Returns number of records read.
+	int _readRecords(float* dst, int count);
+
+	// Reads one CSV record. Returns false at the end of the file.
+	bool _readLine(float* dst);
+
+	// Fills the buffer with next (possibly shuffled) samples. Returns number of samples.
+	int _fill(float* dst);
+
+	// Starts and stops background thread
+	void _start();
+	void _stop();
+
+public:
+	// Opens given file and starts reading in background. Throws std::runtime_error when the file cannot be opened.
+	// [bufferCount] is the number of batch buffers (2 for double, 3 for triple buffering).
+	// When [shuffleWindow] > 1, samples are drawn randomly from a window of given number of samples.
+	DatasetReader(const char* filename, Format format, int inputs, int targets, int batchSize,
+		int bufferCount = 3, int shuffleWindow = 0, unsigned seed = 0);
+
+	// Stops reading and closes the file. Batches may outlive the reader.
+	~DatasetReader();
+
+	// Returns next batch (blocks until it is read). Last batch of the file may be smaller.
+	// Returns false at the end of the data. Rethrows exception raised by the background reader.
+	bool next(Batch& batch);
+
+	// Restarts reading from the beginning of the file (next epoch).
+	void rewind();
+
+	// Returns size of input vector.
+	int inputs() const { return _inputs; }
+
+	// Returns size of target vector.
+	int targets() const { return _targets; }
+
+	// Returns maximal number of samples in a batch.
+	int batchSize() const { return _batchSize; }
+
+	// Writes samples (stored in columns) to a binary dataset file. Returns false when the file cannot be written.
+	static bool writeBinary(const char* filename, const Matrix& inputs, const Matrix& targets);
+};
+
+#endif // _DATASET_READER_H_
@@ -0,0 +1,91 @@
+#include "MappedFile.h"
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define MAPPED_FILE_MMAP
+#endif
+
+// Use open() and release()
+MappedFile::MappedFile()
+	: _usage(1), _data(NULL), _size(0), _mapped(false) {}
+
+MappedFile::~MappedFile()
+{
+#ifdef MAPPED_FILE_MMAP
+	if (_mapped)
+	{
+		munmap(const_cast<char*>(_data), _size);
+		return;
+	}
+#endif
+
+	delete[] _data;
+}
+
+// Opens and maps given file. Returns NULL on failure. Returned object has usage 1.
+MappedFile* MappedFile::open(const char* filename)
+{
+#ifdef MAPPED_FILE_MMAP
+	int fd = ::open(filename, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0)
+	{
+		::close(fd);
+		return NULL;
+	}
+
+	void* addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // mapping stays valid
+
+	if (addr == MAP_FAILED)
+		return NULL;
+
+	MappedFile* file = new MappedFile();
+	file->_data = (const char*)addr;
+	file->_size = (size_t)st.st_size;
+	file->_mapped = true;
+	return file;
+#else
+	// read whole file at once
+	std::ifstream stream(filename, std::ios::binary | std::ios::ate);
+	if (!stream.is_open())
+		return NULL;
+
+	const std::streamoff size = stream.tellg();
+	if (size <= 0)
+		return NULL;
+
+	char* data = new char[(size_t)size];
+	stream.seekg(0);
+	if (!stream.read(data, size))
+	{
+		delete[] data;
+		return NULL;
+	}
+
+	MappedFile* file = new MappedFile();
+	file->_data = data;
+	file->_size = (size_t)size;
+	return file;
+#endif
+}
+
+// Decreases usage. Unmaps the file and destroys the object when not used anymore.
+void MappedFile::release()
+{
+	if (--_usage == 0)
+		delete this;
+}
+
+// Release function for matrices wrapping data of the file. Context is the MappedFile.
+void MappedFile::releaseMatrix(float* data, void* context)
+{
+	static_cast<MappedFile*>(context)->release();
+}
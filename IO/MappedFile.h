@@ -0,0 +1,44 @@
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <atomic>
+#include <cstddef>
+
+// Read-only file mapped to memory. Where memory mapping is not available, the file is read to heap at once.
+// Object is reference counted, matrices wrapping its data keep it alive (see releaseMatrix()).
+class MappedFile
+{
+private:
+	std::atomic<int> _usage;
+	const char* _data;
+	size_t _size;
+	bool _mapped;
+
+	// Use open() and release()
+	MappedFile();
+	~MappedFile();
+
+public:
+	// Opens and maps given file. Returns NULL on failure. Returned object has usage 1.
+	static MappedFile* open(const char* filename);
+
+	// Increases usage.
+	void retain() { ++_usage; }
+
+	// Decreases usage. Unmaps the file and destroys the object when not used anymore.
+	void release();
+
+	// Returns content of the file.
+	const char* data() const { return _data; }
+
+	// Returns size of the file in bytes.
+	size_t size() const { return _size; }
+
+	// Returns true when the file is memory mapped (false when read to heap).
+	bool mapped() const { return _mapped; }
+
+	// Release function for matrices wrapping data of the file. Context is the MappedFile.
+	static void releaseMatrix(float* data, void* context);
+};
+
+#endif // _MAPPED_FILE_H_
@@ -0,0 +1,297 @@
+#include "MatrixText.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+static const size_t minBytesPerThread = 1 << 20;
+static const size_t writeBufferSize = 1 << 16;
+static const int maxValueLength = 32;
+
+// Parsed part of the text
+struct Chunk
+{
+	std::vector<float> values;
+	int rows;
+	std::exception_ptr error;
+};
+
+// Returns true for characters separating values on a line.
+static inline bool isSeparator(char ch, char delimiter)
+{
+	return (ch == ' ' || ch == '\t' || ch == '\r' || ch == delimiter);
+}
+
+// Returns end of the line starting at [p] (position of new line or [end]).
+static inline const char* lineEnd(const char* p, const char* end)
+{
+	const char* eol = (const char*)memchr(p, '\n', end - p);
+	return eol ? eol : end;
+}
+
+// Parses one value starting at [p]. Returns position after the value.
+static const char* parseValue(const char* p, const char* eol, char delimiter, float& value)
+{
+	if (*p == '+')
+		p++;
+
+	std::from_chars_result res = std::from_chars(p, eol, value);
+	if (res.ec == std::errc::invalid_argument)
+		throw std::runtime_error("MatrixText: Invalid number.");
+
+	if (res.ec == std::errc::result_out_of_range)
+	{
+		// overflow or underflow, strtof rounds to infinity or zero (value is copied, text need not be terminated)
+		char buf[maxValueLength + 1];
+		const size_t len = std::min((size_t)(res.ptr - p), (size_t)maxValueLength);
+		memcpy(buf, p, len);
+		buf[len] = '\0';
+		value = std::strtof(buf, NULL);
+	}
+
+	if (res.ptr < eol && !isSeparator(*res.ptr, delimiter))
+		throw std::runtime_error("MatrixText: Invalid number.");
+
+	return res.ptr;
+}
+
+// Parses values of one line. Returns number of values.
+static int parseLine(const char* p, const char* eol, char delimiter, std::vector<float>* values)
+{
+	int count = 0;
+	while (true)
+	{
+		while (p < eol && isSeparator(*p, delimiter))
+			p++;
+
+		if (p == eol)
+			return count;
+
+		float value;
+		p = parseValue(p, eol, delimiter, value);
+		if (values)
+			values->push_back(value);
+
+		count++;
+	}
+}
+
+// Parses whole lines between [p] and [end], each non-empty line must have [cols] values.
+static void parseChunk(const char* p, const char* end, char delimiter, int cols, Chunk* chunk)
+{
+	try
+	{
+		chunk->values.reserve((end - p) / 8);
+		while (p < end)
+		{
+			const char* eol = lineEnd(p, end);
+			const int count = parseLine(p, eol, delimiter, &chunk->values);
+			if (count != 0 && count != cols)
+				throw std::runtime_error("MatrixText: Inconsistent number of columns.");
+
+			if (count != 0)
+				chunk->rows++;
+
+			p = eol + 1;
+		}
+	}
+	catch (...)
+	{
+		chunk->error = std::current_exception();
+	}
+}
+
+// Parses non-negative integer of the header line.
+static const char* parseDimension(const char* p, const char* eol, int& value)
+{
+	while (p < eol && (*p == ' ' || *p == '\t'))
+		p++;
+
+	std::from_chars_result res = std::from_chars(p, eol, value);
+	if (res.ec != std::errc() || value < 0)
+		throw std::runtime_error("MatrixText: Invalid header.");
+
+	return res.ptr;
+}
+
+// Appends row of the matrix to the text.
+static void formatRow(const Matrix& mat, int r, char delimiter, std::string& text)
+{
+	char buf[maxValueLength];
+	for (int c = 0; c < mat.columns(); c++)
+	{
+		std::to_chars_result res = std::to_chars(buf, buf + maxValueLength, mat.at(r, c));
+		text.append(buf, res.ptr - buf);
+		text.push_back((c + 1 < mat.columns()) ? delimiter : '\n');
+	}
+
+	if (mat.columns() == 0)
+		text.push_back('\n');
+}
+
+// Creates reader / writer with given value delimiter. When [header] is set, dimensions line is written and expected.
+MatrixText::MatrixText(char delimiter, bool header)
+	: delimiter(delimiter), header(header), threads(0) {}
+
+// Returns matrix formatted as text.
+std::string MatrixText::format(const Matrix& mat) const
+{
+	std::string text;
+	text.reserve((size_t)mat.rows() * mat.columns() * 12 + 32);
+
+	if (header)
+		text += std::to_string(mat.rows()) + delimiter + std::to_string(mat.columns()) + '\n';
+
+	for (int r = 0; r < mat.rows(); r++)
+		formatRow(mat, r, delimiter, text);
+
+	return text;
+}
+
+// Writes matrix to given file. Returns false when the file cannot be written.
+bool MatrixText::save(const char* filename, const Matrix& mat) const
+{
+	FILE* file = fopen(filename, "wb");
+	if (!file)
+		return false;
+
+	// format and write block of rows at once
+	std::string text;
+	text.reserve(writeBufferSize + (size_t)mat.columns() * maxValueLength);
+
+	if (header)
+		text += std::to_string(mat.rows()) + delimiter + std::to_string(mat.columns()) + '\n';
+
+	bool ok = true;
+	for (int r = 0; r < mat.rows() && ok; r++)
+	{
+		formatRow(mat, r, delimiter, text);
+		if (text.size() >= writeBufferSize)
+		{
+			ok = (fwrite(text.data(), 1, text.size(), file) == text.size());
+			text.clear();
+		}
+	}
+
+	ok = ok && (fwrite(text.data(), 1, text.size(), file) == text.size());
+	ok = (fclose(file) == 0) && ok;
+	return ok;
+}
+
+// Parses matrix from given text. Throws std::runtime_error when the text is malformed.
+// Without header, the number of columns is given by the first line and every line is a row.
+Matrix MatrixText::parse(const char* text, size_t length) const
+{
+	const char* p = text;
+	const char* end = text + length;
+	int rows = -1, cols = -1;
+
+	// dimensions
+	if (header)
+	{
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+			p++;
+
+		const char* eol = lineEnd(p, end);
+		p = parseDimension(p, eol, rows);
+		while (p < eol && isSeparator(*p, delimiter))
+			p++;
+
+		p = parseDimension(p, eol, cols);
+		if (parseLine(p, eol, delimiter, NULL) != 0)
+			throw std::runtime_error("MatrixText: Invalid header.");
+
+		p = (eol < end) ? eol + 1 : end;
+	}
+	else
+	{
+		// first non-empty line gives the number of columns
+		for (const char* q = p; q < end && cols <= 0; q = lineEnd(q, end) + 1)
+			cols = parseLine(q, lineEnd(q, end), delimiter, NULL);
+	}
+
+	if (cols <= 0 || rows == 0)
+	{
+		if (p < end && parseLine(p, lineEnd(p, end), delimiter, NULL) != 0)
+			throw std::runtime_error("MatrixText: Dimension mismatch.");
+
+		return Matrix(std::max(rows, 0), std::max(cols, 0));
+	}
+
+	// split to chunks of whole lines
+	int count = (threads > 0) ? threads : (int)std::thread::hardware_concurrency();
+	count = std::max(1, std::min(count, (int)((end - p) / minBytesPerThread)));
+
+	std::vector<const char*> bounds(1, p);
+	for (int t = 1; t < count; t++)
+	{
+		const char* b = p + (end - p) * t / count;
+		b = std::max(b, bounds.back());
+		b = std::min(lineEnd(b, end) + 1, end);
+		bounds.push_back(b);
+	}
+	bounds.push_back(end);
+
+	std::vector<Chunk> chunks(count);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < count; t++)
+	{
+		chunks[t].rows = 0;
+		if (t + 1 < count)
+			workers.push_back(std::thread(parseChunk, bounds[t], bounds[t + 1], delimiter, cols, &chunks[t]));
+		else
+			parseChunk(bounds[t], bounds[t + 1], delimiter, cols, &chunks[t]);
+	}
+
+	for (unsigned i = 0; i < workers.size(); i++)
+		workers[i].join();
+
+	// collect rows
+	int total = 0;
+	for (int t = 0; t < count; t++)
+	{
+		if (chunks[t].error)
+			std::rethrow_exception(chunks[t].error);
+
+		total += chunks[t].rows;
+	}
+
+	if (rows >= 0 && total != rows)
+		throw std::runtime_error("MatrixText: Dimension mismatch.");
+
+	float* data = new float[(size_t)total * cols];
+	size_t pos = 0;
+	for (int t = 0; t < count; t++)
+	{
+		memcpy(data + pos, chunks[t].values.data(), chunks[t].values.size() * sizeof(float));
+		pos += chunks[t].values.size();
+	}
+
+	return Matrix(data, total, cols, cols, 1, Matrix::deleteData);
+}
+
+// Reads matrix from given file (memory mapped). Throws std::runtime_error on failure.
+Matrix MatrixText::load(const char* filename) const
+{
+	MappedFile* file = MappedFile::open(filename);
+	if (!file)
+		throw std::runtime_error("MatrixText: Cannot open file.");
+
+	try
+	{
+		Matrix res = parse(file->data(), file->size());
+		file->release();
+		return res;
+	}
+	catch (...)
+	{
+		file->release();
+		throw;
+	}
+}
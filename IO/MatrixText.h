@@ -0,0 +1,35 @@
+#ifndef _MATRIX_TEXT_H_
+#define _MATRIX_TEXT_H_
+
+#include "../Matrix.h"
+#include <string>
+
+// Reads and writes matrices as text using std::to_chars / std::from_chars.
+// Values are written in the shortest form which parses back to the same float, so save and load is exact.
+// Layout is the one of Matrix stream operators: optional header line "rows cols" followed by one matrix row per line.
+// Large texts are parsed in parallel, each thread handles a chunk of whole lines.
+class MatrixText
+{
+public:
+	// Creates reader / writer with given value delimiter. When [header] is set, dimensions line is written and expected.
+	MatrixText(char delimiter = '\t', bool header = true);
+
+	// Returns matrix formatted as text.
+	std::string format(const Matrix& mat) const;
+
+	// Writes matrix to given file. Returns false when the file cannot be written.
+	bool save(const char* filename, const Matrix& mat) const;
+
+	// Parses matrix from given text. Throws std::runtime_error when the text is malformed.
+	// Without header, the number of columns is given by the first line and every line is a row.
+	Matrix parse(const char* text, size_t length) const;
+
+	// Reads matrix from given file (memory mapped). Throws std::runtime_error on failure.
+	Matrix load(const char* filename) const;
+
+	char delimiter;		// written between values, accepted besides white space when parsing
+	bool header;		// write and expect "rows cols" line
+	int threads;		// maximal number of parser threads (0 = number of hardware threads)
+};
+
+#endif // _MATRIX_TEXT_H_
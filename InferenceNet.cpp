@@ -0,0 +1,198 @@
+#include "InferenceNet.h"
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+// Allocates activations of given network for up to [batch] samples per request.
+InferenceNet::Context::Context(const InferenceNet& net, int batch)
+	: _batch(batch)
+{
+	if (batch <= 0)
+		throw std::invalid_argument("InferenceNet: Invalid batch size.");
+
+	_buffers[0].resize((size_t)net._bufferSize * batch);
+	_buffers[1].resize((size_t)net._bufferSize * batch);
+}
+
+// Compiles given network (parameters are copied). Throws std::invalid_argument for unsupported layers.
+InferenceNet::InferenceNet(const Net& net)
+	: _ops(), _params(), _inputs(0), _outputs(0), _bufferSize(1)
+{
+	const std::vector<NetLayer*>& layers = net.layers();
+	if (layers.empty())
+		throw std::invalid_argument("InferenceNet: Network has no layers.");
+
+	_inputs = layers.front()->size();
+	_outputs = layers.back()->size();
+
+	for (unsigned i = 0; i < layers.size(); i++)
+	{
+		NetLayer* layer = layers[i];
+
+		if (WeightLayer* weightLayer = dynamic_cast<WeightLayer*>(layer))
+			_add(Op::Weights, &weightLayer->weights());
+		else if (BiasLayer* biasLayer = dynamic_cast<BiasLayer*>(layer))
+			_add(Op::Bias, &biasLayer->bias());
+		else if (dynamic_cast<TanhLayer*>(layer))
+			_add(Op::Tanh, NULL);
+		else if (dynamic_cast<RectifierLayer*>(layer))
+			_add(Op::Rectifier, NULL);
+		else if (dynamic_cast<SoftplusLayer*>(layer))
+			_add(Op::Softplus, NULL);
+		else if (DenseLayer* denseLayer = dynamic_cast<DenseLayer*>(layer))
+		{
+			// fused layer is split to operations again
+			_add(Op::Weights, &denseLayer->weights());
+			_add(Op::Bias, &denseLayer->bias());
+			if (denseLayer->activation() == Matrix::Tanh)
+				_add(Op::Tanh, NULL);
+			else if (denseLayer->activation() == Matrix::Rectifier)
+				_add(Op::Rectifier, NULL);
+			else if (denseLayer->activation() == Matrix::Softplus)
+				_add(Op::Softplus, NULL);
+		}
+		else if (dynamic_cast<InputLayer*>(layer) && i == 0)
+			continue;
+		else
+			throw std::invalid_argument("InferenceNet: Unsupported layer.");
+	}
+}
+
+// Appends operation of given kind with given parameters (weights or bias), size is taken from the previous one
+void InferenceNet::_add(Op::Kind kind, const Matrix* params)
+{
+	const int size = _ops.empty() ? _inputs : _ops.back().rows;
+	Op op = { kind, params ? params->rows() : size, params ? params->columns() : 0, _params.size() };
+
+	// weights column by column (see _weights()), bias as is
+	if (params)
+	{
+		for (int c = 0; c < params->columns(); c++)
+			for (int r = 0; r < params->rows(); r++)
+				_params.push_back(params->at(r, c));
+	}
+
+	if (op.rows > _bufferSize)
+		_bufferSize = op.rows;
+
+	_ops.push_back(op);
+}
+
+// Computes dst = W * src for [count] samples stored one after another
+void InferenceNet::_weights(const Op& op, const float* src, float* dst, int count) const
+{
+	const float* w = &_params[op.offset];
+	const int rows = op.rows;
+	const int cols = op.cols;
+
+	// Columns of W scaled and accumulated (vectorizes), each element still accumulates in increasing inner index
+	// like the matrix product
+	for (int s = 0; s < count; s++)
+	{
+		const float* x = src + s * cols;
+		float* __restrict y = dst + s * rows;
+		for (int r = 0; r < rows; r++)
+			y[r] = 0.0f;
+
+		for (int p = 0; p < cols; p++)
+		{
+			const float* __restrict wp = w + p * rows;
+			const float xp = x[p];
+			for (int r = 0; r < rows; r++)
+				y[r] += wp[r] * xp;
+		}
+	}
+}
+
+// Runs network on [count] samples, uses buffers of [context], does not allocate.
+void InferenceNet::process(const float* in, float* out, Context& context, int count) const
+{
+	if (count > context._batch || context._buffers[0].size() < (size_t)_bufferSize * context._batch)
+		throw std::invalid_argument("InferenceNet: Context does not match the request.");
+
+	const float* cur = in;
+	int size = _inputs;
+	int next = 0;	// buffer to be written
+
+	for (unsigned i = 0; i < _ops.size(); i++)
+	{
+		const Op& op = _ops[i];
+		float* buf = &context._buffers[next][0];
+
+		if (op.kind == Op::Weights)
+		{
+			_weights(op, cur, buf, count);
+			cur = buf, size = op.rows, next = 1 - next;
+			continue;
+		}
+
+		// elementwise operations work in place, input is copied first
+		if (cur == in)
+		{
+			memcpy(buf, in, (size_t)count * size * sizeof(float));
+			cur = buf, next = 1 - next;
+		}
+
+		float* x = const_cast<float*>(cur);
+		const int n = count * size;
+		switch (op.kind)
+		{
+		case Op::Bias:
+		{
+			const float* b = &_params[op.offset];
+			for (int s = 0; s < count; s++)
+				for (int r = 0; r < size; r++)
+					x[s * size + r] = x[s * size + r] + b[r];
+			break;
+		}
+		case Op::Tanh:
+			for (int j = 0; j < n; j++)
+				x[j] = std::tanh(x[j]);
+			break;
+		case Op::Rectifier:
+			for (int j = 0; j < n; j++)
+				x[j] = (x[j] > 0.0f) ? x[j] : 0.0f;
+			break;
+		case Op::Softplus:
+			for (int j = 0; j < n; j++)
+			{
+				// same limits as softplus()
+				if (x[j] < -20.0f)
+					x[j] = 0.0f;
+				else if (x[j] <= 20.0f)
+					x[j] = std::log(std::exp(x[j]) + 1.0f);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	memmove(out, cur, (size_t)count * _outputs * sizeof(float));
+}
+
+// Runs network on batch of samples stored in columns of [in] (convenience, allocates result and context).
+Matrix InferenceNet::process(const Matrix& in) const
+{
+	if (in.rows() != _inputs)
+		throw std::invalid_argument("InferenceNet: Dimension mismatch.");
+
+	const int count = in.columns();
+	Context context(*this, count > 0 ? count : 1);
+
+	// samples are stored one after another
+	std::vector<float> input((size_t)count * _inputs), output((size_t)count * _outputs);
+	for (int s = 0; s < count; s++)
+		for (int j = 0; j < _inputs; j++)
+			input[s * _inputs + j] = in.at(j, s);
+
+	if (count > 0)
+		process(&input[0], &output[0], context, count);
+
+	Matrix res(_outputs, count);
+	for (int s = 0; s < count; s++)
+		for (int j = 0; j < _outputs; j++)
+			res.at(j, s) = output[s * _outputs + j];
+
+	return res;
+}
@@ -0,0 +1,73 @@
+#ifndef _INFERENCE_NET_H_
+#define _INFERENCE_NET_H_
+
+#include "Net.h"
+#include <vector>
+
+// Inference-only network compiled from a trained Net. Keeps only parameters (immutable, stored contiguously),
+// no errors, gradients or activations. Activations live in a Context owned by the caller, so one network can
+// serve many threads at once (one context per thread) and process() does not allocate any memory.
+// Supported layers: InputLayer, WeightLayer, BiasLayer, TanhLayer, RectifierLayer, SoftplusLayer and DenseLayer.
+// Results are bit-identical to Net::processInput().
+class InferenceNet
+{
+public:
+	// Preallocated activations of one thread. Create once, reuse for all requests.
+	class Context
+	{
+	private:
+		friend class InferenceNet;
+
+		std::vector<float> _buffers[2];
+		int _batch;
+
+	public:
+		// Allocates activations of given network for up to [batch] samples per request.
+		Context(const InferenceNet& net, int batch = 1);
+
+		// Returns maximal number of samples per request
+		int batch() const { return _batch; }
+	};
+
+private:
+	// Single operation of the forward pass
+	struct Op
+	{
+		enum Kind { Weights, Bias, Tanh, Rectifier, Softplus } kind;
+		int rows;			// output size
+		int cols;			// input size (weights only)
+		size_t offset;		// offset of parameters in _params
+	};
+
+	std::vector<Op> _ops;
+	std::vector<float> _params;		// weights (column by column) and biases of all operations
+	int _inputs;
+	int _outputs;
+	int _bufferSize;				// largest activation of a single sample
+
+	// Appends operation of given kind with given parameters (weights or bias), size is taken from the previous one
+	void _add(Op::Kind kind, const Matrix* params);
+
+	// Computes dst = W * src for [count] samples stored one after another
+	void _weights(const Op& op, const float* src, float* dst, int count) const;
+
+public:
+	// Compiles given network (parameters are copied). Throws std::invalid_argument for unsupported layers.
+	InferenceNet(const Net& net);
+
+	// Returns size of the input (one sample)
+	int inputs() const { return _inputs; }
+
+	// Returns size of the output (one sample)
+	int outputs() const { return _outputs; }
+
+	// Runs network on [count] samples in [in] (inputs() values per sample, one sample after another) and writes
+	// results to [out] (outputs() values per sample). Uses buffers of [context], does not allocate.
+	// Thread-safe for different contexts. Throws std::invalid_argument when [count] exceeds context batch.
+	void process(const float* in, float* out, Context& context, int count = 1) const;
+
+	// Runs network on batch of samples stored in columns of [in] (convenience, allocates result and context).
+	Matrix process(const Matrix& in) const;
+};
+
+#endif // _INFERENCE_NET_H_
@@ -9,6 +9,13 @@ BiasLayer::BiasLayer(int size, LearningRule* learnRule)
 	_gradient.clear();
 }
 
+// Constructs replica of given layer sharing its bias. Takes ownership of the learning rule.
+BiasLayer::BiasLayer(const BiasLayer& layer, LearningRule* learnRule)
+	: NetLayer(layer.size()), _bias(layer._bias), _gradient(layer.size(), 1), _batchSize(0), _learnRule(learnRule)
+{
+	_gradient.clear();
+}
+
 // Destructor
 BiasLayer::~BiasLayer()
 {
@@ -21,19 +28,19 @@ void BiasLayer::processInput()
 	if (!_prev)
 		throw std::runtime_error("BiasLayer: Missing previous layer.");
 
-	// Add bias
-	_output = _prev->output() + _bias;
+	// Add bias to each sample (column)
+	_output = Matrix::addToColumns(_prev->output(), _bias);
 }
 
-// updates error of the previous layer (call after each sample in batch).
+// updates error of the previous layer (call after each sample or batch of samples).
 void BiasLayer::processError()
 {
 	if (!_prev)
-		throw std::runtime_error("WeightLayer: Missing previous layer.");
+		throw std::runtime_error("BiasLayer: Missing previous layer.");
 
-	// Compute and accumulate gradient = dE/db = dE/dy * dy/db = err
-	_gradient += _error;
-	_batchSize++;
+	// Compute and accumulate gradient = dE/db = dE/dy * dy/db = err (summed over the samples)
+	_gradient += (_error.columns() == 1) ? _error : _error.sumColumns();
+	_batchSize += _error.columns();
 
 	// Backpropagate error err_prev = dE/dx = dE/dy * dy/dx = err
 	_prev->error() = _error;
@@ -42,7 +49,7 @@ void BiasLayer::processError()
 // Updates parameters (called after each batch).
 void BiasLayer::updateParameters()
 {
-	if (_batchSize > 0)
+	if (_batchSize > 0 && _learnRule)
 		_learnRule->update(_bias, _gradient / (float)_batchSize);
 
 	_gradient.clear();
@@ -50,6 +57,21 @@ void BiasLayer::updateParameters()
 }
 
 
+// Adds gradient accumulated by [layer] (BiasLayer) to own one and clears it in [layer].
+void BiasLayer::mergeGradients(NetLayer& layer)
+{
+	BiasLayer* other = dynamic_cast<BiasLayer*>(&layer);
+	if (!other || other->_gradient.size() != _gradient.size())
+		throw std::invalid_argument("BiasLayer: Layer to merge does not match.");
+
+	if (other->_batchSize > 0)
+		_gradient += other->_gradient;
+	_batchSize += other->_batchSize;
+
+	other->_gradient.clear();
+	other->_batchSize = 0;
+}
+
 // Reads parameters from given stream
 void BiasLayer::read(std::istream& stream)
 {
@@ -14,6 +14,9 @@ private:
 	
 	LearningRule* _learnRule;
 
+	// Constructs replica of given layer sharing its bias. Takes ownership of the learning rule.
+	BiasLayer(const BiasLayer& layer, LearningRule* learnRule);
+
 public:
 	// Constructs new bias layer with given size.
 	// Uses given learning rule and takes ownership of the given object.
@@ -25,7 +28,7 @@ public:
 	// updates output from input
 	virtual void processInput();
 
-	// updates error of the previous layer (call after each sample in batch).
+	// updates error of the previous layer (call after each sample or batch of samples).
 	virtual void processError();
 
 	// Updates parameters (called after each batch).
@@ -37,11 +40,29 @@ public:
 	// Returns learning rule
 	LearningRule* learningRule() const { return _learnRule; }
 
+	// Returns learning rules of the layer (learning rule of the bias)
+	virtual std::vector<LearningRule*> learningRules() const
+	{
+		return _learnRule ? std::vector<LearningRule*>(1, _learnRule) : std::vector<LearningRule*>();
+	}
+
 	// Reads parameters from given stream
 	virtual void read(std::istream& stream);
 
 	// Writes parameters to given stream
 	virtual void write(std::ostream& stream) const;
+
+	// Returns parameter matrices of the layer (bias).
+	virtual std::vector<Matrix*> parameters() { return std::vector<Matrix*>(1, &_bias); }
+
+	// Creates new layer of the same size sharing the parameters. Learning rule is cloned when [learning] is set.
+	virtual NetLayer* replicate(bool learning = false) const
+	{
+		return new BiasLayer(*this, (learning && _learnRule) ? _learnRule->clone() : NULL);
+	}
+
+	// Adds gradient accumulated by [layer] (BiasLayer) to own one and clears it in [layer].
+	virtual void mergeGradients(NetLayer& layer);
 };
 
 #endif //_BIAS_LAYER_H_
\ No newline at end of file
@@ -0,0 +1,244 @@
+#include "ConvolutionLayer.h"
+#include <algorithm>
+
+// Returns output size of the layer, throws std::invalid_argument for invalid geometry
+static int outputSize(const Window& window, int filters)
+{
+	if (!window.valid() || filters <= 0)
+		throw std::invalid_argument("ConvolutionLayer: Invalid geometry.");
+
+	return filters * window.positions();
+}
+
+// Constructs new convolution layer with given input geometry and number of filters.
+ConvolutionLayer::ConvolutionLayer(const Window& window, int filters, LearningRule* weightRule, LearningRule* biasRule)
+	: NetLayer(outputSize(window, filters)), _window(window), _filters(filters),
+	_weights(filters, window.channels * window.kernelHeight * window.kernelWidth), _bias(filters, 1),
+	_gradients(filters, window.channels * window.kernelHeight * window.kernelWidth), _gradient(filters, 1),
+	_batchSize(0), _offsets(), _samples(), _weightRule(weightRule), _biasRule(biasRule)
+{
+	_offsets = _window.offsets(true);
+
+	_weights.rand(-1.0f, 1.0f);
+	_bias.rand(-1.0f, 1.0f);
+	_gradients.clear();
+	_gradient.clear();
+}
+
+// Constructs replica of given layer sharing its weights and bias. Takes ownership of the learning rules.
+ConvolutionLayer::ConvolutionLayer(const ConvolutionLayer& layer, LearningRule* weightRule, LearningRule* biasRule)
+	: NetLayer(layer.size()), _window(layer._window), _filters(layer._filters), _weights(layer._weights),
+	_bias(layer._bias), _gradients(layer._gradients.rows(), layer._gradients.columns()), _gradient(layer._filters, 1),
+	_batchSize(0), _offsets(layer._offsets), _samples(), _weightRule(weightRule), _biasRule(biasRule)
+{
+	_gradients.clear();
+	_gradient.clear();
+}
+
+// Destructor
+ConvolutionLayer::~ConvolutionLayer()
+{
+	delete _weightRule;
+	delete _biasRule;
+}
+
+// Appends this layer to the specified layer (of the input size of the window).
+void ConvolutionLayer::appendTo(NetLayer* layer)
+{
+	if (layer && layer->size() != _window.inputSize())
+		throw std::invalid_argument("ConvolutionLayer: Size of the previous layer does not match the window.");
+
+	NetLayer::appendTo(layer);
+}
+
+// Copies input to _samples (sample by sample)
+void ConvolutionLayer::_gather(const Matrix& in)
+{
+	const int inputs = _window.inputSize();
+	const int count = in.columns();
+
+	_samples.resize((size_t)inputs * count);
+	for (int r = 0; r < inputs; r++)
+		for (int s = 0; s < count; s++)
+			_samples[(size_t)s * inputs + r] = in.at(r, s);
+}
+
+// Returns unfolded windows of _samples (im2col)
+Matrix ConvolutionLayer::_unfold(int count) const
+{
+	const int inputs = _window.inputSize();
+	const int positions = _window.positions();
+	const int elements = _weights.columns();
+
+	Matrix res(elements, positions * count);
+	for (int k = 0; k < elements; k++)
+	{
+		const int* offsets = &_offsets[(size_t)k * positions];
+		float* dst = &res.at(k, 0);
+		for (int s = 0; s < count; s++)
+		{
+			const float* x = &_samples[(size_t)s * inputs];
+			for (int p = 0; p < positions; p++)
+				(*dst++) = (offsets[p] < 0) ? 0.0f : x[offsets[p]];
+		}
+	}
+
+	return res;
+}
+
+// updates output from input
+void ConvolutionLayer::processInput()
+{
+	if (!_prev)
+		throw std::runtime_error("ConvolutionLayer: Missing previous layer.");
+
+	const Matrix& in = _prev->output();
+	const int positions = _window.positions();
+	const int count = in.columns();
+	_gather(in);
+
+	// Y = W * im2col(X), columns of Y ordered by sample and position
+	const Matrix& biases = _bias;
+	const Matrix product = _weights * _unfold(count);
+	Matrix res(size(), count);
+	for (int f = 0; f < _filters; f++)
+	{
+		const float bias = biases.at(f, 0);
+		for (int p = 0; p < positions; p++)
+		{
+			float* y = &res.at(f * positions + p, 0);
+			for (int s = 0; s < count; s++)
+				y[s] = product.at(f, s * positions + p) + bias;
+		}
+	}
+
+	_output = res;
+}
+
+// updates error of the previous layer and own gradients (call after each sample or batch of samples).
+void ConvolutionLayer::processError()
+{
+	if (!_prev)
+		throw std::runtime_error("ConvolutionLayer: Missing previous layer.");
+
+	const int inputs = _window.inputSize();
+	const int positions = _window.positions();
+	const int elements = _weights.columns();
+	const int count = _error.columns();
+
+	// 1. error of the filter outputs ordered like columns of im2col
+	const Matrix& error = _error;
+	Matrix delta(_filters, positions * count);
+	for (int f = 0; f < _filters; f++)
+	{
+		float* d = &delta.at(f, 0);
+		for (int p = 0; p < positions; p++)
+			for (int s = 0; s < count; s++)
+				d[s * positions + p] = error.at(f * positions + p, s);
+	}
+
+	// 2. accumulate gradients dE/dW = d * trans(im2col(x)) and dE/db = d (summed over samples and positions)
+	_gather(_prev->output());
+	_gradients += delta * _unfold(count).t();
+	_gradient += delta.sumColumns();
+	_batchSize += count;
+
+	// 3. backpropagate error of the windows trans(W) * d and fold it back to the inputs (col2im)
+	Matrix windows = _weights.t() * delta;
+	std::fill(_samples.begin(), _samples.end(), 0.0f);
+	for (int k = 0; k < elements; k++)
+	{
+		const int* offsets = &_offsets[(size_t)k * positions];
+		const float* src = &windows.at(k, 0);
+		for (int s = 0; s < count; s++)
+		{
+			float* e = &_samples[(size_t)s * inputs];
+			for (int p = 0; p < positions; p++, src++)
+				if (offsets[p] >= 0)
+					e[offsets[p]] += *src;
+		}
+	}
+
+	Matrix err(inputs, count);
+	for (int r = 0; r < inputs; r++)
+	{
+		float* e = &err.at(r, 0);
+		for (int s = 0; s < count; s++)
+			e[s] = _samples[(size_t)s * inputs + r];
+	}
+	_prev->error() = err;
+}
+
+// Updates parameters (called after each batch).
+void ConvolutionLayer::updateParameters()
+{
+	if (_batchSize > 0 && _weightRule)
+		_weightRule->update(_weights, _gradients / (float)_batchSize);
+
+	if (_batchSize > 0 && _biasRule)
+		_biasRule->update(_bias, _gradient / (float)_batchSize);
+
+	_gradients.clear();
+	_gradient.clear();
+	_batchSize = 0;
+}
+
+// Returns learning rules of the layer (weights followed by bias, missing ones skipped)
+std::vector<LearningRule*> ConvolutionLayer::learningRules() const
+{
+	std::vector<LearningRule*> res;
+	if (_weightRule)
+		res.push_back(_weightRule);
+	if (_biasRule)
+		res.push_back(_biasRule);
+	return res;
+}
+
+// Reads parameters from given stream (weights followed by bias)
+void ConvolutionLayer::read(std::istream& stream)
+{
+	stream >> _weights;
+	stream >> _bias;
+}
+
+// Writes parameters to given stream (weights followed by bias)
+void ConvolutionLayer::write(std::ostream& stream) const
+{
+	stream << _weights;
+	stream << _bias;
+}
+
+// Returns parameter matrices of the layer (weights and bias).
+std::vector<Matrix*> ConvolutionLayer::parameters()
+{
+	std::vector<Matrix*> res;
+	res.push_back(&_weights);
+	res.push_back(&_bias);
+	return res;
+}
+
+// Creates new layer of the same geometry sharing the parameters. Learning rules are cloned when [learning] is set.
+NetLayer* ConvolutionLayer::replicate(bool learning) const
+{
+	return new ConvolutionLayer(*this, (learning && _weightRule) ? _weightRule->clone() : NULL,
+		(learning && _biasRule) ? _biasRule->clone() : NULL);
+}
+
+// Adds gradients accumulated by [layer] (ConvolutionLayer) to own ones and clears them in [layer].
+void ConvolutionLayer::mergeGradients(NetLayer& layer)
+{
+	ConvolutionLayer* other = dynamic_cast<ConvolutionLayer*>(&layer);
+	if (!other || other->_gradients.size() != _gradients.size())
+		throw std::invalid_argument("ConvolutionLayer: Layer to merge does not match.");
+
+	if (other->_batchSize > 0)
+	{
+		_gradients += other->_gradients;
+		_gradient += other->_gradient;
+	}
+	_batchSize += other->_batchSize;
+
+	other->_gradients.clear();
+	other->_gradient.clear();
+	other->_batchSize = 0;
+}
@@ -0,0 +1,89 @@
+#ifndef _CONVOLUTION_LAYER_H_
+#define _CONVOLUTION_LAYER_H_
+
+#include "NetLayer.h"
+#include "Window.h"
+#include "../Learning/LearningRule.h"
+
+// Implements 1D or 2D convolution layer with bias: each filter is applied to all input channels of each window
+// position (see Window for stride, padding and dilation). Output of a sample has one channel per filter
+// (filter by filter, row by row, same layout as the input).
+// Input windows are unfolded to columns of a matrix (im2col), so forward and backward passes are products
+// computed by the blocked matrix product.
+class ConvolutionLayer : public NetLayer
+{
+private:
+	Window _window;
+	int _filters;
+	Matrix _weights;				// one filter per row (channel by channel, row by row)
+	Matrix _bias;					// one value per filter
+	Matrix _gradients;
+	Matrix _gradient;
+	int _batchSize;
+	std::vector<int> _offsets;		// input index of each window element and position (-1 in padding)
+	std::vector<float> _samples;	// input sample by sample
+
+	LearningRule* _weightRule;
+	LearningRule* _biasRule;
+
+	// Constructs replica of given layer sharing its weights and bias. Takes ownership of the learning rules.
+	ConvolutionLayer(const ConvolutionLayer& layer, LearningRule* weightRule, LearningRule* biasRule);
+
+	// Copies input to _samples (sample by sample)
+	void _gather(const Matrix& in);
+
+	// Returns unfolded windows of _samples: row for each window element, column for each sample and position
+	Matrix _unfold(int count) const;
+
+public:
+	// Constructs new convolution layer with given input geometry and number of filters. Takes ownership of
+	// the learning rules. Throws std::invalid_argument for invalid geometry.
+	ConvolutionLayer(const Window& window, int filters, LearningRule* weightRule, LearningRule* biasRule);
+
+	// Destructor
+	virtual ~ConvolutionLayer();
+
+	// Returns input geometry
+	const Window& window() const { return _window; }
+
+	// Returns number of filters (output channels)
+	int filters() const { return _filters; }
+
+	// Returns filters (one per row)
+	const Matrix& weights() const { return _weights; }
+
+	// Returns bias of the filters
+	const Matrix& bias() const { return _bias; }
+
+	// Returns learning rules of the layer (weights followed by bias, missing ones skipped)
+	virtual std::vector<LearningRule*> learningRules() const;
+
+	// Appends this layer to the specified layer (of the input size of the window).
+	virtual void appendTo(NetLayer* layer);
+
+	// updates output from input
+	virtual void processInput();
+
+	// updates error of the previous layer and own gradients (call after each sample or batch of samples).
+	virtual void processError();
+
+	// Updates parameters (called after each batch).
+	virtual void updateParameters();
+
+	// Reads parameters from given stream (weights followed by bias)
+	virtual void read(std::istream& stream);
+
+	// Writes parameters to given stream (weights followed by bias)
+	virtual void write(std::ostream& stream) const;
+
+	// Returns parameter matrices of the layer (weights and bias).
+	virtual std::vector<Matrix*> parameters();
+
+	// Creates new layer of the same geometry sharing the parameters. Learning rules are cloned when [learning] is set.
+	virtual NetLayer* replicate(bool learning = false) const;
+
+	// Adds gradients accumulated by [layer] (ConvolutionLayer) to own ones and clears them in [layer].
+	virtual void mergeGradients(NetLayer& layer);
+};
+
+#endif //_CONVOLUTION_LAYER_H_
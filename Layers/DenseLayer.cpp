@@ -0,0 +1,145 @@
+#include "DenseLayer.h"
+
+// Constructs new dense layer with given output size, activation and learning rules of weights and bias.
+DenseLayer::DenseLayer(int size, Matrix::Activation activation, LearningRule* weightRule, LearningRule* biasRule)
+	: NetLayer(size), _weights(), _bias(size, 1), _gradients(), _gradient(size, 1), _batchSize(0),
+	_activation(activation), _weightRule(weightRule), _biasRule(biasRule)
+{
+	_bias.rand(-1.0f, 1.0f);
+	_gradient.clear();
+}
+
+// Constructs replica of given layer sharing its weights and bias. Takes ownership of the learning rules.
+DenseLayer::DenseLayer(const DenseLayer& layer, LearningRule* weightRule, LearningRule* biasRule)
+	: NetLayer(layer.size()), _weights(layer._weights), _bias(layer._bias), _gradients(), _gradient(layer.size(), 1),
+	_batchSize(0), _activation(layer._activation), _weightRule(weightRule), _biasRule(biasRule)
+{
+	_gradient.clear();
+}
+
+// Destructor
+DenseLayer::~DenseLayer()
+{
+	delete _weightRule;
+	delete _biasRule;
+}
+
+// Appends this layer to the specified layer.
+void DenseLayer::appendTo(NetLayer* layer)
+{
+	// Use base method
+	NetLayer::appendTo(layer);
+
+	// Set the size of the layer
+	_gradients.resize(this->size(), _prev->size());
+	_gradients.clear();
+
+	// Initialize weights (unless shared by replicated layer)
+	if (_weights.rows() != this->size() || _weights.columns() != _prev->size())
+	{
+		_weights.resize(this->size(), _prev->size());
+		_weights.rand(-1.0f, 1.0f);
+	}
+}
+
+// updates output from input
+void DenseLayer::processInput()
+{
+	if (!_prev)
+		throw std::runtime_error("DenseLayer: Missing previous layer.");
+
+	// Y = act(W * X + b) in one pass over the result (one sample per column)
+	_output = Matrix::affine(_weights, _prev->output(), _bias, _activation);
+}
+
+// updates error of the previous layer and own gradients (call after each sample or batch of samples).
+void DenseLayer::processError()
+{
+	if (!_prev)
+		throw std::runtime_error("DenseLayer: Missing previous layer.");
+
+	// 1. error before activation d = act'(x) .* e
+	Matrix delta = Matrix::activationError(_output, _error, _activation);
+
+	// 2. accumulate gradients dE/dW = d * trans(x) and dE/db = d (summed over the columns of the batch)
+	_gradients += delta * _prev->output().t();
+	_gradient += (delta.columns() == 1) ? delta : delta.sumColumns();
+	_batchSize += delta.columns();
+
+	// 3. backpropagate error e_prev = trans(W) * d
+	_prev->error() = _weights.t() * delta;
+}
+
+// Updates parameters (called after each batch).
+void DenseLayer::updateParameters()
+{
+	if (_batchSize > 0 && _weightRule)
+		_weightRule->update(_weights, _gradients / (float)_batchSize);
+
+	if (_batchSize > 0 && _biasRule)
+		_biasRule->update(_bias, _gradient / (float)_batchSize);
+
+	_gradients.clear();
+	_gradient.clear();
+	_batchSize = 0;
+}
+
+// Returns learning rules of the layer (weights followed by bias, missing ones skipped)
+std::vector<LearningRule*> DenseLayer::learningRules() const
+{
+	std::vector<LearningRule*> res;
+	if (_weightRule)
+		res.push_back(_weightRule);
+	if (_biasRule)
+		res.push_back(_biasRule);
+	return res;
+}
+
+// Reads parameters from given stream (weights followed by bias)
+void DenseLayer::read(std::istream& stream)
+{
+	stream >> _weights;
+	stream >> _bias;
+}
+
+// Writes parameters to given stream (weights followed by bias, same as separate layers)
+void DenseLayer::write(std::ostream& stream) const
+{
+	stream << _weights;
+	stream << _bias;
+}
+
+// Returns parameter matrices of the layer (weights and bias).
+std::vector<Matrix*> DenseLayer::parameters()
+{
+	std::vector<Matrix*> res;
+	res.push_back(&_weights);
+	res.push_back(&_bias);
+	return res;
+}
+
+// Creates new layer of the same size sharing the parameters. Learning rules are cloned when [learning] is set.
+NetLayer* DenseLayer::replicate(bool learning) const
+{
+	return new DenseLayer(*this, (learning && _weightRule) ? _weightRule->clone() : NULL,
+		(learning && _biasRule) ? _biasRule->clone() : NULL);
+}
+
+// Adds gradients accumulated by [layer] (DenseLayer) to own ones and clears them in [layer].
+void DenseLayer::mergeGradients(NetLayer& layer)
+{
+	DenseLayer* other = dynamic_cast<DenseLayer*>(&layer);
+	if (!other || other->_gradients.size() != _gradients.size())
+		throw std::invalid_argument("DenseLayer: Layer to merge does not match.");
+
+	if (other->_batchSize > 0)
+	{
+		_gradients += other->_gradients;
+		_gradient += other->_gradient;
+	}
+	_batchSize += other->_batchSize;
+
+	other->_gradients.clear();
+	other->_gradient.clear();
+	other->_batchSize = 0;
+}
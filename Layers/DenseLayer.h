@@ -0,0 +1,76 @@
+#ifndef _DENSE_LAYER_H_
+#define _DENSE_LAYER_H_
+
+#include "NetLayer.h"
+#include "../Learning/LearningRule.h"
+
+// Fused dense layer: weights, bias and activation in one layer, Y = act(W * X + b). Forward pass is a single
+// product with bias and activation applied to the rows of the result (no intermediate outputs), backward pass
+// computes derivative of the activation in one pass before the products. See Net::fuse().
+// Results match WeightLayer, BiasLayer and activation layers exactly, except softplus derivative, which is
+// computed from the output.
+class DenseLayer : public NetLayer
+{
+private:
+	Matrix _weights;
+	Matrix _bias;
+	Matrix _gradients;
+	Matrix _gradient;
+	int _batchSize;
+	Matrix::Activation _activation;
+
+	LearningRule* _weightRule;
+	LearningRule* _biasRule;
+
+	// Constructs replica of given layer sharing its weights and bias. Takes ownership of the learning rules.
+	DenseLayer(const DenseLayer& layer, LearningRule* weightRule, LearningRule* biasRule);
+
+public:
+	// Constructs new dense layer with given output size, activation and learning rules of weights and bias.
+	// Takes ownership of the learning rules. Input size of the layer will be computed when appended to another layer.
+	DenseLayer(int size, Matrix::Activation activation, LearningRule* weightRule, LearningRule* biasRule);
+
+	// Destructor
+	virtual ~DenseLayer();
+
+	// Returns weight matrix
+	const Matrix& weights() const { return _weights; }
+
+	// Returns bias of the layer
+	const Matrix& bias() const { return _bias; }
+
+	// Returns activation function
+	Matrix::Activation activation() const { return _activation; }
+
+	// Returns learning rules of the layer (weights followed by bias, missing ones skipped)
+	virtual std::vector<LearningRule*> learningRules() const;
+
+	// Appends this layer to the specified layer.
+	virtual void appendTo(NetLayer* layer);
+
+	// updates output from input
+	virtual void processInput();
+
+	// updates error of the previous layer and own gradients (call after each sample or batch of samples).
+	virtual void processError();
+
+	// Updates parameters (called after each batch).
+	virtual void updateParameters();
+
+	// Reads parameters from given stream (weights followed by bias)
+	virtual void read(std::istream& stream);
+
+	// Writes parameters to given stream (weights followed by bias, same as separate layers)
+	virtual void write(std::ostream& stream) const;
+
+	// Returns parameter matrices of the layer (weights and bias).
+	virtual std::vector<Matrix*> parameters();
+
+	// Creates new layer of the same size sharing the parameters. Learning rules are cloned when [learning] is set.
+	virtual NetLayer* replicate(bool learning = false) const;
+
+	// Adds gradients accumulated by [layer] (DenseLayer) to own ones and clears them in [layer].
+	virtual void mergeGradients(NetLayer& layer);
+};
+
+#endif //_DENSE_LAYER_H_
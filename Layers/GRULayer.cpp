@@ -0,0 +1,83 @@
+#include "GRULayer.h"
+#include <cmath>
+
+// Returns logistic sigmoid of x
+static inline float logistic(float x)
+{
+	return 1.0f / (1.0f + std::exp(-x));
+}
+
+// Constructs new GRU layer with given output size and learning rules of weights and bias.
+GRULayer::GRULayer(int size, LearningRule* weightRule, LearningRule* biasRule)
+	: RecurrentLayer(size, 3, weightRule, biasRule), _values()
+{
+}
+
+// Starts window of given steps (allocates storage of the derived class)
+void GRULayer::_begin(int steps)
+{
+	_values = Matrix(4 * size(), steps * _sequences);
+}
+
+// Fused gate activations of given step
+void GRULayer::_forwardStep(int step, const float* pre, int stride, const float* rec, float* state)
+{
+	const int units = size();
+	const int sequences = _sequences;
+	const int valueStride = _values.columns();
+	float* values = &_values.at(0, step * sequences);
+
+	for (int r = 0; r < units; r++)
+	{
+		for (int s = 0; s < sequences; s++)
+		{
+			const float reset = logistic(pre[r * stride + s] + rec[r * sequences + s]);
+			const float update = logistic(pre[(units + r) * stride + s] + rec[(units + r) * sequences + s]);
+			const float projection = rec[(2 * units + r) * sequences + s];
+			const float n = std::tanh(pre[(2 * units + r) * stride + s] + reset * projection);
+
+			float& h = state[r * sequences + s];
+			h = (1.0f - update) * n + update * h;
+
+			values[r * valueStride + s] = reset;
+			values[(units + r) * valueStride + s] = update;
+			values[(2 * units + r) * valueStride + s] = n;
+			values[(3 * units + r) * valueStride + s] = projection;
+		}
+	}
+}
+
+// Backward pass of given step
+void GRULayer::_backwardStep(int step, float* error, float* pre, float* rec, int stride)
+{
+	const int units = size();
+	const int sequences = _sequences;
+	const Matrix& values = _values;
+	const Matrix& previous = _previous;
+	const int column = step * sequences;
+
+	for (int r = 0; r < units; r++)
+	{
+		for (int s = 0; s < sequences; s++)
+		{
+			const float reset = values.at(r, column + s);
+			const float update = values.at(units + r, column + s);
+			const float n = values.at(2 * units + r, column + s);
+			const float projection = values.at(3 * units + r, column + s);
+			const float h = previous.at(r, column + s);
+			const float e = error[r * sequences + s];
+
+			const float dn = e * (1.0f - update) * (1.0f - n * n);
+			const float dr = dn * projection * reset * (1.0f - reset);
+			const float dz = e * (h - n) * update * (1.0f - update);
+
+			pre[r * stride + s] = rec[r * stride + s] = dr;
+			pre[(units + r) * stride + s] = rec[(units + r) * stride + s] = dz;
+			pre[(2 * units + r) * stride + s] = dn;
+			rec[(2 * units + r) * stride + s] = dn * reset;
+
+			// part of the state kept by the update gate
+			error[r * sequences + s] = e * update;
+		}
+	}
+}
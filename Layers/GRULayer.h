@@ -0,0 +1,33 @@
+#ifndef _GRU_LAYER_H_
+#define _GRU_LAYER_H_
+
+#include "RecurrentLayer.h"
+
+// Gated recurrent unit layer (see RecurrentLayer). Gates are reset, update and candidate (in this order), reset
+// gate scales recurrent projection of the candidate so all gates share one recurrent product:
+// n = tanh(Wn * x + bn + sigmoid(r) .* (Un * h)), h = (1 - sigmoid(z)) .* n + sigmoid(z) .* h.
+class GRULayer : public RecurrentLayer
+{
+private:
+	Matrix _values;			// reset, update, candidate and recurrent projection of the candidate of each step
+							// of the last window (4 * size x steps * sequences)
+
+	// Starts window of given steps (allocates storage of the derived class)
+	virtual void _begin(int steps);
+
+	// Fused gate activations of given step
+	virtual void _forwardStep(int step, const float* pre, int stride, const float* rec, float* state);
+
+	// Backward pass of given step
+	virtual void _backwardStep(int step, float* error, float* pre, float* rec, int stride);
+
+	// Clears state of derived class (nothing to clear)
+	virtual void _resetState() {}
+
+public:
+	// Constructs new GRU layer with given output size and learning rules of weights and bias. Takes ownership of
+	// the learning rules. Input size of the layer will be computed when appended to another layer.
+	GRULayer(int size, LearningRule* weightRule, LearningRule* biasRule);
+};
+
+#endif //_GRU_LAYER_H_
@@ -21,6 +21,9 @@ public:
 
 	// Appends this layer to the specified layer.
 	virtual void appendTo(NetLayer* layer);
+
+	// Creates new layer of the same size.
+	virtual NetLayer* replicate(bool learning = false) const { return new InputLayer(size()); }
 };
 
 #endif // _INPUT_LAYER_H_
\ No newline at end of file
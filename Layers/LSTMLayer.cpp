@@ -0,0 +1,121 @@
+#include "LSTMLayer.h"
+#include <cmath>
+
+// Returns logistic sigmoid of x
+static inline float logistic(float x)
+{
+	return 1.0f / (1.0f + std::exp(-x));
+}
+
+// Constructs new LSTM layer with given output size and learning rules of weights and bias.
+LSTMLayer::LSTMLayer(int size, LearningRule* weightRule, LearningRule* biasRule)
+	: RecurrentLayer(size, 4, weightRule, biasRule), _cell(size, 1), _values(), _cells(), _cellError()
+{
+	_cell.clear();
+}
+
+// Starts window of given steps (allocates storage of the derived class)
+void LSTMLayer::_begin(int steps)
+{
+	const int units = size();
+	_values = Matrix(4 * units, steps * _sequences);
+	_cells = Matrix(units, (steps + 1) * _sequences);
+
+	const Matrix& cell = _cell;
+	for (int r = 0; r < units; r++)
+	{
+		float* dst = &_cells.at(r, 0);
+		for (int s = 0; s < _sequences; s++)
+			dst[s] = cell.at(r, s);
+	}
+}
+
+// Fused gate activations of given step
+void LSTMLayer::_forwardStep(int step, const float* pre, int stride, const float* rec, float* state)
+{
+	const int units = size();
+	const int sequences = _sequences;
+	const int valueStride = _values.columns();
+	const int cellStride = _cells.columns();
+	float* values = &_values.at(0, step * sequences);
+	float* cells = &_cells.at(0, (step + 1) * sequences);
+	float* cell = &_cell.at(0, 0);
+
+	for (int r = 0; r < units; r++)
+	{
+		for (int s = 0; s < sequences; s++)
+		{
+			const float i = logistic(pre[r * stride + s] + rec[r * sequences + s]);
+			const float f = logistic(pre[(units + r) * stride + s] + rec[(units + r) * sequences + s]);
+			const float g = std::tanh(pre[(2 * units + r) * stride + s] + rec[(2 * units + r) * sequences + s]);
+			const float o = logistic(pre[(3 * units + r) * stride + s] + rec[(3 * units + r) * sequences + s]);
+
+			const float c = f * cell[r * sequences + s] + i * g;
+			cell[r * sequences + s] = c;
+			cells[r * cellStride + s] = c;
+			state[r * sequences + s] = o * std::tanh(c);
+
+			values[r * valueStride + s] = i;
+			values[(units + r) * valueStride + s] = f;
+			values[(2 * units + r) * valueStride + s] = g;
+			values[(3 * units + r) * valueStride + s] = o;
+		}
+	}
+}
+
+// Backward pass of given step
+void LSTMLayer::_backwardStep(int step, float* error, float* pre, float* rec, int stride)
+{
+	const int units = size();
+	const int sequences = _sequences;
+	if (step == _steps - 1)
+	{
+		_cellError = Matrix(units, sequences);
+		_cellError.clear();
+	}
+
+	const Matrix& values = _values;
+	const Matrix& cells = _cells;
+	const int column = step * sequences;
+	float* cellError = &_cellError.at(0, 0);
+
+	for (int r = 0; r < units; r++)
+	{
+		for (int s = 0; s < sequences; s++)
+		{
+			const float i = values.at(r, column + s);
+			const float f = values.at(units + r, column + s);
+			const float g = values.at(2 * units + r, column + s);
+			const float o = values.at(3 * units + r, column + s);
+			const float c = cells.at(r, column + sequences + s);
+			const float tc = std::tanh(c);
+
+			// errors of the output and of the cell (from the state and from the next step)
+			const float e = error[r * sequences + s];
+			const float ec = cellError[r * sequences + s] + e * o * (1.0f - tc * tc);
+
+			const float di = ec * g * i * (1.0f - i);
+			const float df = ec * cells.at(r, column + s) * f * (1.0f - f);
+			const float dg = ec * i * (1.0f - g * g);
+			const float dout = e * tc * o * (1.0f - o);
+
+			pre[r * stride + s] = rec[r * stride + s] = di;
+			pre[(units + r) * stride + s] = rec[(units + r) * stride + s] = df;
+			pre[(2 * units + r) * stride + s] = rec[(2 * units + r) * stride + s] = dg;
+			pre[(3 * units + r) * stride + s] = rec[(3 * units + r) * stride + s] = dout;
+
+			// state reaches the previous step through the gates only, cell directly through the forget gate
+			cellError[r * sequences + s] = ec * f;
+			error[r * sequences + s] = 0.0f;
+		}
+	}
+}
+
+// Clears cell state
+void LSTMLayer::_resetState()
+{
+	_cell.resize(size(), _sequences);
+	_cell.clear();
+	_values = Matrix();
+	_cells = Matrix();
+}
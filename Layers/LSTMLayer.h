@@ -0,0 +1,37 @@
+#ifndef _LSTM_LAYER_H_
+#define _LSTM_LAYER_H_
+
+#include "RecurrentLayer.h"
+
+// Long short-term memory layer (see RecurrentLayer). Gates are input, forget, cell and output (in this order):
+// c = sigmoid(f) .* c + sigmoid(i) .* tanh(g), h = sigmoid(o) .* tanh(c).
+class LSTMLayer : public RecurrentLayer
+{
+private:
+	Matrix _cell;			// cell state of each sequence (size x sequences)
+	Matrix _values;			// gate values of each step of the last window (4 * size x steps * sequences)
+	Matrix _cells;			// cell state before and after each step of the last window (size x (steps + 1) * sequences)
+	Matrix _cellError;		// error of the cell state during backward pass
+
+	// Starts window of given steps (allocates storage of the derived class)
+	virtual void _begin(int steps);
+
+	// Fused gate activations of given step
+	virtual void _forwardStep(int step, const float* pre, int stride, const float* rec, float* state);
+
+	// Backward pass of given step
+	virtual void _backwardStep(int step, float* error, float* pre, float* rec, int stride);
+
+	// Clears cell state
+	virtual void _resetState();
+
+public:
+	// Constructs new LSTM layer with given output size and learning rules of weights and bias. Takes ownership of
+	// the learning rules. Input size of the layer will be computed when appended to another layer.
+	LSTMLayer(int size, LearningRule* weightRule, LearningRule* biasRule);
+
+	// Returns cell state of each sequence (size x sequences)
+	const Matrix& cell() const { return _cell; }
+};
+
+#endif //_LSTM_LAYER_H_
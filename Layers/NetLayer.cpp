@@ -2,7 +2,7 @@
 
 
 NetLayer::NetLayer(int size)
-	: _prev(), _next(), _output(size), _error(size) { }
+	: _prev(), _next(), _output(size), _error(size), _size(size) { }
 
 
 NetLayer::~NetLayer()
@@ -44,4 +44,22 @@ void NetLayer::appendTo(NetLayer* layer)
 
 	_prev = layer;
 	_prev->_next = this;
+}
+
+// Inserts this layer after the specified layer (between it and its next layer).
+void NetLayer::insertAfter(NetLayer* layer)
+{
+	if (!layer)
+		throw std::invalid_argument("NetLayer::insertAfter: argument cannot be null.");
+
+	// Append to the layer and connect its former next layer
+	NetLayer* next = layer->_next;
+	layer->_next = NULL;
+	appendTo(layer);
+
+	if (next)
+	{
+		_next = next;
+		next->_prev = this;
+	}
 }
\ No newline at end of file
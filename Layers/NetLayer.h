@@ -6,6 +6,8 @@
 #include <memory>
 #include <iostream>
 #include <string>
+#include <vector>
+#include <stdexcept>
 
 // Interface class for layers
 class NetLayer
@@ -16,6 +18,7 @@ protected:
 
 	Matrix _output;
 	Matrix _error;
+	int _size;
 
 public:
 	// Creates new layer with given output size and learn algorithm.
@@ -36,8 +39,8 @@ public:
 	Matrix& error() { return _error; }
 	const Matrix& error() const { return _error; }
 
-	// Size of the layer.
-	int size() const { return _output.rows(); }
+	// Size of the layer (kept when the output is released, see Net::setCheckpointInterval()).
+	int size() const { return _size; }
 
 	// Previous layer (or NULL if none).
 	NetLayer* prevLayer() const { return _prev; }
@@ -48,11 +51,14 @@ public:
 	// Appends this layer to the specified layer.
     virtual void appendTo(NetLayer* layer);
 
-	// Updates output from input. 
+	// Inserts this layer after the specified layer (between it and its next layer).
+	void insertAfter(NetLayer* layer);
+
+	// Updates output from input. Input may contain batch of samples stored in columns.
 	// Note: Derived class MUST implement.
 	virtual void processInput() = 0;
 
-	// Updates error of the previous layer (call after each sample in batch). 
+	// Updates error of the previous layer (call after each sample or batch of samples stored in columns). 
 	// Note: Derived class MUST implement.
 	virtual void processError() = 0;
 
@@ -65,6 +71,22 @@ public:
 
 	// Writes parameters to given stream.
 	virtual void write(std::ostream& stream) const { /* does nothing.*/ }
+
+	// Returns parameter matrices of the layer (used by binary serialization).
+	virtual std::vector<Matrix*> parameters() { return std::vector<Matrix*>(); }
+
+	// Returns learning rules of the layer (one per trained parameter matrix, empty if none). Checkpoint stores
+	// state of each of them.
+	virtual std::vector<LearningRule*> learningRules() const { return std::vector<LearningRule*>(); }
+
+	// Creates new layer of the same type and size (used for replicas of parallel trainers). Learning rule is cloned
+	// when [learning] is set, otherwise the replica has none. Replica shares parameters of the layer (copy-on-write),
+	// they are neither copied nor initialized again (std::rand is not called), see parameters().
+	// Throws std::runtime_error when the layer does not support it.
+	virtual NetLayer* replicate(bool learning = false) const { throw std::runtime_error("NetLayer: Layer cannot be replicated."); }
+
+	// Adds gradients accumulated by [layer] (of the same type) to own ones and clears them in [layer].
+	virtual void mergeGradients(NetLayer& layer) { /* no parameters. */ }
 };
 
 #endif
\ No newline at end of file
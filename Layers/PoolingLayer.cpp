@@ -0,0 +1,165 @@
+#include "PoolingLayer.h"
+#include <algorithm>
+
+// Returns output size of the layer, throws std::invalid_argument for invalid geometry
+static int outputSize(const Window& window)
+{
+	if (!window.valid())
+		throw std::invalid_argument("PoolingLayer: Invalid geometry.");
+
+	return window.channels * window.positions();
+}
+
+// Constructs new pooling layer with given input geometry.
+PoolingLayer::PoolingLayer(const Window& window, Mode mode)
+	: NetLayer(outputSize(window)), _window(window), _mode(mode), _offsets(window.offsets(false)),
+	_counts(window.positions(), 0), _samples(), _errors()
+{
+	const int positions = _window.positions();
+	const int elements = _window.kernelHeight * _window.kernelWidth;
+	for (int k = 0; k < elements; k++)
+		for (int p = 0; p < positions; p++)
+			if (_offsets[(size_t)k * positions + p] >= 0)
+				_counts[p]++;
+}
+
+// Appends this layer to the specified layer (of the input size of the window).
+void PoolingLayer::appendTo(NetLayer* layer)
+{
+	if (layer && layer->size() != _window.inputSize())
+		throw std::invalid_argument("PoolingLayer: Size of the previous layer does not match the window.");
+
+	NetLayer::appendTo(layer);
+}
+
+// Copies input to _samples (sample by sample)
+void PoolingLayer::_gather(const Matrix& in)
+{
+	const int inputs = _window.inputSize();
+	const int count = in.columns();
+
+	_samples.resize((size_t)inputs * count);
+	for (int r = 0; r < inputs; r++)
+		for (int s = 0; s < count; s++)
+			_samples[(size_t)s * inputs + r] = in.at(r, s);
+}
+
+// Returns input index of the maximum of given window of sample [x] (-1 when the window has no inputs)
+int PoolingLayer::_argmax(const float* x, int channel, int position) const
+{
+	const int positions = _window.positions();
+	const int elements = _window.kernelHeight * _window.kernelWidth;
+	const int plane = channel * _window.height * _window.width;
+
+	// first of equal maxima
+	int res = -1;
+	for (int k = 0; k < elements; k++)
+	{
+		const int offset = _offsets[(size_t)k * positions + position];
+		if (offset >= 0 && (res < 0 || x[plane + offset] > x[res]))
+			res = plane + offset;
+	}
+
+	return res;
+}
+
+// updates output from input
+void PoolingLayer::processInput()
+{
+	if (!_prev)
+		throw std::runtime_error("PoolingLayer: Missing previous layer.");
+
+	const Matrix& in = _prev->output();
+	const int inputs = _window.inputSize();
+	const int positions = _window.positions();
+	const int elements = _window.kernelHeight * _window.kernelWidth;
+	const int plane = _window.height * _window.width;
+	const int count = in.columns();
+	_gather(in);
+
+	Matrix res(size(), count);
+	for (int c = 0; c < _window.channels; c++)
+	{
+		for (int p = 0; p < positions; p++)
+		{
+			float* y = &res.at(c * positions + p, 0);
+			for (int s = 0; s < count; s++)
+			{
+				const float* x = &_samples[(size_t)s * inputs];
+				if (_mode == Max)
+				{
+					const int index = _argmax(x, c, p);
+					y[s] = (index < 0) ? 0.0f : x[index];
+					continue;
+				}
+
+				float sum = 0.0f;
+				for (int k = 0; k < elements; k++)
+				{
+					const int offset = _offsets[(size_t)k * positions + p];
+					if (offset >= 0)
+						sum += x[c * plane + offset];
+				}
+				y[s] = (_counts[p] > 0) ? sum / _counts[p] : 0.0f;
+			}
+		}
+	}
+
+	_output = res;
+}
+
+// updates error of the previous layer (call after each sample or batch of samples).
+void PoolingLayer::processError()
+{
+	if (!_prev)
+		throw std::runtime_error("PoolingLayer: Missing previous layer.");
+
+	const Matrix& error = _error;
+	const int inputs = _window.inputSize();
+	const int positions = _window.positions();
+	const int elements = _window.kernelHeight * _window.kernelWidth;
+	const int plane = _window.height * _window.width;
+	const int count = error.columns();
+	if (_mode == Max)
+		_gather(_prev->output());
+
+	// maximum passes error to its input, average spreads it evenly over the window
+	_errors.assign((size_t)inputs * count, 0.0f);
+	for (int c = 0; c < _window.channels; c++)
+	{
+		for (int p = 0; p < positions; p++)
+		{
+			for (int s = 0; s < count; s++)
+			{
+				const float e = error.at(c * positions + p, s);
+				float* dst = &_errors[(size_t)s * inputs];
+				if (_mode == Max)
+				{
+					const int index = _argmax(&_samples[(size_t)s * inputs], c, p);
+					if (index >= 0)
+						dst[index] += e;
+					continue;
+				}
+
+				if (_counts[p] == 0)
+					continue;
+				const float share = e / _counts[p];
+				for (int k = 0; k < elements; k++)
+				{
+					const int offset = _offsets[(size_t)k * positions + p];
+					if (offset >= 0)
+						dst[c * plane + offset] += share;
+				}
+			}
+		}
+	}
+
+	Matrix err(inputs, count);
+	for (int r = 0; r < inputs; r++)
+	{
+		float* e = &err.at(r, 0);
+		for (int s = 0; s < count; s++)
+			e[s] = _errors[(size_t)s * inputs + r];
+	}
+	_prev->error() = err;
+}
@@ -0,0 +1,57 @@
+#ifndef _POOLING_LAYER_H_
+#define _POOLING_LAYER_H_
+
+#include "NetLayer.h"
+#include "Window.h"
+
+// Implements 1D or 2D max or average pooling of each channel over windows (see Window). Output of a sample has
+// the same channels as the input (channel by channel, row by row). Padding is not part of any window: maximum
+// and average are taken over the inputs inside the window only (zero when there are none).
+// Backward pass finds maxima again from the input, so the layer keeps no state between passes.
+class PoolingLayer : public NetLayer
+{
+public:
+	// Pooling function
+	enum Mode { Max, Average };
+
+private:
+	Window _window;
+	Mode _mode;
+	std::vector<int> _offsets;		// index of each window element and position within a channel (-1 in padding)
+	std::vector<int> _counts;		// number of inputs in the window at each position
+	std::vector<float> _samples;	// input sample by sample
+	std::vector<float> _errors;		// error of the input sample by sample
+
+	// Copies input to _samples (sample by sample)
+	void _gather(const Matrix& in);
+
+	// Returns input index of the maximum of given window of sample [x] (-1 when the window has no inputs)
+	int _argmax(const float* x, int channel, int position) const;
+
+public:
+	// Constructs new pooling layer with given input geometry. Throws std::invalid_argument for invalid geometry.
+	PoolingLayer(const Window& window, Mode mode);
+
+	// Returns input geometry
+	const Window& window() const { return _window; }
+
+	// Returns pooling function
+	Mode mode() const { return _mode; }
+
+	// Appends this layer to the specified layer (of the input size of the window).
+	virtual void appendTo(NetLayer* layer);
+
+	// updates output from input
+	virtual void processInput();
+
+	// updates error of the previous layer (call after each sample or batch of samples).
+	virtual void processError();
+
+	// Updates parameters (called after each batch).
+	virtual void updateParameters() { /* No parameters to update. */ }
+
+	// Creates new layer of the same geometry.
+	virtual NetLayer* replicate(bool learning = false) const { return new PoolingLayer(_window, _mode); }
+};
+
+#endif //_POOLING_LAYER_H_
@@ -0,0 +1,182 @@
+#include "QuantizedLayer.h"
+#include <cmath>
+#include <algorithm>
+
+// Returns [x] rounded and clamped to the symmetric 8-bit range
+static inline int8_t quantize(float x)
+{
+	const float q = std::nearbyint(x);
+	return (int8_t)((q > 127.0f) ? 127.0f : (q < -127.0f) ? -127.0f : q);
+}
+
+// Computes sums[j * count + s] = row j of [w] * sample s of [x] for first [block] of [rows] (up to 4) rows,
+// [count] samples and [cols] inputs. Four rows are always computed, missing ones repeat the first row.
+template <class T>
+static void accumulate(const T* w, const int16_t* x, int32_t* sums, int rows, int block, int cols, int count)
+{
+	const T* __restrict w0 = w;
+	const T* __restrict w1 = (rows > 1) ? w0 + cols : w0;
+	const T* __restrict w2 = (rows > 2) ? w1 + cols : w0;
+	const T* __restrict w3 = (rows > 3) ? w2 + cols : w0;
+
+	for (int s = 0; s < count; s++)
+	{
+		const int16_t* __restrict xs = x + (size_t)s * cols;
+		int32_t a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+		for (int c = 0; c < cols; c++)
+		{
+			a0 += w0[c] * xs[c];
+			a1 += w1[c] * xs[c];
+			a2 += w2[c] * xs[c];
+			a3 += w3[c] * xs[c];
+		}
+
+		const int32_t res[4] = { a0, a1, a2, a3 };
+		for (int j = 0; j < block; j++)
+			sums[(size_t)j * count + s] = res[j];
+	}
+}
+
+// Constructs layer from trained weights, bias and activation.
+QuantizedLayer::QuantizedLayer(const Matrix& weights, const Matrix& bias, Matrix::Activation activation, float inputRange)
+	: NetLayer(weights.rows()), _weights((size_t)weights.rows() * weights.columns()), _scales(weights.rows()),
+	_inputs(), _rows(), _sums(), _bias(weights.rows(), 1), _columns(weights.columns()), _inputScale(1.0f), _activation(activation)
+{
+	if (!bias.empty() && (bias.rows() != weights.rows() || bias.columns() != 1))
+		throw std::invalid_argument("QuantizedLayer: Bias does not match weights.");
+
+	// symmetric scale of each row, zero row keeps unit scale
+	for (int r = 0; r < weights.rows(); r++)
+	{
+		float range = 0.0f;
+		for (int c = 0; c < _columns; c++)
+			range = std::max(range, std::fabs(weights.at(r, c)));
+
+		_scales[r] = (range > 0.0f) ? range / 127.0f : 1.0f;
+		for (int c = 0; c < _columns; c++)
+			_weights[(size_t)r * _columns + c] = quantize(weights.at(r, c) / _scales[r]);
+	}
+
+	if (bias.empty())
+		_bias.clear();
+	else
+		_bias = bias;
+
+	if (inputRange > 0.0f)
+		_inputScale = inputRange / 127.0f;
+}
+
+// Returns weights converted back to float
+Matrix QuantizedLayer::weights() const
+{
+	Matrix res(size(), _columns);
+	for (int r = 0; r < size(); r++)
+		for (int c = 0; c < _columns; c++)
+			res.at(r, c) = _scales[r] * _weights[(size_t)r * _columns + c];
+
+	return res;
+}
+
+// Appends this layer to the specified layer (of the input size of the weights).
+void QuantizedLayer::appendTo(NetLayer* layer)
+{
+	if (layer && layer->size() != _columns)
+		throw std::invalid_argument("QuantizedLayer: Size of the previous layer does not match weights.");
+
+	NetLayer::appendTo(layer);
+}
+
+// Quantizes [count] samples of the input to _inputs
+void QuantizedLayer::_quantizeInput(const Matrix& in)
+{
+	const int count = in.columns();
+	const float inv = 1.0f / _inputScale;
+
+	_inputs.resize((size_t)count * _columns);
+	for (int s = 0; s < count; s++)
+	{
+		int16_t* x = &_inputs[(size_t)s * _columns];
+		for (int c = 0; c < _columns; c++)
+			x[c] = quantize(in.at(c, s) * inv);
+	}
+}
+
+// updates output from input
+void QuantizedLayer::processInput()
+{
+	if (!_prev)
+		throw std::runtime_error("QuantizedLayer: Missing previous layer.");
+
+	const Matrix& in = _prev->output();
+	if (in.rows() != _columns)
+		throw std::invalid_argument("QuantizedLayer: Input size does not match weights.");
+
+	const int rows = size();
+	const int cols = _columns;
+	const int count = in.columns();
+	_quantizeInput(in);
+
+	// 32-bit sums of products, four rows of weights at once share loads of the input (vectorizes).
+	// For larger batches the rows are widened to 16 bits once (values stay within 8 bits), so that pairs of
+	// products are summed by a single instruction.
+	_sums.resize((size_t)rows * count);
+	for (int r = 0; r < rows; r += 4)
+	{
+		const int block = std::min(4, rows - r);
+		if (count >= 4)
+		{
+			_rows.resize((size_t)4 * cols);
+			for (int c = 0; c < 4 * cols; c++)
+				_rows[c] = (c < block * cols) ? _weights[(size_t)r * cols + c] : 0;
+			accumulate(&_rows[0], &_inputs[0], &_sums[(size_t)r * count], 4, block, cols, count);
+		}
+		else
+			accumulate(&_weights[(size_t)r * cols], &_inputs[0], &_sums[(size_t)r * count], block, block, cols, count);
+	}
+
+	// conversion to float, bias and activation in one pass over each row (same formulas as Matrix::affine())
+	Matrix res(rows, count);
+	for (int r = 0; r < rows; r++)
+	{
+		const int32_t* sums = &_sums[(size_t)r * count];
+		const float scale = _scales[r] * _inputScale;
+		const float bias = _bias.at(r, 0);
+		float* __restrict y = &res.at(r, 0);
+
+		switch (_activation)
+		{
+		case Matrix::Identity:
+			for (int s = 0; s < count; s++)
+				y[s] = sums[s] * scale + bias;
+			break;
+		case Matrix::Tanh:
+			for (int s = 0; s < count; s++)
+				y[s] = std::tanh(sums[s] * scale + bias);
+			break;
+		case Matrix::Rectifier:
+			for (int s = 0; s < count; s++)
+			{
+				const float v = sums[s] * scale + bias;
+				y[s] = (v > 0.0f) ? v : 0.0f;
+			}
+			break;
+		case Matrix::Softplus:
+			for (int s = 0; s < count; s++)
+			{
+				const float v = sums[s] * scale + bias;
+				if (v > 20.0f)			y[s] = v;
+				else if (v < -20.0f)	y[s] = 0.0f;
+				else					y[s] = std::log(std::exp(v) + 1.0f);
+			}
+			break;
+		}
+	}
+
+	_output = res;
+}
+
+// Throws std::runtime_error, layer cannot be trained.
+void QuantizedLayer::processError()
+{
+	throw std::runtime_error("QuantizedLayer: Layer cannot be trained.");
+}
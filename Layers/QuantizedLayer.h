@@ -0,0 +1,58 @@
+#ifndef _QUANTIZED_LAYER_H_
+#define _QUANTIZED_LAYER_H_
+
+#include "NetLayer.h"
+#include <cstdint>
+
+// Inference-only dense layer with 8-bit weights and inputs, Y = act(W * X + b). See Net::quantize().
+// Weights are quantized symmetrically per output channel (row), inputs per tensor with a scale calibrated on
+// sample data (values outside the calibrated range are clamped). Products are accumulated in 32-bit integers,
+// conversion back to float is fused with bias and activation. Weights take a quarter of the float memory.
+// The layer cannot be trained and its parameters are not saved (quantize after loading the network).
+class QuantizedLayer : public NetLayer
+{
+private:
+	std::vector<int8_t> _weights;		// quantized weights (row by row)
+	std::vector<float> _scales;			// scale of each row of weights
+	std::vector<int16_t> _inputs;		// quantized inputs (sample by sample, widened)
+	std::vector<int16_t> _rows;			// block of rows of weights (widened)
+	std::vector<int32_t> _sums;			// accumulated products (sample by sample)
+	Matrix _bias;
+	int _columns;						// input size
+	float _inputScale;
+	Matrix::Activation _activation;
+
+	// Quantizes [count] samples of the input to _inputs
+	void _quantizeInput(const Matrix& in);
+
+public:
+	// Constructs layer from trained [weights], [bias] (column vector or empty for none) and [activation].
+	// Inputs are expected within [-inputRange, inputRange] (e.g. largest absolute input over calibration samples).
+	QuantizedLayer(const Matrix& weights, const Matrix& bias, Matrix::Activation activation, float inputRange);
+
+	// Returns scale of given row of weights (weight = scale * quantized weight)
+	float weightScale(int row) const { return _scales[row]; }
+
+	// Returns scale of inputs (input = scale * quantized input)
+	float inputScale() const { return _inputScale; }
+
+	// Returns activation function
+	Matrix::Activation activation() const { return _activation; }
+
+	// Returns weights converted back to float (e.g. to measure quantization error)
+	Matrix weights() const;
+
+	// Appends this layer to the specified layer (of the input size of the weights).
+	virtual void appendTo(NetLayer* layer);
+
+	// updates output from input
+	virtual void processInput();
+
+	// Throws std::runtime_error, layer cannot be trained.
+	virtual void processError();
+
+	// Updates parameters (called after each batch).
+	virtual void updateParameters() { /* not trained. */ }
+};
+
+#endif // _QUANTIZED_LAYER_H_
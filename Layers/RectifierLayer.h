@@ -18,6 +18,9 @@ public:
 
 	// Updates parameters (called after each batch).
 	virtual void updateParameters() { /* No parameters to update. */ }
+
+	// Creates new layer of the same size.
+	virtual NetLayer* replicate(bool learning = false) const { return new RectifierLayer(size()); }
 };
 
 #endif //_RECTIFIER_LAYER_H_
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "RecurrentLayer.h"
+#include <algorithm>
+
+// Constructs new recurrent layer with given output size and number of gates.
+RecurrentLayer::RecurrentLayer(int size, int gates, LearningRule* weightRule, LearningRule* biasRule)
+	: NetLayer(size), _gates(gates), _sequences(1), _steps(0), _inputWeights(), _stateWeights(gates * size, size),
+	_bias(gates * size, 1), _inputGradients(), _stateGradients(gates * size, size), _gradient(gates * size, 1),
+	_batchSize(0), _state(size, 1), _previous(), _inputRule(weightRule),
+	_stateRule(weightRule ? weightRule->clone() : NULL), _biasRule(biasRule)
+{
+	_stateWeights.rand(-1.0f, 1.0f);
+	_bias.rand(-1.0f, 1.0f);
+	_stateGradients.clear();
+	_gradient.clear();
+	_state.clear();
+}
+
+// Destructor
+RecurrentLayer::~RecurrentLayer()
+{
+	delete _inputRule;
+	delete _stateRule;
+	delete _biasRule;
+}
+
+// Clears state and sets number of sequences processed in parallel.
+void RecurrentLayer::reset(int sequences)
+{
+	if (sequences <= 0)
+		throw std::invalid_argument("RecurrentLayer: Invalid number of sequences.");
+
+	_sequences = sequences;
+	_state.resize(size(), sequences);
+	_state.clear();
+	_previous = Matrix();
+	_steps = 0;
+	_resetState();
+}
+
+// Appends this layer to the specified layer.
+void RecurrentLayer::appendTo(NetLayer* layer)
+{
+	// Use base method
+	NetLayer::appendTo(layer);
+
+	// Set the input size of the layer
+	_inputWeights.resize(_gates * size(), _prev->size());
+	_inputGradients.resize(_gates * size(), _prev->size());
+
+	// Initialize weights
+	_inputWeights.rand(-1.0f, 1.0f);
+	_inputGradients.clear();
+}
+
+// updates output from input (window of steps), advances the state
+void RecurrentLayer::processInput()
+{
+	if (!_prev)
+		throw std::runtime_error("RecurrentLayer: Missing previous layer.");
+
+	const Matrix& in = _prev->output();
+	if (in.columns() % _sequences != 0)
+		throw std::runtime_error("RecurrentLayer: Input is not a window of steps of all sequences.");
+
+	const int units = size();
+	const int count = in.columns();
+	_steps = count / _sequences;
+	_begin(_steps);
+
+	// input projections of all steps in one product (bias included)
+	Matrix pre = Matrix::affine(_inputWeights, in, _bias);
+
+	Matrix previous(units, count);
+	Matrix res(units, count);
+	float* state = &_state.at(0, 0);
+	for (int t = 0; t < _steps; t++)
+	{
+		const int column = t * _sequences;
+		for (int r = 0; r < units; r++)
+			std::copy(state + r * _sequences, state + (r + 1) * _sequences, &previous.at(r, column));
+
+		// one product of all gates with the previous state, then fused gate activations
+		Matrix rec = _stateWeights * _state;
+		_forwardStep(t, &pre.at(0, column), count, &rec.at(0, 0), state);
+
+		for (int r = 0; r < units; r++)
+			std::copy(state + r * _sequences, state + (r + 1) * _sequences, &res.at(r, column));
+	}
+
+	_previous = previous;
+	_output = res;
+}
+
+// updates error of the previous layer and own gradients through the steps of the last window.
+void RecurrentLayer::processError()
+{
+	if (!_prev)
+		throw std::runtime_error("RecurrentLayer: Missing previous layer.");
+	if (_error.columns() != _steps * _sequences || _previous.columns() != _error.columns())
+		throw std::runtime_error("RecurrentLayer: Error does not match the last window.");
+
+	const int units = size();
+	const int count = _error.columns();
+	const Matrix& error = _error;
+	const Matrix& weights = _stateWeights;
+
+	// errors of the projections of all steps (recurrent ones differ when a gate scales its projection)
+	Matrix pre(_gates * units, count);
+	Matrix rec(_gates * units, count);
+	Matrix state(units, _sequences);
+	state.clear();
+	for (int t = _steps - 1; t >= 0; t--)
+	{
+		const int column = t * _sequences;
+		for (int r = 0; r < units; r++)
+		{
+			float* e = &state.at(r, 0);
+			for (int s = 0; s < _sequences; s++)
+				e[s] += error.at(r, column + s);
+		}
+
+		_backwardStep(t, &state.at(0, 0), &pre.at(0, column), &rec.at(0, column), count);
+
+		// error of the state before the window is not propagated (truncation)
+		if (t > 0)
+			state += weights.t() * rec.block(0, column, _gates * units, _sequences);
+	}
+
+	// gradients of all steps in one product each
+	_inputGradients += pre * _prev->output().t();
+	_stateGradients += rec * _previous.t();
+	_gradient += pre.sumColumns();
+	_batchSize += count;
+
+	_prev->error() = _inputWeights.t() * pre;
+}
+
+// Updates parameters (called after each batch).
+void RecurrentLayer::updateParameters()
+{
+	if (_batchSize > 0 && _inputRule)
+		_inputRule->update(_inputWeights, _inputGradients / (float)_batchSize);
+
+	if (_batchSize > 0 && _stateRule)
+		_stateRule->update(_stateWeights, _stateGradients / (float)_batchSize);
+
+	if (_batchSize > 0 && _biasRule)
+		_biasRule->update(_bias, _gradient / (float)_batchSize);
+
+	_inputGradients.clear();
+	_stateGradients.clear();
+	_gradient.clear();
+	_batchSize = 0;
+}
+
+// Returns learning rules of the layer (input weights, recurrent weights, bias, missing ones skipped)
+std::vector<LearningRule*> RecurrentLayer::learningRules() const
+{
+	std::vector<LearningRule*> res;
+	if (_inputRule)
+		res.push_back(_inputRule);
+	if (_stateRule)
+		res.push_back(_stateRule);
+	if (_biasRule)
+		res.push_back(_biasRule);
+	return res;
+}
+
+// Reads parameters from given stream (input weights, recurrent weights, bias)
+void RecurrentLayer::read(std::istream& stream)
+{
+	stream >> _inputWeights;
+	stream >> _stateWeights;
+	stream >> _bias;
+}
+
+// Writes parameters to given stream (input weights, recurrent weights, bias)
+void RecurrentLayer::write(std::ostream& stream) const
+{
+	stream << _inputWeights;
+	stream << _stateWeights;
+	stream << _bias;
+}
+
+// Returns parameter matrices of the layer (input weights, recurrent weights, bias).
+std::vector<Matrix*> RecurrentLayer::parameters()
+{
+	std::vector<Matrix*> res;
+	res.push_back(&_inputWeights);
+	res.push_back(&_stateWeights);
+	res.push_back(&_bias);
+	return res;
+}
@@ -0,0 +1,103 @@
+#ifndef _RECURRENT_LAYER_H_
+#define _RECURRENT_LAYER_H_
+
+#include "NetLayer.h"
+#include "../Learning/LearningRule.h"
+
+// Base of recurrent layers (see LSTMLayer and GRULayer). Hidden state of each sequence is kept between calls.
+// Input of one call is a window of steps of a batch of sequences: column [step * sequences + sequence], output has
+// the same layout (hidden state after each step). One column per call (1 sequence) is streaming single-step mode.
+// Weights of all gates are concatenated (gate by gate): input projections of all steps are one product before
+// the steps, each step is then one product of the recurrent weights and the previous state followed by one fused
+// pass of the gate activations (implemented by derived class).
+// Truncated backpropagation through time: processError() backpropagates through the steps of the last window
+// only, state keeps going on. Activations are stored for one window, so its length bounds the memory.
+// Note: Net keeps output of recurrent layers when checkpointing. Batches cannot be split (ParallelTrainer,
+// PipelineTrainer) as columns of a window depend on each other.
+class RecurrentLayer : public NetLayer
+{
+protected:
+	int _gates;
+	int _sequences;
+	int _steps;					// steps of the last window
+	Matrix _inputWeights;		// gates * size x inputs
+	Matrix _stateWeights;		// gates * size x size
+	Matrix _bias;				// gates * size x 1
+	Matrix _inputGradients;
+	Matrix _stateGradients;
+	Matrix _gradient;
+	int _batchSize;
+	Matrix _state;				// hidden state of each sequence (size x sequences)
+	Matrix _previous;			// hidden state before each step of the last window (size x steps * sequences)
+
+	LearningRule* _inputRule;
+	LearningRule* _stateRule;
+	LearningRule* _biasRule;
+
+	// Starts window of given steps (allocates storage of the derived class)
+	virtual void _begin(int steps) = 0;
+
+	// Fused gate activations of given step: [pre] input projections with bias (gates * size rows of [stride]),
+	// [rec] recurrent projections (gates * size x sequences). Replaces previous hidden state [state] by the new one.
+	virtual void _forwardStep(int step, const float* pre, int stride, const float* rec, float* state) = 0;
+
+	// Backward pass of given step: replaces error of the hidden state [error] (size x sequences) by its part passed
+	// directly to the previous state, writes errors of input projections [pre] and of recurrent projections [rec]
+	// (gates * size rows of [stride]).
+	virtual void _backwardStep(int step, float* error, float* pre, float* rec, int stride) = 0;
+
+	// Clears state of derived class (size x sequences)
+	virtual void _resetState() = 0;
+
+public:
+	// Constructs new recurrent layer with given output size and number of gates. Takes ownership of the learning
+	// rules, recurrent weights use a clone of the weight rule. Input size will be computed when appended.
+	RecurrentLayer(int size, int gates, LearningRule* weightRule, LearningRule* biasRule);
+
+	// Destructor
+	virtual ~RecurrentLayer();
+
+	// Clears state and sets number of sequences processed in parallel (columns of each step).
+	void reset(int sequences = 1);
+
+	// Returns number of sequences
+	int sequences() const { return _sequences; }
+
+	// Returns hidden state of each sequence (size x sequences)
+	const Matrix& state() const { return _state; }
+
+	// Returns input weights of all gates (gates * size x inputs)
+	const Matrix& inputWeights() const { return _inputWeights; }
+
+	// Returns recurrent weights of all gates (gates * size x size)
+	const Matrix& stateWeights() const { return _stateWeights; }
+
+	// Returns bias of all gates
+	const Matrix& bias() const { return _bias; }
+
+	// Returns learning rules of the layer (input weights, recurrent weights, bias, missing ones skipped)
+	virtual std::vector<LearningRule*> learningRules() const;
+
+	// Appends this layer to the specified layer.
+	virtual void appendTo(NetLayer* layer);
+
+	// updates output from input (window of steps), advances the state
+	virtual void processInput();
+
+	// updates error of the previous layer and own gradients through the steps of the last window.
+	virtual void processError();
+
+	// Updates parameters (called after each batch).
+	virtual void updateParameters();
+
+	// Reads parameters from given stream (input weights, recurrent weights, bias)
+	virtual void read(std::istream& stream);
+
+	// Writes parameters to given stream (input weights, recurrent weights, bias)
+	virtual void write(std::ostream& stream) const;
+
+	// Returns parameter matrices of the layer (input weights, recurrent weights, bias).
+	virtual std::vector<Matrix*> parameters();
+};
+
+#endif //_RECURRENT_LAYER_H_
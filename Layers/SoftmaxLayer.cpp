@@ -0,0 +1,87 @@
+#include "SoftmaxLayer.h"
+#include <cmath>
+#include <algorithm>
+
+// updates output from input
+void SoftmaxLayer::processInput()
+{
+	if (!_prev)
+		throw std::runtime_error("SoftmaxLayer: Missing previous layer.");
+
+	const Matrix& in = _prev->output();
+	const int rows = in.rows();
+	const int cols = in.columns();
+
+	// Rows are swept with one accumulator per column: maximum, then exp(x - max) and its sum, then normalization.
+	// p = exp(x - max) / sum(exp(x - max)), log(sum(exp(x))) = max + log(sum(exp(x - max)))
+	_maxima.assign(cols, -INFINITY);
+	_sums.assign(cols, 0.0f);
+	float* maxima = _maxima.data();
+	float* sums = _sums.data();
+	for (int r = 0; r < rows; r++)
+		for (int c = 0; c < cols; c++)
+			maxima[c] = std::max(maxima[c], in.at(r, c));
+
+	Matrix res(rows, cols);
+	for (int r = 0; r < rows; r++)
+	{
+		float* y = &res.at(r, 0);
+		for (int c = 0; c < cols; c++)
+		{
+			y[c] = std::exp(in.at(r, c) - maxima[c]);
+			sums[c] += y[c];
+		}
+	}
+
+	_logSums.resize(cols);
+	for (int c = 0; c < cols; c++)
+	{
+		_logSums[c] = maxima[c] + std::log(sums[c]);
+		sums[c] = 1.0f / sums[c];
+	}
+
+	for (int r = 0; r < rows; r++)
+	{
+		float* y = &res.at(r, 0);
+		for (int c = 0; c < cols; c++)
+			y[c] *= sums[c];
+	}
+
+	_output = res;
+	_logits = in;
+}
+
+// Computes mean cross-entropy loss of the last output for given classes and sets error of the layer to (p - y).
+float SoftmaxLayer::crossEntropy(const std::vector<int>& labels)
+{
+	if (!_prev)
+		throw std::runtime_error("SoftmaxLayer: Missing previous layer.");
+	if ((int)labels.size() != _output.columns() || _logSums.size() != labels.size())
+		throw std::invalid_argument("SoftmaxLayer: Number of labels does not match the output.");
+
+	for (unsigned c = 0; c < labels.size(); c++)
+		if (labels[c] < 0 || labels[c] >= _output.rows())
+			throw std::invalid_argument("SoftmaxLayer: Invalid class label.");
+
+	// -log(p[label]) = log(sum(exp(x))) - x[label] stays finite when p[label] underflows
+	// (logits are kept by the layer, input may be released by checkpointing, see Net::setCheckpointInterval())
+	const Matrix& in = _logits;
+	double loss = 0.0;
+	_error = _output;
+	for (int c = 0; c < (int)labels.size(); c++)
+	{
+		loss += _logSums[c] - in.at(labels[c], c);
+		_error.at(labels[c], c) -= 1.0f;
+	}
+
+	return (float)(loss / labels.size());
+}
+
+// updates error of the previous layer (error of the layer is already the error of its input).
+void SoftmaxLayer::processError()
+{
+	if (!_prev)
+		throw std::runtime_error("SoftmaxLayer: Missing previous layer.");
+
+	_prev->error() = _error;
+}
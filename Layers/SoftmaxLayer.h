@@ -0,0 +1,41 @@
+#ifndef _SOFTMAX_LAYER_H_
+#define _SOFTMAX_LAYER_H_
+
+#include "NetLayer.h"
+
+// Implements softmax output layer with cross-entropy loss. Output is a probability of each class (rows) for each
+// sample (columns), computed stably (maximum of the column subtracted before exp).
+// Error of the layer is the error of its input (logits): crossEntropy() sets it to (p - y) for integer class
+// labels in one pass, without one-hot targets. The same error is (output - target) for one-hot targets, so
+// errors computed as for the squared loss (e.g. default error function of trainers) work too.
+// See Net::processError() with labels.
+class SoftmaxLayer : public NetLayer
+{
+private:
+	std::vector<float> _logSums;	// log of the sum of exp(x) of each column (last processInput())
+	Matrix _logits;					// input of the last processInput() (shared, kept when the input is released)
+	std::vector<float> _maxima;		// maximum of each column (kept to reuse the storage)
+	std::vector<float> _sums;		// sum of exp(x - max) of each column, then its inverse
+
+public:
+	// Constructs new softmax layer with given [size] (number of classes).
+	SoftmaxLayer(int size) : NetLayer(size) { /* does nothing. */ }
+
+	// updates output from input
+	virtual void processInput();
+
+	// Computes mean cross-entropy loss of the last output for given class of each sample (column) and sets error
+	// of the layer to its gradient (p - y). Throws std::invalid_argument when labels do not match the output.
+	float crossEntropy(const std::vector<int>& labels);
+
+	// updates error of the previous layer (error of the layer is already the error of its input).
+	virtual void processError();
+
+	// Updates parameters (called after each batch).
+	virtual void updateParameters() { /* No parameters to update. */ }
+
+	// Creates new layer of the same size.
+	virtual NetLayer* replicate(bool learning = false) const { return new SoftmaxLayer(size()); }
+};
+
+#endif //_SOFTMAX_LAYER_H_
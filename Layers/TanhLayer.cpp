@@ -4,7 +4,7 @@
 void TanhLayer::processInput()
 {
 	if (!_prev)
-		throw std::runtime_error("RectifierLayer: Missing previous layer.");
+		throw std::runtime_error("TanhLayer: Missing previous layer.");
 
 	// Hyperbolic tangent
 	_output = tanh(_prev->output());
@@ -14,8 +14,8 @@ void TanhLayer::processInput()
 void TanhLayer::processError()
 {
 	if (!_prev)
-		throw std::runtime_error("RectifierLayer: Missing previous layer.");
+		throw std::runtime_error("TanhLayer: Missing previous layer.");
 
 	// No parameters to update, only backpropagate e_prev = dE/dx = dE/dy * dy/dx = e * (1 - y^2)
-	_prev->error() = Matrix::elemProd(Matrix::elemProd(_output, _output), _error);
+	_prev->error() = Matrix::elemProd(1.0f - Matrix::elemProd(_output, _output), _error);
 }
\ No newline at end of file
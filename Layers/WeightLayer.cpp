@@ -3,7 +3,11 @@
 // Constructs new weight layer with given output size and learning rule. Takes ownership of the learning rule.
 // Note: input size of the layer will be computed when appended to another layer.
 WeightLayer::WeightLayer(int size, LearningRule* learnRule)
-	: NetLayer(size), _weights(), _gradients(), _learnRule(learnRule), _batchSize(0) {}
+	: NetLayer(size), _weights(), _gradients(), _batchSize(0), _learnRule(learnRule) {}
+
+// Constructs replica of given layer sharing its weights. Takes ownership of the learning rule.
+WeightLayer::WeightLayer(const WeightLayer& layer, LearningRule* learnRule)
+	: NetLayer(layer.size()), _weights(layer._weights), _gradients(), _batchSize(0), _learnRule(learnRule) {}
 
 // Destructor
 WeightLayer::~WeightLayer()
@@ -18,12 +22,15 @@ void WeightLayer::appendTo(NetLayer* layer)
 	NetLayer::appendTo(layer);
 	
 	// Set the size of the layer
-	_weights.resize(this->size(), _prev->size());
 	_gradients.resize(this->size(), _prev->size());
-
-	// Initialize weights
-	_weights.rand(-1.0f, 1.0f);
 	_gradients.clear();
+
+	// Initialize weights (unless shared by replicated layer)
+	if (_weights.rows() != this->size() || _weights.columns() != _prev->size())
+	{
+		_weights.resize(this->size(), _prev->size());
+		_weights.rand(-1.0f, 1.0f);
+	}
 }
 
 // updates output from input
@@ -32,19 +39,19 @@ void WeightLayer::processInput()
 	if (!_prev)
 		throw std::runtime_error("WeightLayer: Missing previous layer.");
 
-	// Calculate y = W * x
+	// Calculate Y = W * X (one sample per column)
 	_output = _weights * _prev->output();
 }
 
-// updates error of the previous layer (call after each sample in batch).
+// updates error of the previous layer (call after each sample or batch of samples).
 void WeightLayer::processError()
 {
 	if (!_prev)
 		throw std::runtime_error("WeightLayer: Missing previous layer.");
 
-	// 1. compute gradient dE/dW = e * de/dW = e * trans(x). Accumulate.
+	// 1. compute gradient dE/dW = e * de/dW = e * trans(x). Accumulate (sum over the columns of the batch).
 	_gradients += _error * _prev->output().t();
-	_batchSize++;
+	_batchSize += _error.columns();
 
 	// 2. backpropagate error using e_prev = dE/dx = de/dx * e = trans(W) * e
 	_prev->error() = _weights.t() * _error;
@@ -53,13 +60,28 @@ void WeightLayer::processError()
 // Updates parameters (called after each batch)
 void WeightLayer::updateParameters()
 {
-	if (_batchSize > 0)
+	if (_batchSize > 0 && _learnRule)
 		_learnRule->update(_weights, _gradients / (float)_batchSize);
 
 	_gradients.clear();
 	_batchSize = 0;
 }
 
+// Adds gradients accumulated by [layer] (WeightLayer) to own ones and clears them in [layer].
+void WeightLayer::mergeGradients(NetLayer& layer)
+{
+	WeightLayer* other = dynamic_cast<WeightLayer*>(&layer);
+	if (!other || other->_gradients.size() != _gradients.size())
+		throw std::invalid_argument("WeightLayer: Layer to merge does not match.");
+
+	if (other->_batchSize > 0)
+		_gradients += other->_gradients;
+	_batchSize += other->_batchSize;
+
+	other->_gradients.clear();
+	other->_batchSize = 0;
+}
+
 // Reads parameters from given stream
 void WeightLayer::read(std::istream& stream)
 {
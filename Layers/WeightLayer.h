@@ -14,6 +14,9 @@ protected:
 	int _batchSize;
 	LearningRule* _learnRule;
 
+	// Constructs replica of given layer sharing its weights. Takes ownership of the learning rule.
+	WeightLayer(const WeightLayer& layer, LearningRule* learnRule);
+
 public:
 	// Constructs new weight layer with given output size and learning rule. Takes ownership of the learning rule.
 	// Note: input size of the layer will be computed when appended to another layer.
@@ -28,13 +31,19 @@ public:
 	// Returns learn rule
 	LearningRule* learningRule() const { return _learnRule; }
 
+	// Returns learning rules of the layer (learn rule of the weights)
+	virtual std::vector<LearningRule*> learningRules() const
+	{
+		return _learnRule ? std::vector<LearningRule*>(1, _learnRule) : std::vector<LearningRule*>();
+	}
+
 	// Appends this layer to the specified layer.
 	virtual void appendTo(NetLayer* layer);
 
 	// updates output from input
 	virtual void processInput();
 
-	// updates error of the previous layer and own gradient (call after each sample in batch).
+	// updates error of the previous layer and own gradient (call after each sample or batch of samples).
 	virtual void processError();
 
 	// Updates parameters (called after each batch)
@@ -45,6 +54,18 @@ public:
 
 	// Writes parameters to given stream
 	virtual void write(std::ostream& stream) const;
+
+	// Returns parameter matrices of the layer (weights).
+	virtual std::vector<Matrix*> parameters() { return std::vector<Matrix*>(1, &_weights); }
+
+	// Creates new layer of the same size sharing the parameters. Learning rule is cloned when [learning] is set.
+	virtual NetLayer* replicate(bool learning = false) const
+	{
+		return new WeightLayer(*this, (learning && _learnRule) ? _learnRule->clone() : NULL);
+	}
+
+	// Adds gradients accumulated by [layer] (WeightLayer) to own ones and clears them in [layer].
+	virtual void mergeGradients(NetLayer& layer);
 };
 
 #endif
\ No newline at end of file
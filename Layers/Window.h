@@ -0,0 +1,82 @@
+#ifndef _WINDOW_H_
+#define _WINDOW_H_
+
+#include <vector>
+
+// Geometry of a window sliding over input with channels of height x width values (convolution and pooling).
+// Sample is stored in a column channel by channel, row by row. 1D inputs have height 1 (see line()).
+struct Window
+{
+	int channels;				// input channels
+	int height;					// input height
+	int width;					// input width
+	int kernelHeight;
+	int kernelWidth;
+	int strideY;
+	int strideX;
+	int padY;					// zero rows added above and below the input
+	int padX;					// zero columns added left and right of the input
+	int dilationY;				// distance of window rows
+	int dilationX;				// distance of window columns
+
+	// 2D window with the same stride, padding and dilation in both dimensions
+	Window(int channels, int height, int width, int kernelHeight, int kernelWidth, int stride = 1, int padding = 0, int dilation = 1)
+		: channels(channels), height(height), width(width), kernelHeight(kernelHeight), kernelWidth(kernelWidth),
+		strideY(stride), strideX(stride), padY(padding), padX(padding), dilationY(dilation), dilationX(dilation) {}
+
+	// 1D window over inputs of given length
+	static Window line(int channels, int length, int kernel, int stride = 1, int padding = 0, int dilation = 1)
+	{
+		Window res(channels, 1, length, 1, kernel, stride, padding, dilation);
+		res.strideY = 1;
+		res.padY = 0;
+		res.dilationY = 1;
+		return res;
+	}
+
+	// Returns height of the output (number of window positions in a column)
+	int outputHeight() const { return (height + 2 * padY - dilationY * (kernelHeight - 1) - 1) / strideY + 1; }
+
+	// Returns width of the output (number of window positions in a row)
+	int outputWidth() const { return (width + 2 * padX - dilationX * (kernelWidth - 1) - 1) / strideX + 1; }
+
+	// Returns number of window positions
+	int positions() const { return outputHeight() * outputWidth(); }
+
+	// Returns size of the input (one sample)
+	int inputSize() const { return channels * height * width; }
+
+	// Returns input index of each window element (channel by channel when [allChannels] is set, first channel only
+	// otherwise) at each position: element k at position p is at [k * positions() + p], -1 in the padding.
+	std::vector<int> offsets(bool allChannels) const
+	{
+		const int outHeight = outputHeight();
+		const int outWidth = outputWidth();
+		const int planes = allChannels ? channels : 1;
+		std::vector<int> res((size_t)planes * kernelHeight * kernelWidth * outHeight * outWidth);
+
+		size_t i = 0;
+		for (int c = 0; c < planes; c++)
+			for (int ky = 0; ky < kernelHeight; ky++)
+				for (int kx = 0; kx < kernelWidth; kx++)
+					for (int oy = 0; oy < outHeight; oy++)
+						for (int ox = 0; ox < outWidth; ox++)
+						{
+							const int y = oy * strideY - padY + ky * dilationY;
+							const int x = ox * strideX - padX + kx * dilationX;
+							res[i++] = (y < 0 || y >= height || x < 0 || x >= width) ? -1 : (c * height + y) * width + x;
+						}
+
+		return res;
+	}
+
+	// Returns true when the window fits the input with valid strides and dilations
+	bool valid() const
+	{
+		return channels > 0 && height > 0 && width > 0 && kernelHeight > 0 && kernelWidth > 0 && strideY > 0
+			&& strideX > 0 && padY >= 0 && padX >= 0 && dilationY > 0 && dilationX > 0
+			&& height + 2 * padY >= dilationY * (kernelHeight - 1) + 1 && width + 2 * padX >= dilationX * (kernelWidth - 1) + 1;
+	}
+};
+
+#endif // _WINDOW_H_
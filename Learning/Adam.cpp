@@ -32,3 +32,45 @@ void Adam::update(Matrix& params, const Matrix& grads)
 	Matrix norm2 = _g2 / (1 - _beta2_decayed);
 	params -= learningRate * Matrix::elemDiv(norm1, sqrt(norm2) + epsilon);
 }
+
+
+// Returns moment estimates and time step (see LearningRule::state()).
+std::vector<Matrix> Adam::state() const
+{
+	std::vector<Matrix> res;
+	if (_g1.empty())
+		return res;
+
+	// time step is split to 16-bit halves, so it is exact in floats
+	Matrix scalars(4, 1);
+	scalars.at(0, 0) = (float)(_t & 0xFFFF);
+	scalars.at(1, 0) = (float)(_t >> 16);
+	scalars.at(2, 0) = _beta1_decayed;
+	scalars.at(3, 0) = _beta2_decayed;
+
+	res.push_back(_g1);
+	res.push_back(_g2);
+	res.push_back(scalars);
+	return res;
+}
+
+// Restores moment estimates and time step returned by state().
+void Adam::setState(const std::vector<Matrix>& state)
+{
+	if (state.empty())
+	{
+		_g1 = Matrix();
+		_g2 = Matrix();
+		_t = 0;
+		return;
+	}
+
+	if (state.size() != 3 || state[0].size() != state[1].size() || state[2].rows() != 4 || state[2].columns() != 1)
+		throw std::invalid_argument("Adam: Invalid state.");
+
+	_g1 = state[0];
+	_g2 = state[1];
+	_t = (unsigned)state[2].at(0, 0) | ((unsigned)state[2].at(1, 0) << 16);
+	_beta1_decayed = state[2].at(2, 0);
+	_beta2_decayed = state[2].at(3, 0);
+}
@@ -21,6 +21,15 @@ public:
 	// Note: if minibatch learning is used, [grads] contain average gradient.
 	virtual void update(Matrix& params, const Matrix& grads);
 
+	// Returns moment estimates and time step (see LearningRule::state()).
+	virtual std::vector<Matrix> state() const;
+
+	// Restores moment estimates and time step returned by state().
+	virtual void setState(const std::vector<Matrix>& state);
+
+	// Returns new copy of the rule with the same settings and state.
+	virtual LearningRule* clone() const { return new Adam(*this); }
+
 	// Learning rate (small positive value). Default value is 0.001
 	float learningRate;
 
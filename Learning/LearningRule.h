@@ -3,14 +3,29 @@
 
 #include "../Matrix.h"
 #include <iostream>
+#include <vector>
+#include <stdexcept>
 
 // Abstract interface for learning algorithms
 class LearningRule
 {
 public:
+	// Destructor
+	virtual ~LearningRule() {}
+
 	// Updates parameters according to the learning rule.
 	// Note: if minibatch learning is used, [grads] contain average gradient.
 	virtual void update(Matrix& params, const Matrix& grads)=0;
+
+	// Returns internal state of the rule (e.g. moment estimates), empty if the rule has no state.
+	// Matrices are shared copy-on-write, so the snapshot is cheap and does not change with further updates.
+	virtual std::vector<Matrix> state() const { return std::vector<Matrix>(); }
+
+	// Restores internal state returned by state(). Empty state resets the rule.
+	virtual void setState(const std::vector<Matrix>& state) { /* does nothing. */ }
+
+	// Returns new copy of the rule with the same settings and state. Throws std::runtime_error when not supported.
+	virtual LearningRule* clone() const { throw std::runtime_error("LearningRule: Rule cannot be cloned."); }
 };
 
-#endif // _LEARNING_RULE_H_
\ No newline at end of file
+#endif // _LEARNING_RULE_H_
@@ -0,0 +1,326 @@
+#include "ParallelTrainer.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+
+// Persistent worker threads running tasks of _parallel()
+struct ParallelTrainer::Pool
+{
+	std::vector<std::thread> threads;
+	std::mutex lock;
+	std::condition_variable wake;			// new job, job finished or pool stops
+
+	void (*invoke)(const void*, int, int);	// calls task(index, worker)
+	const void* task;
+	int count;								// number of tasks of the job
+	int next;								// next task to take
+	int finished;							// number of finished tasks
+	unsigned job;							// number of the current job
+	bool stop;
+	std::exception_ptr error;				// first error of the job
+
+	// Runs tasks of given job until all are taken (called with the lock held)
+	void work(std::unique_lock<std::mutex>& guard, unsigned current, int worker)
+	{
+		while (job == current && next < count)
+		{
+			const int index = next++;
+
+			// run without the lock, skip remaining tasks after an error
+			if (!error)
+			{
+				guard.unlock();
+				try
+				{
+					invoke(task, index, worker);
+				}
+				catch (...)
+				{
+					guard.lock();
+					if (!error)
+						error = std::current_exception();
+					guard.unlock();
+				}
+				guard.lock();
+			}
+
+			if (++finished == count)
+				wake.notify_all();
+		}
+	}
+
+	// Waits for jobs until the pool stops (worker thread)
+	void run(int worker)
+	{
+		// workers already run in parallel, do not split kernels further
+		Matrix::setParallel(false);
+
+		std::unique_lock<std::mutex> guard(lock);
+		unsigned seen = 0;		// threads start before the first job
+		while (true)
+		{
+			wake.wait(guard, [&]() { return stop || job != seen; });
+			if (stop)
+				return;
+
+			seen = job;
+			work(guard, seen, worker);
+		}
+	}
+};
+
+// Calls task of given type (type-erased without allocation)
+template <class Task>
+static void invokeTask(const void* task, int index, int worker)
+{
+	(*(const Task*)task)(index, worker);
+}
+
+// Creates trainer of given network (structure has to be set first).
+ParallelTrainer::ParallelTrainer(Net& net, int threads, bool deterministic, int shards)
+	: _net(net), _replicas(), _workers(), _threads(threads), _shards(shards), _none(), _pool(NULL)
+{
+	if (_threads <= 0)
+		_threads = (int)std::thread::hardware_concurrency();
+	if (_threads <= 0)
+		_threads = 1;
+
+	if (!deterministic)
+		_shards = _threads;
+	if (_shards <= 0)
+		throw std::invalid_argument("ParallelTrainer: Invalid number of shards.");
+
+	// Build replicas with the same structure
+	const std::vector<NetLayer*>& layers = _net.layers();
+	for (int s = 0; s < _shards; s++)
+	{
+		Net* replica = new Net();
+		_replicas.push_back(replica);
+
+		for (unsigned i = 0; i < layers.size(); i++)
+			replica->addLayer(layers[i]->replicate());
+	}
+
+	// Parameters are shared again by each batch
+	_unshare(_replicas);
+
+	// Start worker threads, the caller is worker 0
+	if (_threads > 1)
+	{
+		_pool = new Pool();
+		_pool->invoke = NULL;
+		_pool->task = NULL;
+		_pool->count = 0;
+		_pool->next = 0;
+		_pool->finished = 0;
+		_pool->job = 0;
+		_pool->stop = false;
+
+		for (int t = 1; t < _threads; t++)
+			_pool->threads.push_back(std::thread([this, t]() { _pool->run(t); }));
+	}
+
+	errorFunction = [](const Matrix& output, const Matrix& target) { return output - target; };
+}
+
+// Stops worker threads and destroys replicas
+ParallelTrainer::~ParallelTrainer()
+{
+	if (_pool)
+	{
+		{
+			std::lock_guard<std::mutex> guard(_pool->lock);
+			_pool->stop = true;
+		}
+		_pool->wake.notify_all();
+
+		for (unsigned t = 0; t < _pool->threads.size(); t++)
+			_pool->threads[t].join();
+
+		delete _pool;
+	}
+
+	for (unsigned s = 0; s < _replicas.size(); s++)
+		delete _replicas[s];
+
+	for (unsigned w = 0; w < _workers.size(); w++)
+		delete _workers[w];
+}
+
+// Runs task(index, worker) for all indices from 0 to [count] - 1 on worker threads (the caller is worker 0).
+template <class Task>
+void ParallelTrainer::_parallel(int count, const Task& task) const
+{
+	if (!_pool || count <= 1)
+	{
+		for (int i = 0; i < count; i++)
+			task(i, 0);
+		return;
+	}
+
+	// publish the job, run its tasks with the workers and wait for the last one
+	std::unique_lock<std::mutex> guard(_pool->lock);
+	_pool->invoke = &invokeTask<Task>;
+	_pool->task = &task;
+	_pool->count = count;
+	_pool->next = 0;
+	_pool->finished = 0;
+	_pool->error = std::exception_ptr();
+	const unsigned current = ++_pool->job;
+	_pool->wake.notify_all();
+
+	_pool->work(guard, current, 0);
+	_pool->wake.wait(guard, [&]() { return _pool->finished == count; });
+
+	std::exception_ptr error = _pool->error;
+	_pool->error = std::exception_ptr();
+	guard.unlock();
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+// Shares parameters of the network with given replicas, by copy-on-write or as aliases (no copy-on-write)
+void ParallelTrainer::_share(const std::vector<Net*>& replicas, bool alias)
+{
+	const std::vector<NetLayer*>& layers = _net.layers();
+	for (unsigned s = 0; s < replicas.size(); s++)
+	{
+		const std::vector<NetLayer*>& replicaLayers = replicas[s]->layers();
+		for (unsigned i = 0; i < layers.size(); i++)
+		{
+			std::vector<Matrix*> params = layers[i]->parameters();
+			std::vector<Matrix*> replicaParams = replicaLayers[i]->parameters();
+			for (unsigned k = 0; k < params.size(); k++)
+				*replicaParams[k] = alias ? params[k]->alias() : *params[k];
+		}
+	}
+}
+
+// Releases parameters shared with given replicas
+void ParallelTrainer::_unshare(const std::vector<Net*>& replicas)
+{
+	for (unsigned s = 0; s < replicas.size(); s++)
+	{
+		const std::vector<NetLayer*>& replicaLayers = replicas[s]->layers();
+		for (unsigned i = 0; i < replicaLayers.size(); i++)
+		{
+			std::vector<Matrix*> replicaParams = replicaLayers[i]->parameters();
+			for (unsigned k = 0; k < replicaParams.size(); k++)
+				*replicaParams[k] = _none;
+		}
+	}
+}
+
+// Runs forward and backward pass of given shard on its replica (worker thread)
+void ParallelTrainer::_runShard(int shard, const Matrix& inputs, const Matrix& targets)
+{
+	const int begin = (int)((long long)inputs.columns() * shard / _shards);
+	const int end = (int)((long long)inputs.columns() * (shard + 1) / _shards);
+	if (end <= begin)
+		return; // empty shard (small batch)
+
+	Net& replica = *_replicas[shard];
+	replica.processInput(inputs.block(0, begin, inputs.rows(), end - begin));
+	replica.processError(errorFunction(replica.output(), targets.block(0, begin, targets.rows(), end - begin)));
+}
+
+// Adds gradients of replica [src] to replica [dst] and clears them in [src] (worker thread)
+void ParallelTrainer::_merge(int dst, int src)
+{
+	const std::vector<NetLayer*>& dstLayers = _replicas[dst]->layers();
+	const std::vector<NetLayer*>& srcLayers = _replicas[src]->layers();
+
+	for (unsigned i = 0; i < dstLayers.size(); i++)
+		dstLayers[i]->mergeGradients(*srcLayers[i]);
+}
+
+// Trains network on a batch of samples (columns of [inputs] and [targets]).
+void ParallelTrainer::train(const Matrix& inputs, const Matrix& targets)
+{
+	if (inputs.columns() != targets.columns())
+		throw std::invalid_argument("ParallelTrainer: Dimension mismatch.");
+
+	const std::vector<NetLayer*>& layers = _net.layers();
+	if (layers.empty()) return; // nothing to do
+
+	// Share current parameters with replicas (no copy)
+	_share(_replicas, false);
+
+	// Forward and backward pass of shards
+	_parallel(_shards, [&](int shard, int) { _runShard(shard, inputs, targets); });
+
+	// Pairwise reduction of gradients, shape of the tree depends only on number of shards
+	for (int step = 1; step < _shards; step *= 2)
+	{
+		const int pairs = (_shards + 2 * step - 1) / (2 * step);
+		_parallel(pairs, [&](int pair, int)
+		{
+			const int dst = pair * 2 * step;
+			if (dst + step < _shards)
+				_merge(dst, dst + step);
+		});
+	}
+
+	// Release shared parameters, so the network updates them in place
+	_unshare(_replicas);
+
+	// Apply sum of gradients
+	const std::vector<NetLayer*>& replicaLayers = _replicas[0]->layers();
+	for (unsigned i = 0; i < layers.size(); i++)
+		layers[i]->mergeGradients(*replicaLayers[i]);
+
+	_net.updateParameters();
+}
+
+// Trains network asynchronously (Hogwild) on samples in columns of [inputs] and [targets].
+void ParallelTrainer::trainAsync(const Matrix& inputs, const Matrix& targets, int batchSize)
+{
+	if (inputs.columns() != targets.columns())
+		throw std::invalid_argument("ParallelTrainer: Dimension mismatch.");
+	if (batchSize <= 0)
+		throw std::invalid_argument("ParallelTrainer: Invalid batch size.");
+
+	const std::vector<NetLayer*>& layers = _net.layers();
+	if (layers.empty()) return; // nothing to do
+
+	// Workers with own learning rules
+	if (_workers.empty())
+	{
+		for (int w = 0; w < _threads; w++)
+		{
+			Net* worker = new Net();
+			_workers.push_back(worker);
+
+			for (unsigned i = 0; i < layers.size(); i++)
+				worker->addLayer(layers[i]->replicate(true));
+		}
+	}
+
+	// All workers update the same elements in place
+	_share(_workers, true);
+
+	const int batches = (inputs.columns() + batchSize - 1) / batchSize;
+	try
+	{
+		_parallel(batches, [&](int batch, int id)
+		{
+			const int begin = batch * batchSize;
+			const int count = (begin + batchSize <= inputs.columns()) ? batchSize : inputs.columns() - begin;
+
+			Net& worker = *_workers[id];
+			worker.processInput(inputs.block(0, begin, inputs.rows(), count));
+			worker.processError(errorFunction(worker.output(), targets.block(0, begin, targets.rows(), count)));
+			worker.updateParameters();
+		});
+	}
+	catch (...)
+	{
+		_unshare(_workers);
+		throw;
+	}
+
+	_unshare(_workers);
+}
@@ -0,0 +1,84 @@
+#ifndef _PARALLEL_TRAINER_H_
+#define _PARALLEL_TRAINER_H_
+
+#include "../Net.h"
+#include <functional>
+#include <vector>
+
+// Trains a network data-parallel on multiple threads. Each minibatch is split into shards (blocks of columns),
+// forward and backward passes of the shards run on worker threads using replicas of the network. Replicas share
+// parameters with the trained network (copy-on-write, nothing is copied or initialized). Gradients of the replicas
+// are summed by a pairwise tree (levels run in parallel) and the network is updated once per batch by its learning
+// rules. Worker threads are started by the constructor and kept until the trainer is destroyed.
+//
+// In deterministic mode, batch is always split to the same number of shards and the tree has a fixed shape,
+// so results do not depend on the number of threads (only on [shards]). With a single shard, training is
+// bit-identical to Net::processInput(), processError() and updateParameters() on the whole batch.
+// Otherwise batch is split to one shard per thread (results depend on the number of threads).
+//
+// Asynchronous mode (trainAsync(), Hogwild) runs minibatches on worker threads which update one shared copy of
+// the parameters without any locks or reduction. Workers use their own clones of learning rules (made on the
+// first asynchronous call, states of the network's rules are not changed). By contract, concurrent updates
+// are benign races: a worker may read parameters partially updated by another one and updates of the same
+// element may be lost. This converges for sparse gradients and small learning rates, results are not
+// reproducible.
+//
+// All layers of the network have to support NetLayer::replicate().
+class ParallelTrainer
+{
+private:
+	struct Pool;
+
+	Net& _net;
+	std::vector<Net*> _replicas;	// one per shard
+	std::vector<Net*> _workers;		// replicas with learning rules for asynchronous mode (one per thread)
+	int _threads;
+	int _shards;
+	Matrix _none;					// empty matrix releasing shared parameters of replicas
+	Pool* _pool;					// worker threads (NULL when single-threaded)
+
+	// Runs forward and backward pass of given shard on its replica (worker thread)
+	void _runShard(int shard, const Matrix& inputs, const Matrix& targets);
+
+	// Adds gradients of replica [src] to replica [dst] and clears them in [src] (worker thread)
+	void _merge(int dst, int src);
+
+	// Shares parameters of the network with given replicas, by copy-on-write or as aliases (no copy-on-write)
+	void _share(const std::vector<Net*>& replicas, bool alias);
+
+	// Releases parameters shared with given replicas
+	void _unshare(const std::vector<Net*>& replicas);
+
+	// Runs task(index, worker) for all indices from 0 to [count] - 1 on worker threads (the caller is worker 0).
+	// Tasks left after an exception are skipped, the first exception is rethrown.
+	template <class Task>
+	void _parallel(int count, const Task& task) const;
+
+public:
+	// Creates trainer of given network (structure has to be set first). Uses given number of worker threads
+	// (0 for number of hardware threads). In deterministic mode, each batch is split to given number of shards.
+	ParallelTrainer(Net& net, int threads = 0, bool deterministic = false, int shards = 16);
+
+	// Stops worker threads and destroys replicas
+	~ParallelTrainer();
+
+	// Returns number of worker threads
+	int threads() const { return _threads; }
+
+	// Returns number of shards of each batch
+	int shards() const { return _shards; }
+
+	// Trains network on a batch of samples (columns of [inputs] and [targets]). Parameters are updated once
+	// by the average gradient of the batch. Output of the network is not changed.
+	void train(const Matrix& inputs, const Matrix& targets);
+
+	// Trains network asynchronously (Hogwild) on samples in columns of [inputs] and [targets]. Workers take
+	// minibatches of [batchSize] columns in turn and update shared parameters directly after each of them.
+	void trainAsync(const Matrix& inputs, const Matrix& targets, int batchSize = 1);
+
+	// Computes output error of a shard from output of the network and target. Called on worker threads,
+	// has to be thread-safe. Default is (output - target), i.e. gradient of the squared error.
+	std::function<Matrix(const Matrix& output, const Matrix& target)> errorFunction;
+};
+
+#endif // _PARALLEL_TRAINER_H_
@@ -0,0 +1,369 @@
+#include "PipelineTrainer.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <stdexcept>
+
+// Layer inserted between stages for the duration of a batch. Holds input of the stage and receives its error,
+// so stages never touch layers of each other.
+class PipelineTrainer::Boundary : public NetLayer
+{
+public:
+	// Creates boundary of given size
+	Boundary(int size) : NetLayer(size) {}
+
+	// Input is set by the stage
+	virtual void processInput() { /* does nothing. */ }
+
+	// Error is passed by the stage
+	virtual void processError() { /* does nothing. */ }
+
+	// No parameters
+	virtual void updateParameters() { /* does nothing. */ }
+};
+
+// Bounded lock-free queue with a single producer thread and a single consumer thread
+template <class T>
+class PipelineTrainer::Queue
+{
+private:
+	std::vector<T> _items;
+	std::atomic<unsigned> _head;		// next item to write (producer)
+	std::atomic<unsigned> _tail;		// next item to read (consumer)
+
+public:
+	// Creates empty queue with given capacity
+	Queue(int capacity) : _items(capacity), _head(0), _tail(0) {}
+
+	// Appends item, waits while the queue is full. Returns false when [failed] is set while waiting.
+	bool push(const T& item, const std::atomic<bool>& failed)
+	{
+		const unsigned head = _head.load(std::memory_order_relaxed);
+		while (head - _tail.load(std::memory_order_acquire) >= _items.size())
+		{
+			if (failed.load(std::memory_order_relaxed))
+				return false;
+			std::this_thread::yield();
+		}
+
+		_items[head % _items.size()] = item;
+		_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Removes the oldest item, waits while the queue is empty. Returns false when [failed] is set while waiting.
+	bool pop(T& item, const std::atomic<bool>& failed)
+	{
+		const unsigned tail = _tail.load(std::memory_order_relaxed);
+		while (tail == _head.load(std::memory_order_acquire))
+		{
+			if (failed.load(std::memory_order_relaxed))
+				return false;
+			std::this_thread::yield();
+		}
+
+		item = _items[tail % _items.size()];
+		_items[tail % _items.size()] = T(); // release the item before the slot is reused
+		_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+};
+
+// Threads of the stages, each runs its stage of every batch
+struct PipelineTrainer::Stages
+{
+	std::vector<std::thread> threads;
+	std::mutex lock;
+	std::condition_variable wake;		// new batch, batch finished or threads stop
+
+	void (*invoke)(const void*, int);	// runs given stage of the batch (does not throw)
+	const void* task;
+	unsigned batch;						// number of the current batch
+	int running;						// number of stages still running the batch
+	bool stop;
+
+	// Runs given stage of each batch until the threads stop (stage thread)
+	void run(int stage)
+	{
+		// stages already run in parallel, do not split kernels further
+		Matrix::setParallel(false);
+
+		std::unique_lock<std::mutex> guard(lock);
+		unsigned seen = 0;		// threads start before the first batch
+		while (true)
+		{
+			wake.wait(guard, [&]() { return stop || batch != seen; });
+			if (stop)
+				return;
+
+			seen = batch;
+			guard.unlock();
+			invoke(task, stage);
+			guard.lock();
+
+			if (--running == 0)
+				wake.notify_all();
+		}
+	}
+};
+
+// Calls task of given type (type-erased without allocation)
+template <class Task>
+static void invokeStage(const void* task, int stage)
+{
+	(*(const Task*)task)(stage);
+}
+
+// Creates trainer of given network (structure has to be set first).
+PipelineTrainer::PipelineTrainer(Net& net, int stages, int microBatches, Schedule schedule)
+	: _net(net), _firstLayers(), _busy(), _elapsed(0), _stages(NULL), microBatches(microBatches), schedule(schedule)
+{
+	const std::vector<NetLayer*>& layers = _net.layers();
+	if (layers.empty())
+		throw std::invalid_argument("PipelineTrainer: Network has no layers.");
+	if (stages <= 0)
+		throw std::invalid_argument("PipelineTrainer: Invalid number of stages.");
+	if (stages > (int)layers.size())
+		stages = (int)layers.size();
+
+	// Cost of a layer is its number of parameters (plus one, so that layers without parameters are spread too)
+	std::vector<double> costs(layers.size());
+	double total = 0;
+	for (unsigned i = 0; i < layers.size(); i++)
+	{
+		std::vector<Matrix*> params = layers[i]->parameters();
+		costs[i] = 1;
+		for (unsigned k = 0; k < params.size(); k++)
+			costs[i] += (double)params[k]->rows() * params[k]->columns();
+		total += costs[i];
+	}
+
+	// Split into contiguous stages: each boundary is placed where the cost before it is closest to its share,
+	// each stage has at least one layer
+	std::vector<double> prefix(layers.size() + 1, 0.0);
+	for (unsigned i = 0; i < layers.size(); i++)
+		prefix[i + 1] = prefix[i] + costs[i];
+
+	_firstLayers.push_back(0);
+	for (int k = 1; k < stages; k++)
+	{
+		const double share = total * k / stages;
+		int best = _firstLayers.back() + 1;
+		for (int i = best + 1; i <= (int)layers.size() - (stages - k); i++)
+			if (std::abs(prefix[i] - share) < std::abs(prefix[best] - share))
+				best = i;
+		_firstLayers.push_back(best);
+	}
+
+	_busy.assign(_firstLayers.size(), 0.0);
+	errorFunction = [](const Matrix& output, const Matrix& target) { return output - target; };
+
+	// One thread per stage, the caller waits for the batch
+	if (stages > 1)
+	{
+		_stages = new Stages();
+		_stages->invoke = NULL;
+		_stages->task = NULL;
+		_stages->batch = 0;
+		_stages->running = 0;
+		_stages->stop = false;
+
+		for (int s = 0; s < stages; s++)
+			_stages->threads.push_back(std::thread([this, s]() { _stages->run(s); }));
+	}
+}
+
+// Stops stage threads
+PipelineTrainer::~PipelineTrainer()
+{
+	if (_stages)
+	{
+		{
+			std::lock_guard<std::mutex> guard(_stages->lock);
+			_stages->stop = true;
+		}
+		_stages->wake.notify_all();
+
+		for (unsigned t = 0; t < _stages->threads.size(); t++)
+			_stages->threads[t].join();
+
+		delete _stages;
+	}
+}
+
+// Runs operations of given stage (stage thread)
+void PipelineTrainer::_runStage(int stage, const Matrix& inputs, const Matrix& targets, std::vector<Boundary*>& boundaries,
+	std::vector<Queue<Matrix>*>& activations, std::vector<Queue<Matrix>*>& errors, std::atomic<bool>& failed)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const std::vector<NetLayer*>& layers = _net.layers();
+	const int stages = (int)_firstLayers.size();
+	const int begin = _firstLayers[stage];
+	const int end = (stage + 1 < stages) ? _firstLayers[stage + 1] : (int)layers.size();
+	const int count = inputs.columns();
+	const bool last = (stage == stages - 1);
+	NetLayer* source = (stage > 0) ? boundaries[stage] : layers[0];
+
+	// Order of passes: index m for forward pass of micro-batch m, ~m for backward pass
+	std::vector<int> ops;
+	const int warmup = (schedule == GPipe) ? microBatches : std::min(stages - stage - 1, microBatches);
+	for (int m = 0; m < warmup; m++)
+		ops.push_back(m);
+	for (int m = warmup; m < microBatches; m++)
+	{
+		ops.push_back(m);
+		ops.push_back(~(m - warmup));
+	}
+	for (int m = microBatches - warmup; m < microBatches; m++)
+		ops.push_back(~m);
+
+	// Outputs of the stage input and of its layers for each micro-batch in flight
+	std::vector<std::vector<Matrix>> stash(microBatches);
+
+	double busy = 0;
+	for (unsigned k = 0; k < ops.size(); k++)
+	{
+		const bool forward = (ops[k] >= 0);
+		const int m = forward ? ops[k] : ~ops[k];
+		const int first = (int)((long long)count * m / microBatches);
+		const int columns = (int)((long long)count * (m + 1) / microBatches) - first;
+
+		Matrix message;
+		if (forward && stage > 0 && !activations[stage]->pop(message, failed))
+			return;
+		if (!forward && !last && !errors[stage]->pop(message, failed))
+			return;
+
+		const Clock::time_point start = Clock::now();
+		if (forward)
+		{
+			source->output() = (stage > 0) ? message : inputs.block(0, first, inputs.rows(), columns);
+			for (int i = begin; i < end; i++)
+				layers[i]->processInput();
+
+			stash[m].push_back(source->output());
+			for (int i = begin; i < end; i++)
+				stash[m].push_back(layers[i]->output());
+
+			if (!last)
+				message = layers[end - 1]->output();
+		}
+		else
+		{
+			// Restore outputs of the micro-batch
+			source->output() = stash[m][0];
+			for (int i = begin; i < end; i++)
+				layers[i]->output() = stash[m][i - begin + 1];
+			stash[m].clear();
+
+			layers[end - 1]->error() = last
+				? errorFunction(layers[end - 1]->output(), targets.block(0, first, targets.rows(), columns))
+				: message;
+			for (int i = end - 1; i >= begin; i--)
+				layers[i]->processError();
+
+			if (stage > 0)
+				message = source->error();
+		}
+		busy += std::chrono::duration<double>(Clock::now() - start).count();
+
+		if (forward && !last && !activations[stage + 1]->push(message, failed))
+			return;
+		if (!forward && stage > 0 && !errors[stage - 1]->push(message, failed))
+			return;
+	}
+
+	_busy[stage] = busy;
+}
+
+// Trains network on a batch of samples (columns of [inputs] and [targets]).
+void PipelineTrainer::train(const Matrix& inputs, const Matrix& targets)
+{
+	if (inputs.columns() != targets.columns())
+		throw std::invalid_argument("PipelineTrainer: Numbers of inputs and targets do not match.");
+	if (microBatches <= 0 || microBatches > inputs.columns())
+		throw std::invalid_argument("PipelineTrainer: Invalid number of micro-batches.");
+
+	const std::vector<NetLayer*>& layers = _net.layers();
+	const int stages = (int)_firstLayers.size();
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// Separate stages by boundary layers and connect them by queues (enough room for all micro-batches)
+	std::vector<Boundary*> boundaries(stages, (Boundary*)NULL);
+	std::vector<Queue<Matrix>*> activations(stages, (Queue<Matrix>*)NULL);
+	std::vector<Queue<Matrix>*> errors(stages, (Queue<Matrix>*)NULL);
+	for (int s = 1; s < stages; s++)
+	{
+		NetLayer* prev = layers[_firstLayers[s] - 1];
+		boundaries[s] = new Boundary(prev->size());
+		boundaries[s]->insertAfter(prev);
+		activations[s] = new Queue<Matrix>(microBatches);
+		errors[s - 1] = new Queue<Matrix>(microBatches);
+	}
+
+	std::atomic<bool> failed(false);
+	std::exception_ptr error;
+	std::mutex errorLock;
+
+	auto worker = [&](int stage)
+	{
+		try
+		{
+			_runStage(stage, inputs, targets, boundaries, activations, errors, failed);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(errorLock);
+			if (!error)
+				error = std::current_exception();
+			failed = true;
+		}
+	};
+
+	_busy.assign(stages, 0.0);
+	if (!_stages)
+		worker(0);
+	else
+	{
+		// start the batch on the stage threads and wait for all of them
+		std::unique_lock<std::mutex> guard(_stages->lock);
+		_stages->invoke = &invokeStage<decltype(worker)>;
+		_stages->task = &worker;
+		_stages->running = stages;
+		_stages->batch++;
+		_stages->wake.notify_all();
+		_stages->wake.wait(guard, [&]() { return _stages->running == 0; });
+	}
+
+	// Deleting boundaries reconnects the stages
+	for (int s = 0; s < stages; s++)
+	{
+		delete boundaries[s];
+		delete activations[s];
+		delete errors[s];
+	}
+
+	_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (error)
+		std::rethrow_exception(error);
+
+	_net.updateParameters();
+}
+
+// Returns fraction of stage time spent idle (waiting for other stages) in the last batch.
+double PipelineTrainer::bubbleFraction() const
+{
+	if (_elapsed <= 0)
+		return 0;
+
+	double busy = 0;
+	for (unsigned s = 0; s < _busy.size(); s++)
+		busy += _busy[s];
+
+	return 1.0 - busy / (_elapsed * _busy.size());
+}
@@ -0,0 +1,81 @@
+#ifndef _PIPELINE_TRAINER_H_
+#define _PIPELINE_TRAINER_H_
+
+#include "../Net.h"
+#include <functional>
+#include <vector>
+#include <atomic>
+
+// Trains a network pipeline-parallel: contiguous groups of layers (stages) run on their own threads and each
+// batch is split into micro-batches (blocks of columns), which flow between stages through lock-free
+// single-producer single-consumer queues (activations forward, errors backward). Weights are not duplicated.
+// Stage threads are started by the constructor and kept until the trainer is destroyed.
+// Gradients of all micro-batches are accumulated by the layers and parameters are updated once per batch.
+//
+// Stages keep outputs of their layers for each micro-batch in flight (shared copy-on-write, not copied) and
+// restore them before the backward pass of the micro-batch, so layers have to compute their error only from
+// outputs (true for all layers of the library).
+//
+// Schedules:
+//	- GPipe: each stage runs forward passes of all micro-batches followed by all backward passes.
+//	- OneForwardOneBackward (1F1B): after warm-up, each stage alternates forward and backward passes, so fewer
+//	  micro-batches are in flight.
+// Both schedules give the same results (accumulated in micro-batch order), independent of the number of stages.
+// With a single micro-batch, training is bit-identical to Net::processInput(), processError() and updateParameters().
+class PipelineTrainer
+{
+public:
+	// Order of forward and backward passes of micro-batches within a stage
+	enum Schedule { GPipe, OneForwardOneBackward };
+
+private:
+	class Boundary;
+	template <class T> class Queue;
+	struct Stages;
+
+	Net& _net;
+	std::vector<int> _firstLayers;		// index of the first layer of each stage
+	std::vector<double> _busy;			// time spent computing by each stage in the last batch (seconds)
+	double _elapsed;					// duration of the last batch (seconds)
+	Stages* _stages;					// stage threads (NULL for a single stage)
+
+	// Runs operations of given stage (stage thread)
+	void _runStage(int stage, const Matrix& inputs, const Matrix& targets, std::vector<Boundary*>& boundaries,
+		std::vector<Queue<Matrix>*>& activations, std::vector<Queue<Matrix>*>& errors, std::atomic<bool>& failed);
+
+public:
+	// Creates trainer of given network (structure has to be set first). Layers are split to given number of stages
+	// with similar number of parameters.
+	PipelineTrainer(Net& net, int stages, int microBatches = 4, Schedule schedule = OneForwardOneBackward);
+
+	// Stops stage threads
+	~PipelineTrainer();
+
+	// Returns number of stages
+	int stages() const { return (int)_firstLayers.size(); }
+
+	// Returns index of the first layer of given stage
+	int firstLayer(int stage) const { return _firstLayers[stage]; }
+
+	// Trains network on a batch of samples (columns of [inputs] and [targets]). Parameters are updated once
+	// by the average gradient of the batch.
+	void train(const Matrix& inputs, const Matrix& targets);
+
+	// Returns time spent computing by given stage in the last batch (seconds).
+	double busyTime(int stage) const { return _busy[stage]; }
+
+	// Returns duration of the last batch (seconds).
+	double elapsedTime() const { return _elapsed; }
+
+	// Returns fraction of stage time spent idle (waiting for other stages) in the last batch.
+	double bubbleFraction() const;
+
+	int microBatches;		// number of micro-batches of each batch
+	Schedule schedule;		// order of passes
+
+	// Computes output error of a micro-batch from output of the network and target. Called on the thread
+	// of the last stage. Default is (output - target), i.e. gradient of the squared error.
+	std::function<Matrix(const Matrix& output, const Matrix& target)> errorFunction;
+};
+
+#endif // _PIPELINE_TRAINER_H_
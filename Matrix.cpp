@@ -1,9 +1,102 @@
 #include "Matrix.h"
 #include <memory>
+#include <charconv>
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <vector>
+#include <atomic>
+#include <unordered_map>
+#include <new>
+
+// Released storage of a thread kept for reuse
+struct StoragePool
+{
+	std::vector<void*> storages;								// free storage descriptors
+	std::unordered_map<int, std::vector<float*> > blocks;		// free data by number of elements
+	size_t bytes;												// size of free data
+
+	StoragePool() : storages(), blocks(), bytes(0) {}
+
+	~StoragePool()
+	{
+		for (size_t i = 0; i < storages.size(); i++)
+			::operator delete(storages[i]);
+
+		for (auto it = blocks.begin(); it != blocks.end(); ++it)
+			for (size_t i = 0; i < it->second.size(); i++)
+				delete[] it->second[i];
+	}
+};
+
+// Maximal size of free data of each thread (0: pooling disabled)
+static std::atomic<size_t> poolLimit(0);
+
+// Maximal number of free storage descriptors of each thread
+static const size_t poolStorages = 4096;
+
+// Number of heap allocations of data and storage descriptors
+static std::atomic<size_t> allocationCount(0);
+
+// Pool of the current thread, NULL when the thread is finishing
+static thread_local StoragePool* threadPool = NULL;
+
+// Owns the pool of the thread, releases it on thread exit
+struct StoragePoolOwner
+{
+	StoragePool pool;
+
+	StoragePoolOwner() : pool() { threadPool = &pool; }
+	~StoragePoolOwner() { threadPool = NULL; }
+};
+
+// Returns pool of the current thread (NULL when the thread is finishing)
+static StoragePool* currentPool()
+{
+	static thread_local StoragePoolOwner owner;
+	return threadPool;
+}
+
+// Sets maximal size of released data (in bytes) kept by each thread for reuse, 0 disables reuse.
+void Matrix::setPoolLimit(size_t bytes)
+{
+	poolLimit = bytes;
+}
+
+// Returns number of heap allocations made by matrices (data and storage descriptors) in all threads so far.
+size_t Matrix::allocations()
+{
+	return allocationCount;
+}
+
+// Allocates own data for given number of elements, reuses released data of the same size when possible
+float* Matrix::_allocate(int count)
+{
+	StoragePool* pool = currentPool();
+	if (pool)
+	{
+		auto it = pool->blocks.find(count);
+		if (it != pool->blocks.end() && !it->second.empty())
+		{
+			float* data = it->second.back();
+			it->second.pop_back();
+			pool->bytes -= (size_t)count * sizeof(float);
+			return data;
+		}
+	}
+
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	return new float[count];
+}
 
 // Creates empty matrix
 Matrix::Matrix()
-	: _data(NULL), _usage(new int(1)), _rows(0), _cols(0), _rInc(0), _cInc(0) {}
+	: _data(NULL), _storage(_newStorage(NULL)), _rows(0), _cols(0), _rInc(0), _cInc(0) {}
 
 
 // Copies matrix
@@ -13,12 +106,11 @@ Matrix::Matrix(const Matrix& ptR)
 	memcpy(this, &ptR, sizeof(Matrix));
 	
 	// Increase usage
-	++(*_usage);
+	++_storage->usage;
 }
 
 // Creates matrix with given dimensions. Leaves all elements uninitialized.
 Matrix::Matrix(int rows, int cols)
-	: _usage(new int(1))
 {
 	if (rows == 0 || cols == 0)
 	{
@@ -30,12 +122,14 @@ Matrix::Matrix(int rows, int cols)
 	}
 	else
 	{
-		_data = new float[rows*cols];
+		_data = _allocate(rows*cols);
 		_rows = rows;
 		_cols = cols;
 		_rInc = cols;
 		_cInc = 1;
 	}
+
+	_storage = _newStorage(_data, rows*cols);
 }
 
 // Creates matrix with given size. Leaves all elements uninitialized.
@@ -52,41 +146,147 @@ Matrix::Matrix(const std::vector<float>& vec)
 	memcpy(_data, vec.data(), _rows*sizeof(float));
 }
 
+// Wraps external read-only data without copying. Element [r, c] is data[r * rowStride + c * colStride].
+Matrix::Matrix(const float* data, int rows, int cols, int rowStride, int colStride, ReleaseFunc release, void* context)
+{
+	_wrap(const_cast<float*>(data), rows, cols, rowStride, colStride, true, release, context);
+}
+
+// Wraps external writable data without copying. Element [r, c] is data[r * rowStride + c * colStride].
+Matrix::Matrix(float* data, int rows, int cols, int rowStride, int colStride, ReleaseFunc release, void* context)
+{
+	_wrap(data, rows, cols, rowStride, colStride, false, release, context);
+}
+
+// Initializes matrix wrapping external data (constructor helper)
+void Matrix::_wrap(float* data, int rows, int cols, int rowStride, int colStride, bool readOnly, ReleaseFunc release, void* context)
+{
+	if (rows < 0 || cols < 0 || rowStride < 0 || colStride < 0)
+		throw std::invalid_argument("Matrix: Negative dimensions or strides.");
+
+	const bool empty = (rows == 0 || cols == 0 || data == NULL);
+
+	_data = empty ? NULL : data;
+	_rows = empty ? 0 : rows;
+	_cols = empty ? 0 : cols;
+	_rInc = empty ? 0 : rowStride;
+	_cInc = empty ? 0 : colStride;
+
+	// storage keeps original pointer for the release function even when the matrix is empty
+	_storage = _newStorage(data);
+	_storage->external = true;
+	_storage->readOnly = readOnly;
+	_storage->release = release;
+	_storage->context = context;
+}
+
+// Release function deleting data allocated by new[]
+void Matrix::deleteData(float* data, void* context)
+{
+	delete[] data;
+}
+
+// Release function freeing data allocated by malloc()
+void Matrix::freeData(float* data, void* context)
+{
+	std::free(data);
+}
+
 // Destructor
 Matrix::~Matrix()
 {
-	// Decrease usage and check
-	if (--(*_usage) == 0)
-	{
-		// No more usage
-		if (_data)
-			delete[] _data;
+	_release();
+}
 
-		delete _usage;
+// Allocates new storage descriptor with usage 1
+Matrix::Storage* Matrix::_newStorage(float* data, int capacity)
+{
+	// reuse released descriptor of the thread
+	void* memory = NULL;
+	StoragePool* pool = currentPool();
+	if (pool && !pool->storages.empty())
+	{
+		memory = pool->storages.back();
+		pool->storages.pop_back();
+	}
+	else
+	{
+		allocationCount.fetch_add(1, std::memory_order_relaxed);
+		memory = ::operator new(sizeof(Storage));
 	}
 
-	
+	Storage* storage = new (memory) Storage();
+	storage->usage = 1;
+	storage->external = false;
+	storage->readOnly = false;
+	storage->data = data;
+	storage->release = NULL;
+	storage->context = NULL;
+	storage->capacity = data ? capacity : 0;
+
+	return storage;
+}
+
+// Decreases usage of current storage and frees it when not used anymore
+void Matrix::_release()
+{
+	if (--_storage->usage == 0)
+	{
+		// No more usage, own data and descriptor are kept by the pool of the thread while within limits
+		StoragePool* pool = currentPool();
+		const size_t size = (size_t)_storage->capacity * sizeof(float);
+
+		if (_storage->release)
+			_storage->release(_storage->data, _storage->context);
+		else if (_storage->data && !_storage->external)
+		{
+			if (pool && pool->bytes + size <= poolLimit)
+			{
+				pool->blocks[_storage->capacity].push_back(_storage->data);
+				pool->bytes += size;
+			}
+			else
+				delete[] _storage->data;
+		}
+
+		_storage->~Storage();
+		if (pool && poolLimit > 0 && pool->storages.size() < poolStorages)
+			pool->storages.push_back(_storage);
+		else
+			::operator delete(_storage);
+	}
 }
 
 // Makes current storage unique (e.g. on change)
 void Matrix::_unique()
 {
-	if ((*_usage) == 1 || _data == NULL)
+	if ((_storage->usage == 1 && !_storage->readOnly) || _data == NULL)
 		return; // already unique or empty
 
-	// Allocate new space and copy content plain
-	float* newData = new float[_rows*_cols];
-	memcpy(newData, _data, _rows*_cols*sizeof(float));
+	// Allocate new space and copy content
+	float* newData = _allocate(_rows*_cols);
+	if (_rInc == _cols && _cInc == 1)
+	{
+		memcpy(newData, _data, _rows*_cols*sizeof(float));
+	}
+	else
+	{
+		// strided (e.g. transposed) view, new storage is ordered row by row
+		float* dst = newData;
+		for (int r = 0; r < _rows; r++)
+			for (int c = 0; c < _cols; c++)
+				(*dst++) = _data[r * _rInc + c * _cInc];
 
-	// Allocate new usage pointer
-	int* newUsage = new int(1);
+		_rInc = _cols;
+		_cInc = 1;
+	}
 
-	// Decrease existing usage
-	--(*_usage);
+	// Release existing storage
+	_release();
 
-	// Assign new data and usage pointer
+	// Assign new data and storage
 	_data = newData;
-	_usage = newUsage;
+	_storage = _newStorage(newData, _rows*_cols);
 }
 
 // Sums two matrices
@@ -209,29 +409,366 @@ Matrix Matrix::operator -() const
 	return res;
 }
 
-// Multiplies two matrices
-Matrix Matrix::operator * (const Matrix& ptR) const
+// Kernels of the current thread may be split between worker threads (see Matrix::setParallel()).
+static thread_local bool parallelEnabled = true;
+
+// Enables or disables splitting of large kernels between threads for the calling thread only.
+void Matrix::setParallel(bool enable)
+{
+	parallelEnabled = enable;
+}
+
+// Maximal number of parts of a parallel kernel
+static const int maxWorkers = 64;
+
+// Returns number of worker threads worth to use for given amount of multiply-add operations.
+static int workerCount(double ops)
+{
+	static const double minOpsPerThread = 1 << 20;
+
+	if (!parallelEnabled)
+		return 1;
+
+	int count = (int)std::thread::hardware_concurrency();
+	if (count < 1)
+		count = 1;
+	if (count > maxWorkers)
+		count = maxWorkers;
+
+	const int useful = (int)(ops / minOpsPerThread);
+	return (useful < count) ? ((useful < 1) ? 1 : useful) : count;
+}
+
+// Persistent threads running parts of large kernels together with the calling thread. Threads are started on the
+// first parallel kernel and kept until exit, so kernels do not create threads or allocate. One kernel runs at
+// a time, kernels of other threads run serially meanwhile.
+struct KernelPool
+{
+	std::vector<std::thread> threads;
+	std::mutex busy;					// held by the thread running a kernel
+	std::mutex lock;
+	std::condition_variable wake;		// kernel is started, part is finished or pool stops
+
+	void (*invoke)(const void* kernel, int begin, int end);
+	const void* kernel;
+	const int* bounds;					// part p covers rows [bounds[p], bounds[p + 1])
+	int parts;
+	int next;							// next part to run
+	int finished;						// number of finished parts
+	unsigned job;						// number of the current kernel
+	bool stop;
+
+	KernelPool() : threads(), invoke(NULL), kernel(NULL), bounds(NULL), parts(0), next(0), finished(0), job(0), stop(false)
+	{
+		const int count = std::min((int)std::thread::hardware_concurrency(), maxWorkers);
+		for (int t = 1; t < count; t++)
+		{
+			threads.push_back(std::thread([this]()
+			{
+				Matrix::setParallel(false);
+				std::unique_lock<std::mutex> guard(lock);
+				unsigned done = job;
+				while (true)
+				{
+					wake.wait(guard, [&]() { return stop || job != done; });
+					if (stop)
+						return;
+
+					done = job;
+					work(guard, done);
+				}
+			}));
+		}
+	}
+
+	~KernelPool()
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			stop = true;
+		}
+		wake.notify_all();
+
+		for (unsigned t = 0; t < threads.size(); t++)
+			threads[t].join();
+	}
+
+	// Runs parts of kernel number [current] until none is left (called with the lock)
+	void work(std::unique_lock<std::mutex>& guard, unsigned current)
+	{
+		while (job == current && next < parts)
+		{
+			const int part = next++;
+			guard.unlock();
+			invoke(kernel, bounds[part], bounds[part + 1]);
+			guard.lock();
+
+			if (++finished == parts)
+				wake.notify_all();
+		}
+	}
+
+	// Runs kernel over given parts, returns false when the pool is used by another thread
+	bool run(void (*function)(const void*, int, int), const void* data, const int* partBounds, int count)
+	{
+		std::unique_lock<std::mutex> running(busy, std::try_to_lock);
+		if (!running.owns_lock())
+			return false;
+
+		std::unique_lock<std::mutex> guard(lock);
+		invoke = function;
+		kernel = data;
+		bounds = partBounds;
+		parts = count;
+		next = 0;
+		finished = 0;
+		const unsigned current = ++job;
+		wake.notify_all();
+
+		work(guard, current);
+		wake.wait(guard, [&]() { return finished == parts; });
+		return true;
+	}
+};
+
+// Calls kernel(begin, end) of type Kernel
+template <class Kernel>
+static void invokeKernel(const void* kernel, int begin, int end)
+{
+	(*(const Kernel*)kernel)(begin, end);
+}
+
+// Returns kernel pool of the process (started on the first call)
+static KernelPool& kernelPool()
+{
+	static KernelPool pool;
+	return pool;
+}
+
+// Runs kernel(bounds[p], bounds[p + 1]) for each of [parts] parts, in parallel on the kernel pool when possible.
+template <class Kernel>
+static void runParts(const int* bounds, int parts, const Kernel& kernel)
+{
+	if (parts > 1 && kernelPool().run(&invokeKernel<Kernel>, &kernel, bounds, parts))
+		return;
+
+	for (int p = 0; p < parts; p++)
+		kernel(bounds[p], bounds[p + 1]);
+}
+
+// Runs kernel(begin, end) over row ranges split between worker threads.
+template <class Kernel>
+static void parallelRows(int rows, double ops, const Kernel& kernel)
+{
+	const int workers = workerCount(ops);
+	if (workers <= 1 || rows < 2)
+	{
+		kernel(0, rows);
+		return;
+	}
+
+	int bounds[maxWorkers + 1];
+	for (int t = 0; t <= workers; t++)
+		bounds[t] = (int)((long long)rows * t / workers);
+
+	runParts(bounds, workers, kernel);
+}
+
+// Multiplies two matrices and calls epilogue(row, index, length) on each finished row of the result.
+// Blocked over column panels and depth, rows are split between threads for large products. Each element
+// accumulates products in increasing order of the inner index, so results match the plain dot product.
+template <class Epilogue>
+Matrix Matrix::_product(const Matrix& ptR, const Epilogue& epilogue) const
 {
 	if (_cols != ptR._rows)
 		throw std::invalid_argument("Matrix: Dimension mismatch.");
 
-	const int resRows = _rows;
-	const int resCols = ptR._cols;
+	const int m = _rows;
+	const int n = ptR._cols;
+	const int k = _cols;
 
-	Matrix res(resRows, resCols);
+	Matrix res(m, n);
+	if (m == 0 || n == 0)
+		return res;
 
 	float* dst = res._data;
-	for (int r = 0; r < resRows; r++)
+	for (int i = 0; i < m * n; i++)
+		dst[i] = 0.0f;
+
+	// left operand is used in place when dense or transposed dense (e.g. trans(W) * e), right one row by row
+	Matrix tmpA, tmpB;
+	const bool transposed = (_rInc == 1 && _cInc == _rows && _rows > 1);
+	const float* a = transposed ? _data : _contiguous(tmpA);
+	const int aRow = transposed ? 1 : k;
+	const int aCol = transposed ? m : 1;
+	const float* b = ptR._contiguous(tmpB);
+
+	auto kernel = [=](int rBegin, int rEnd)
 	{
-		for (int c = 0; c < resCols; c++)
+		if (n == 1 && !transposed)
 		{
-			float val = 0;
+			// matrix * vector: dot products
+			for (int i = rBegin; i < rEnd; i++)
+			{
+				const float* ai = a + i * k;
+				float val = 0.0f;
+				for (int p = 0; p < k; p++)
+					val += ai[p] * b[p];
 
-			for (int k = 0; k < _cols; k++)
-				val += this->at(r, k) * ptR.at(k, c); 
+				dst[i] = val;
+			}
+		}
+		else if (n == 1)
+		{
+			// trans(matrix) * vector: rows of the matrix scaled and accumulated
+			for (int p = 0; p < k; p++)
+			{
+				const float* ap = a + p * m;
+				const float x = b[p];
+				for (int i = rBegin; i < rEnd; i++)
+					dst[i] += ap[i] * x;
+			}
+		}
+		else
+		{
+			// C[i, j0..j1) += A[i, p] * B[p, j0..j1) over panels of j and blocks of p
+			for (int j0 = 0; j0 < n; j0 += _panelWidth)
+			{
+				const int j1 = (n - j0 < _panelWidth) ? n : j0 + _panelWidth;
+				for (int p0 = 0; p0 < k; p0 += _blockDepth)
+				{
+					const int p1 = (k - p0 < _blockDepth) ? k : p0 + _blockDepth;
+					// four rows at once share loads of B
+					int i = rBegin;
+					for (; i + 4 <= rEnd; i += 4)
+					{
+						float* __restrict c0 = dst + i * n;
+						float* __restrict c1 = c0 + n;
+						float* __restrict c2 = c1 + n;
+						float* __restrict c3 = c2 + n;
+						for (int p = p0; p < p1; p++)
+						{
+							const float* ap = a + i * aRow + p * aCol;
+							const float x0 = ap[0], x1 = ap[aRow], x2 = ap[2 * aRow], x3 = ap[3 * aRow];
+							const float* __restrict bp = b + p * n;
+							for (int j = j0; j < j1; j++)
+							{
+								const float y = bp[j];
+								c0[j] += x0 * y;
+								c1[j] += x1 * y;
+								c2[j] += x2 * y;
+								c3[j] += x3 * y;
+							}
+						}
+					}
+
+					for (; i < rEnd; i++)
+					{
+						float* __restrict ci = dst + i * n;
+						for (int p = p0; p < p1; p++)
+						{
+							const float x = a[i * aRow + p * aCol];
+							const float* __restrict bp = b + p * n;
+							for (int j = j0; j < j1; j++)
+								ci[j] += x * bp[j];
+						}
+					}
+				}
+			}
+		}
+
+		// finished rows are processed by the same thread
+		for (int i = rBegin; i < rEnd; i++)
+			epilogue(dst + i * n, i, n);
+	};
 
-			(*dst++) = val;
+	parallelRows(m, (double)m * n * k, kernel);
+	return res;
+}
+
+// Multiplies two matrices (see _product()).
+Matrix Matrix::operator * (const Matrix& ptR) const
+{
+	return _product(ptR, [](float*, int, int) {});
+}
+
+// Computes act(A * B + v) (v added to each column) with bias and activation applied to each row of the product
+// right after it is computed.
+Matrix Matrix::affine(const Matrix& matA, const Matrix& matB, const Matrix& vec, Activation act)
+{
+	if (vec._rows != matA._rows || vec._cols != 1)
+		throw std::invalid_argument("Matrix::affine: Dimension mismatch.");
+
+	Matrix tmpV;
+	const float* v = vec._contiguous(tmpV);
+
+	// same formulas as the separate functions (see tanh(), max() and softplus())
+	return matA._product(matB, [=](float* row, int i, int n)
+	{
+		const float bias = v[i];
+		switch (act)
+		{
+		case Identity:
+			for (int j = 0; j < n; j++)
+				row[j] = row[j] + bias;
+			break;
+		case Tanh:
+			for (int j = 0; j < n; j++)
+				row[j] = std::tanh(row[j] + bias);
+			break;
+		case Rectifier:
+			for (int j = 0; j < n; j++)
+			{
+				const float x = row[j] + bias;
+				row[j] = (x > 0.0f) ? x : 0.0f;
+			}
+			break;
+		case Softplus:
+			for (int j = 0; j < n; j++)
+			{
+				const float x = row[j] + bias;
+				if (x > 20.0f)			row[j] = x;
+				else if (x < -20.0f)	row[j] = 0.0f;
+				else					row[j] = std::log(std::exp(x) + 1.0f);
+			}
+			break;
 		}
+	});
+}
+
+// Returns error before activation from output of the activation [matY] and error [matE] in one pass.
+Matrix Matrix::activationError(const Matrix& matY, const Matrix& matE, Activation act)
+{
+	if (matY._rows != matE._rows || matY._cols != matE._cols)
+		throw std::invalid_argument("Matrix::activationError: Dimension mismatch.");
+
+	if (act == Identity)
+		return matE; // shared, no copy
+
+	Matrix res(matE._rows, matE._cols);
+	Matrix tmpY, tmpE;
+	const float* __restrict y = matY._contiguous(tmpY);
+	const float* __restrict e = matE._contiguous(tmpE);
+	float* __restrict dst = res._data;
+	const int n = res._rows * res._cols;
+
+	switch (act)
+	{
+	case Identity:
+		break;
+	case Tanh:
+		for (int i = 0; i < n; i++)
+			dst[i] = (1.0f - y[i] * y[i]) * e[i];
+		break;
+	case Rectifier:
+		for (int i = 0; i < n; i++)
+			dst[i] = ((y[i] > 0.0f) ? 1.0f : 0.0f) * e[i];
+		break;
+	case Softplus:
+		// sigmoid(x) = 1 - exp(-softplus(x))
+		for (int i = 0; i < n; i++)
+			dst[i] = -std::expm1(-y[i]) * e[i];
+		break;
 	}
 
 	return res;
@@ -408,9 +945,9 @@ Matrix Matrix::solve(const Matrix& matA, const Matrix& matB)
 		}
 		else
 		{
-			// pseudoinversion
+			// pseudoinversion, trans(A) * A is computed as symmetric product
 			Matrix matAt = matA.t();
-			return (matAt * matA).inv() * matAt * matB;
+			return syrk(matAt).inv() * (matAt * matB);
 		}
 	}
 	catch (std::runtime_error)
@@ -452,6 +989,239 @@ Matrix Matrix::elemDiv(const Matrix& ptL, const Matrix& ptR)
 }
 
 
+// Returns pointer to contiguous data stored row by row.
+// Copies content to [tmp] when the matrix is not stored row by row (e.g. transposed).
+const float* Matrix::_contiguous(Matrix& tmp) const
+{
+	if (_rInc == _cols && _cInc == 1)
+		return _data;
+
+	tmp = Matrix(_rows, _cols);
+
+	float* dst = tmp._data;
+	for (int r = 0; r < _rows; r++)
+		for (int c = 0; c < _cols; c++)
+			(*dst++) = this->at(r, c);
+
+	return tmp._data;
+}
+
+// Solves triangular system T * X = B using lower (or upper) triangle of T.
+Matrix Matrix::trsm(const Matrix& matT, const Matrix& matB, bool upper, bool unitDiag)
+{
+	if (matT._rows != matT._cols || matT._rows != matB._rows)
+		throw std::invalid_argument("Matrix::trsm: Dimension mismatch.");
+
+	const int n = matB._rows;
+	const int m = matB._cols;
+
+	// X = B (row by row)
+	Matrix res(n, m);
+	float* dst = res._data;
+	for (int r = 0; r < n; r++)
+		for (int c = 0; c < m; c++)
+			(*dst++) = matB.at(r, c);
+
+	// substitution is done over column panels of X to keep solved rows in cache
+	for (int c0 = 0; c0 < m; c0 += _panelWidth)
+	{
+		const int w = (m - c0 < _panelWidth) ? m - c0 : _panelWidth;
+
+		for (int i = 0; i < n; i++)
+		{
+			const int r = upper ? n - 1 - i : i;
+			float* xr = res._data + r * m + c0;
+
+			// X[r,:] -= T[r,k] * X[k,:] for already solved rows k
+			const int kBegin = upper ? r + 1 : 0;
+			const int kEnd = upper ? n : r;
+			for (int k = kBegin; k < kEnd; k++)
+			{
+				const float t = matT.at(r, k);
+				if (t == 0.0f)
+					continue;
+
+				const float* xk = res._data + k * m + c0;
+				for (int j = 0; j < w; j++)
+					xr[j] -= t * xk[j];
+			}
+
+			if (!unitDiag)
+			{
+				const float d = matT.at(r, r);
+				if (d == 0.0f)
+					throw std::runtime_error("Matrix::trsm: Matrix is singular.");
+
+				const float coef = 1.0f / d;
+				for (int j = 0; j < w; j++)
+					xr[j] *= coef;
+			}
+		}
+	}
+
+	return res;
+}
+
+// Multiplies matrix B by triangular matrix T (T * B) using lower (or upper) triangle of T.
+Matrix Matrix::trmm(const Matrix& matT, const Matrix& matB, bool upper, bool unitDiag)
+{
+	if (matT._rows != matT._cols || matT._rows != matB._rows)
+		throw std::invalid_argument("Matrix::trmm: Dimension mismatch.");
+
+	const int n = matB._rows;
+	const int m = matB._cols;
+
+	Matrix tmp;
+	const float* src = matB._contiguous(tmp);
+
+	Matrix res(n, m);
+	if (n == 0 || m == 0)
+		return res;
+
+	for (int c0 = 0; c0 < m; c0 += _panelWidth)
+	{
+		const int w = (m - c0 < _panelWidth) ? m - c0 : _panelWidth;
+
+		for (int r = 0; r < n; r++)
+		{
+			float* yr = res._data + r * m + c0;
+
+			// diagonal term
+			const float d = unitDiag ? 1.0f : matT.at(r, r);
+			const float* br = src + r * m + c0;
+			for (int j = 0; j < w; j++)
+				yr[j] = d * br[j];
+
+			// Y[r,:] += T[r,k] * B[k,:] over the triangle
+			const int kBegin = upper ? r + 1 : 0;
+			const int kEnd = upper ? n : r;
+			for (int k = kBegin; k < kEnd; k++)
+			{
+				const float t = matT.at(r, k);
+				if (t == 0.0f)
+					continue;
+
+				const float* bk = src + k * m + c0;
+				for (int j = 0; j < w; j++)
+					yr[j] += t * bk[j];
+			}
+		}
+	}
+
+	return res;
+}
+
+// Computes lower triangle of M * trans(M) to [dst], packed (row i at i * (i + 1) / 2) or dense (row i at i * n)
+void Matrix::_syrk(const Matrix& mat, float* dst, bool packed)
+{
+	const int n = mat._rows;
+	const int k = mat._cols;
+
+	const size_t count = packed ? (size_t)n * (n + 1) / 2 : (size_t)n * n;
+	for (size_t i = 0; i < count; i++)
+		dst[i] = 0.0f;
+
+	if (n == 0 || k == 0)
+		return;
+
+	// trans(M) stored row by row. No copy is needed when M itself is a transposed view (e.g. syrk(A.t())).
+	Matrix tmp;
+	const float* src = mat.t()._contiguous(tmp);
+
+	// rows [rBegin, rEnd) of lower triangle: C[i, 0..i] += M[i, p] * M[0..i, p] over panels of p
+	auto kernel = [=](int rBegin, int rEnd)
+	{
+		for (int p0 = 0; p0 < k; p0 += _panelWidth)
+		{
+			const int p1 = (k - p0 < _panelWidth) ? k : p0 + _panelWidth;
+			for (int i = rBegin; i < rEnd; i++)
+			{
+				float* ci = dst + (packed ? (size_t)i * (i + 1) / 2 : (size_t)i * n);
+				for (int p = p0; p < p1; p++)
+				{
+					const float* row = src + p * n;
+					const float a = row[i];
+					for (int j = 0; j <= i; j++)
+						ci[j] += a * row[j];
+				}
+			}
+		}
+	};
+
+	// split rows so that each thread gets the same area of the triangle
+	const int workers = workerCount(0.5 * n * n * k);
+	if (workers <= 1)
+	{
+		kernel(0, n);
+	}
+	else
+	{
+		int bounds[maxWorkers + 1];
+		bounds[0] = 0;
+		for (int t = 1; t <= workers; t++)
+		{
+			const int rEnd = (t == workers) ? n : (int)(n * std::sqrt((double)t / workers));
+			bounds[t] = std::max(rEnd, bounds[t - 1]);
+		}
+
+		runParts(bounds, workers, kernel);
+	}
+}
+
+// Computes symmetric product M * trans(M). Only lower triangle is computed, upper is mirrored (when [mirror] is set).
+Matrix Matrix::syrk(const Matrix& mat, bool mirror)
+{
+	const int n = mat._rows;
+
+	Matrix res(n, n);
+	if (n == 0)
+		return res;
+
+	float* dst = res._data;
+	_syrk(mat, dst, false);
+
+	if (mirror)
+	{
+		for (int i = 0; i < n; i++)
+			for (int j = i + 1; j < n; j++)
+				dst[i * n + j] = dst[j * n + i];
+	}
+
+	return res;
+}
+
+// Computes lower triangle of M * trans(M) in parallel directly to packed storage [dst] (see SymmetricMatrix).
+void Matrix::syrkPacked(const Matrix& mat, float* dst)
+{
+	_syrk(mat, dst, true);
+}
+
+// Returns view of the block of given size starting at [row], [col]. Data are shared (copied on change).
+Matrix Matrix::block(int row, int col, int rows, int cols) const
+{
+	if (row < 0 || col < 0 || rows < 0 || cols < 0 || row + rows > _rows || col + cols > _cols)
+		throw std::out_of_range("Matrix: Index out of range.");
+
+	// Copy matrix wrapper and move to the first element
+	Matrix res(*this);
+	if (_data)
+		res._data = _data + row * _rInc + col * _cInc;
+
+	res._rows = rows;
+	res._cols = cols;
+
+	return res;
+}
+
+// Returns matrix wrapping the same elements without copy-on-write.
+Matrix Matrix::alias()
+{
+	// make elements private first, so the alias does not change other copies
+	_unique();
+
+	return Matrix(_data, _rows, _cols, _rInc, _cInc);
+}
+
 // Returns given row as a matrix
 Matrix Matrix::row(int idx) const
 {
@@ -486,9 +1256,55 @@ Matrix Matrix::column(int idx) const
 float Matrix::sum() const
 {
 	float res = 0.0f;
-	const float* src = _data;
-	for (int i = 0; i < _rows*_cols; i++)
-		res += (*src++);
+	if (_dense())
+	{
+		const float* src = _data;
+		for (int i = 0; i < _rows*_cols; i++)
+			res += (*src++);
+	}
+	else
+	{
+		for (int r = 0; r < _rows; r++)
+			for (int c = 0; c < _cols; c++)
+				res += this->at(r, c);
+	}
+
+	return res;
+}
+
+// Returns sum of all columns (column vector of row sums).
+Matrix Matrix::sumColumns() const
+{
+	Matrix res(_rows, 1);
+	for (int r = 0; r < _rows; r++)
+	{
+		const float* src = _data + r * _rInc;
+		float val = 0.0f;
+		for (int c = 0; c < _cols; c++, src += _cInc)
+			val += *src;
+
+		res._data[r] = val;
+	}
+
+	return res;
+}
+
+// Returns matrix with column vector [vec] added to each column of [mat].
+Matrix Matrix::addToColumns(const Matrix& mat, const Matrix& vec)
+{
+	if (vec._rows != mat._rows || vec._cols != 1)
+		throw std::invalid_argument("Matrix::addToColumns: Dimension mismatch.");
+
+	Matrix res(mat._rows, mat._cols);
+
+	float* dst = res._data;
+	for (int r = 0; r < res._rows; r++)
+	{
+		const float v = vec.at(r, 0);
+		const float* src = mat._data + r * mat._rInc;
+		for (int c = 0; c < res._cols; c++, src += mat._cInc)
+			(*dst++) = *src + v;
+	}
 
 	return res;
 }
@@ -526,8 +1342,33 @@ void Matrix::clear()
 {
 	_unique();
 
-	for (int i = 0; i < _rows * _cols; i++)
-		_data[i] = 0.0f;
+	if (_dense())
+	{
+		for (int i = 0; i < _rows * _cols; i++)
+			_data[i] = 0.0f;
+	}
+	else
+	{
+		for (int r = 0; r < _rows; r++)
+			for (int c = 0; c < _cols; c++)
+				_at(r, c) = 0.0f;
+	}
+}
+
+// Copies content of given matrix to current storage. Dimensions have to match.
+void Matrix::assign(const Matrix& src)
+{
+	if (_rows != src._rows || _cols != src._cols)
+		throw std::invalid_argument("Matrix::assign: Dimension mismatch.");
+
+	if (_data == src._data && _rInc == src._rInc && _cInc == src._cInc)
+		return; // same elements
+
+	_unique();
+
+	for (int r = 0; r < _rows; r++)
+		for (int c = 0; c < _cols; c++)
+			_at(r, c) = src.at(r, c);
 }
 
 // Assign operator
@@ -536,22 +1377,15 @@ const Matrix& Matrix::operator = (const Matrix& ptR)
 	if (this == &ptR)
 		return (*this); // nothing to do
 
-	// Decrease existing usage
-	if (--(*_usage) == 0)
-	{
-		// unique, delete existing storage
-		if (_data)
-			delete[] _data;
+	// increase use counter first (matrix may be assigned to its own view)
+	++ptR._storage->usage;
 
-		delete _usage;
-	}
+	// Decrease existing usage
+	_release();
 
 	// copy wrapper
 	memcpy(this, &ptR, sizeof(Matrix));
 
-	// increase use counter
-	++(*_usage);
-
 	return (*this);
 }
 
@@ -560,8 +1394,9 @@ void Matrix::rand(float min, float max)
 {
 	_unique();
 
-	for (int i = 0; i < _rows * _cols; i++)
-		_data[i] = (float)std::rand() * (max - min) / RAND_MAX + min;
+	for (int r = 0; r < _rows; r++)
+		for (int c = 0; c < _cols; c++)
+			_at(r, c) = (float)std::rand() * (max - min) / RAND_MAX + min;
 }
 
 // Reshapes matrix to given size row by row.
@@ -608,7 +1443,7 @@ void Matrix::resize(int newRows, int newCols)
 	float* newData;
 	if (newRows * newCols > 0)
 	{
-		newData = new float[newRows*newCols];
+		newData = _allocate(newRows*newCols);
 
 		// copy content row by row
 		float* dst = newData;
@@ -640,23 +1475,12 @@ void Matrix::resize(int newRows, int newCols)
 	}
 
 
-	if ((*_usage) == 1)
-	{
-		// unique, delete old storage, keep unique usage
-		if (_data)
-			delete[] _data;
-	}
-	else
-	{
-		// decrease usage
-		--(*_usage);
-
-		// allocate new usage
-		_usage = new int(1);
-	}
+	// release old storage
+	_release();
 
 	// assign new data
 	_data = newData;
+	_storage = _newStorage(newData, _rows*_cols);
 }
 
 
@@ -671,6 +1495,8 @@ std::istream& operator >> (std::istream& str, Matrix& mat)
 
 	mat.resize(rows, cols);
 
+	// storage of the same size may be shared or read-only (e.g. wrapped by binary model)
+	mat._unique();
 	for (int r = 0; r < mat.rows(); r++)
 		for (int c = 0; c < mat.columns(); c++)
 			str >> mat._at(r, c);
@@ -678,17 +1504,25 @@ std::istream& operator >> (std::istream& str, Matrix& mat)
 	return str;
 }
 
-// Stream write operator
+// Stream write operator. Values are written in the shortest form which reads back exactly.
 std::ostream& operator << (std::ostream& str, const Matrix& mat)
 {
-	str << mat.rows() << "\t" << mat.columns() << std::endl;
+	str << mat.rows() << "\t" << mat.columns() << "\n";
+
+	std::string line;
+	char buf[32];
 	for (int r = 0; r < mat.rows(); r++)
 	{
+		line.clear();
 		for (int c = 0; c < mat.columns(); c++)
-			str << mat.at(r, c) << "\t";
+		{
+			line.append(buf, std::to_chars(buf, buf + sizeof(buf), mat.at(r, c)).ptr - buf);
+			line.push_back('\t');
+		}
 
 		// write new line
-		str << std::endl;
+		line.push_back('\n');
+		str.write(line.data(), line.size());
 	}
 	return str;
 }
@@ -1025,7 +1859,7 @@ Matrix Matrix::isNaN() const
 	{
 		for (int c = 0; c < res._cols; c++)
 		{
-			if (isnan(this->at(r, c)))
+			if (std::isnan(this->at(r, c)))
 				(*dst++) = 1.0f;
 			else
 				(*dst++) = 0.0f;
@@ -4,6 +4,7 @@
 #include <cstdlib>
 #include <vector>
 #include <iostream>
+#include <atomic>
 
 // Size of the matrix
 struct Size
@@ -26,9 +27,25 @@ struct Size
 // Implements 2D matrix of real numbers (float)
 class Matrix
 {
+public:
+	// Function releasing external data (see constructor with external data)
+	typedef void (*ReleaseFunc)(float* data, void* context);
+
 private:
+	// Storage shared by copies of the matrix
+	struct Storage
+	{
+		std::atomic<int> usage;	// number of matrices using the storage (copies may live in different threads)
+		bool external;			// data are not owned by the matrix (see release)
+		bool readOnly;			// data can not be changed in place (copied on first change)
+		float* data;			// beginning of the data
+		ReleaseFunc release;	// releases external data (NULL for own data)
+		void* context;			// context of the release function
+		int capacity;			// number of elements of own data (see _allocate())
+	};
+
 	float* _data;
-	int* _usage;
+	Storage* _storage;
 	int _rows;
 	int _cols;
 	int _rInc;
@@ -37,6 +54,21 @@ private:
 	// Makes current storage unique (e.g. on change)
 	void _unique();
 
+	// Allocates new storage descriptor with usage 1 ([capacity] of own data, 0 for external data)
+	static Storage* _newStorage(float* data, int capacity = 0);
+
+	// Allocates own data for given number of elements, reuses released data of the same size when possible
+	static float* _allocate(int count);
+
+	// Decreases usage of current storage and frees it when not used anymore
+	void _release();
+
+	// Initializes matrix wrapping external data (constructor helper)
+	void _wrap(float* data, int rows, int cols, int rowStride, int colStride, bool readOnly, ReleaseFunc release, void* context);
+
+	// Returns true when elements occupy continuous block of memory (row by row or column by column)
+	bool _dense() const { return (_rInc == _cols && _cInc == 1) || (_rInc == 1 && _cInc == _rows); }
+
 public:
 	// Creates empty matrix
 	Matrix();
@@ -53,6 +85,22 @@ public:
 	// Creates matrix from vector of floats (column vector)
 	Matrix(const std::vector<float>& vec);
 
+	// Wraps external read-only data without copying. Element [r, c] is data[r * rowStride + c * colStride].
+	// Data are copied on first change. Data are not owned when [release] is NULL, otherwise [release] is called
+	// with [context] when no matrix uses the data anymore (custom deleter, see deleteData() and freeData()).
+	Matrix(const float* data, int rows, int cols, int rowStride, int colStride, ReleaseFunc release = NULL, void* context = NULL);
+
+	// Wraps external writable data without copying. Element [r, c] is data[r * rowStride + c * colStride].
+	// Data are changed in place while not shared with another matrix, shared data are copied on change (copy-on-write).
+	// Ownership is the same as for read-only data.
+	Matrix(float* data, int rows, int cols, int rowStride, int colStride, ReleaseFunc release = NULL, void* context = NULL);
+
+	// Release function deleting data allocated by new[]
+	static void deleteData(float* data, void* context);
+
+	// Release function freeing data allocated by malloc()
+	static void freeData(float* data, void* context);
+
 	// Destructor
 	~Matrix();
 
@@ -78,6 +126,17 @@ public:
 	// Multiplies two matrices
 	Matrix operator * (const Matrix& ptR) const;
 
+	// Activation functions of fused kernels (see affine())
+	enum Activation { Identity, Tanh, Rectifier, Softplus };
+
+	// Computes act(A * B + v), vector [vec] is added to each column. Bias and activation are applied while the rows
+	// of the product are hot in cache. Values are the same as of the separate operations.
+	static Matrix affine(const Matrix& matA, const Matrix& matB, const Matrix& vec, Activation act = Identity);
+
+	// Returns error before activation (act'(x) .* E) from output of the activation [matY] and error [matE].
+	// Derivatives are computed from the output: 1 - y^2 (tanh), y > 0 (rectifier), 1 - exp(-y) (softplus).
+	static Matrix activationError(const Matrix& matY, const Matrix& matE, Activation act);
+
 	// Multiplies matrix by scalar
 	Matrix operator * (float val) const;
 	const Matrix& operator *= (float val);
@@ -99,6 +158,37 @@ public:
 	// Note: trans(X) * trans(A) = trans(B) is equivalent
 	static Matrix solve(const Matrix& matA, const Matrix& matB);
 
+	// Solves triangular system T * X = B using lower (or upper) triangle of T. Other triangle is not accessed.
+	// When [unitDiag] is set, diagonal of T is assumed to be ones. Use T.t() to solve trans(T) * X = B.
+	static Matrix trsm(const Matrix& matT, const Matrix& matB, bool upper = false, bool unitDiag = false);
+
+	// Multiplies matrix B by triangular matrix T (T * B) using lower (or upper) triangle of T.
+	// When [unitDiag] is set, diagonal of T is assumed to be ones.
+	static Matrix trmm(const Matrix& matT, const Matrix& matB, bool upper = false, bool unitDiag = false);
+
+	// Enables or disables splitting of large kernels between threads for the calling thread only
+	// (e.g. worker threads which already run in parallel). Results do not depend on the setting.
+	// Kernels run on persistent threads (started by the first large kernel), so they do not create threads.
+	static void setParallel(bool enable);
+
+	// Sets maximal size of released data (in bytes) kept by each thread for reuse, 0 disables reuse.
+	// Released data (and storage descriptors) are reused by matrices of the same number of elements, so repeated
+	// computations with the same sizes (e.g. training steps) do not allocate after the first run. Default is 0
+	// (disabled, memory is returned to the heap at once), e.g. 64 MB suits training loops.
+	static void setPoolLimit(size_t bytes);
+
+	// Returns number of heap allocations made by matrices (data and storage descriptors) in all threads so far.
+	// Allocation-free code does not change it.
+	static size_t allocations();
+
+	// Computes symmetric product M * trans(M) in parallel. Only lower triangle is computed, upper one is mirrored
+	// when [mirror] is set (left uninitialized otherwise). Use syrk(M.t()) for trans(M) * M.
+	static Matrix syrk(const Matrix& mat, bool mirror = true);
+
+	// Computes lower triangle of M * trans(M) in parallel directly to packed storage [dst] (n * (n + 1) / 2 elements
+	// row by row, see SymmetricMatrix). Results are the same as syrk().
+	static void syrkPacked(const Matrix& mat, float* dst);
+
 	// Multiplies matrix by matrix element by element
 	static Matrix elemProd(const Matrix& ptL, const Matrix& ptR);
 
@@ -114,6 +204,13 @@ public:
 	// Returns true when empty
 	bool empty() const { return (_data == NULL); }
 
+	// Returns true when both matrices view the same elements (neither was changed since one was copied from the other).
+	bool shares(const Matrix& mat) const
+	{
+		return (_storage == mat._storage && _data == mat._data && _rows == mat._rows && _cols == mat._cols
+			&& _rInc == mat._rInc && _cInc == mat._cInc);
+	}
+
 	// Returns size of the matrix in struct
 	Size size() const { return Size(_rows, _cols); }
 
@@ -123,12 +220,26 @@ public:
 	// Returns given row as a matrix
 	Matrix row(int idx) const;
 
+	// Returns view of the block of given size starting at [row], [col]. Data are shared (copied on change).
+	Matrix block(int row, int col, int rows, int cols) const;
+
 	// Returns given column as a matrix
 	Matrix column(int idx) const;
 
+	// Returns matrix wrapping the same elements without copy-on-write: changes in place through either matrix
+	// are visible in both (e.g. parameters shared by threads of asynchronous training). The alias must not
+	// outlive this matrix and this matrix must not be resized or reassigned while the alias is used.
+	Matrix alias();
+
 	// Returns sum of all elements
 	float sum() const;
 
+	// Returns sum of all columns (column vector of row sums).
+	Matrix sumColumns() const;
+
+	// Returns matrix with column vector [vec] added to each column of [mat].
+	static Matrix addToColumns(const Matrix& mat, const Matrix& vec);
+
 	// Element access. UNSAFE, check indices boundaries. 
 	float at(int row, int col) const { return _data[row * _rInc + col * _cInc]; }
 	float& at(int row, int col) { _unique(); return _data[row * _rInc + col * _cInc]; }
@@ -142,6 +253,10 @@ public:
 	// Sets all elements to zero.
 	void clear();
 
+	// Copies content of given matrix to current storage. Dimensions have to match.
+	// Unlike assignment, wrapped external buffer keeps receiving the data (e.g. preallocated output).
+	void assign(const Matrix& src);
+
 	// Sets all elements to uniformly distributed random numbers from given interval.
 	void rand(float min = 0.0f, float max = 1.0f);
 
@@ -197,6 +312,22 @@ public:
 private:
 	// Element access. _unique() has to be called before but only once.
 	float& _at(int row, int col) { return _data[row*_rInc + col*_cInc]; }
+
+	// Returns pointer to contiguous data stored row by row. Copies content to [tmp] if needed.
+	const float* _contiguous(Matrix& tmp) const;
+
+	// Multiplies matrices and calls epilogue(row, index, length) on each finished row of the result
+	template <class Epilogue>
+	Matrix _product(const Matrix& ptR, const Epilogue& epilogue) const;
+
+	// Computes lower triangle of M * trans(M) to [dst], packed (row i at i * (i + 1) / 2) or dense (row i at i * n)
+	static void _syrk(const Matrix& mat, float* dst, bool packed);
+
+	// Width of column panels processed by blocked kernels
+	static const int _panelWidth = 256;
+
+	// Depth of blocks of the inner dimension processed by matrix product
+	static const int _blockDepth = 128;
 };
 
 // Global operators for convenience
@@ -208,7 +339,7 @@ Matrix operator / (float val, const Matrix& mat);
 // Stream read operator
 std::istream& operator >> (std::istream& str, Matrix& mat);
 
-// Stream write operator
+// Stream write operator. Values are written in the shortest form which reads back exactly.
 std::ostream& operator << (std::ostream& str, const Matrix& mat);
 
 // Returns minimum of two matrices (elementwise).
@@ -1,9 +1,12 @@
 #include "Net.h"
+#include "IO/BinaryModel.h"
 #include <fstream>
+#include <algorithm>
+#include <cmath>
 
 // Creates new empty network
 Net::Net()
-	: _layers() {}
+	: _layers(), _checkpointInterval(0) {}
 
 // Destroys network and all its layers
 Net::~Net()
@@ -32,10 +35,31 @@ void Net::processInput(const Matrix& in)
 
 	// Iterate through chain in forward direction
 	for (unsigned i = 0; i < _layers.size(); i++)
+	{
 		_layers[i]->processInput();
+
+		// release input of the layer unless it is a checkpoint
+		if (i > 0 && !_isCheckpoint(i - 1))
+			_layers[i - 1]->output() = Matrix();
+	}
+}
+
+// Runs whole network forward on external input buffer wrapped without copying.
+void Net::processInput(const float* in, float* out)
+{
+	if (_layers.empty()) return; // nothing to do
+
+	processInput(Matrix(in, _layers[0]->size(), 1, 1, 1));
+
+	if (out)
+	{
+		// write to caller's buffer through writable view
+		Matrix res(out, output().rows(), output().columns(), output().columns(), 1);
+		res.assign(output());
+	}
 }
 
-// Processes error (from output to input). Call after each sample in the batch.
+// Processes error (from output to input). Call after each sample or batch of samples (one error column per sample).
 void Net::processError(const Matrix& err)
 {
 	if (_layers.empty()) return; // nothing to do
@@ -43,9 +67,48 @@ void Net::processError(const Matrix& err)
 	// set output error
 	_layers.back()->error() = err;
 
-	// Iterate reversly through chain
-	for (int i = (int)_layers.size() - 1; i >= 0; i--)
-		_layers[i]->processError();
+	if (_checkpointInterval <= 1)
+	{
+		// Iterate reversly through chain
+		for (int i = (int)_layers.size() - 1; i >= 0; i--)
+			_layers[i]->processError();
+		return;
+	}
+
+	// Iterate reversly through segments between checkpoints
+	for (int end = (int)_layers.size() - 1; end > 0; )
+	{
+		const int begin = ((end - 1) / _checkpointInterval) * _checkpointInterval;
+
+		// recompute outputs inside the segment from the checkpoint
+		for (int i = begin + 1; i < end; i++)
+			if (!_isCheckpoint(i))
+				_layers[i]->processInput();
+
+		for (int i = end; i > begin; i--)
+		{
+			_layers[i]->processError();
+			if (!_isCheckpoint(i))
+				_layers[i]->output() = Matrix();
+			if (i < (int)_layers.size() - 1)
+				_layers[i]->error() = Matrix();
+		}
+
+		end = begin;
+	}
+	_layers[0]->processError();
+}
+
+// Processes error of the cross-entropy loss for given class of each sample backward. Returns mean loss.
+float Net::processError(const std::vector<int>& labels)
+{
+	SoftmaxLayer* softmax = _layers.empty() ? NULL : dynamic_cast<SoftmaxLayer*>(_layers.back());
+	if (!softmax)
+		throw std::invalid_argument("Net: Last layer is not SoftmaxLayer.");
+
+	const float loss = softmax->crossEntropy(labels);
+	processError(softmax->error());
+	return loss;
 }
 
 // Updates parameters of all layers (from output to input). Call after each batch.
@@ -58,9 +121,127 @@ void Net::updateParameters()
 		_layers[i]->updateParameters();
 }
 
-// Loads network parameters from given file. Structure has to be set first.
+// Sets activation checkpointing (0 or 1 keeps all outputs).
+void Net::setCheckpointInterval(int interval)
+{
+	if (interval < 0)
+		throw std::invalid_argument("Net: Invalid checkpoint interval.");
+
+	_checkpointInterval = interval;
+}
+
+// Returns true when output of given layer is kept between forward and backward pass
+bool Net::_isCheckpoint(int layer) const
+{
+	// recurrent layers cannot be recomputed (state advances with each forward pass)
+	return _checkpointInterval <= 1 || layer % _checkpointInterval == 0 || layer == (int)_layers.size() - 1
+		|| dynamic_cast<RecurrentLayer*>(_layers[layer]);
+}
+
+// Replaces chains WeightLayer -> BiasLayer [-> activation] by fused DenseLayer.
+int Net::fuse()
+{
+	int fused = 0;
+	for (unsigned i = 0; i + 1 < _layers.size(); i++)
+	{
+		WeightLayer* weightLayer = dynamic_cast<WeightLayer*>(_layers[i]);
+		BiasLayer* biasLayer = dynamic_cast<BiasLayer*>(_layers[i + 1]);
+		if (!weightLayer || !biasLayer || !weightLayer->prevLayer())
+			continue;
+
+		// optional activation
+		NetLayer* next = (i + 2 < _layers.size()) ? _layers[i + 2] : NULL;
+		Matrix::Activation activation = Matrix::Identity;
+		if (dynamic_cast<TanhLayer*>(next))
+			activation = Matrix::Tanh;
+		else if (dynamic_cast<RectifierLayer*>(next))
+			activation = Matrix::Rectifier;
+		else if (dynamic_cast<SoftplusLayer*>(next))
+			activation = Matrix::Softplus;
+		const int count = (activation == Matrix::Identity) ? 2 : 3;
+
+		// fused layer takes parameters and copies of learning rules (with their states)
+		LearningRule* weightRule = weightLayer->learningRule();
+		LearningRule* biasRule = biasLayer->learningRule();
+		DenseLayer* dense = new DenseLayer(biasLayer->size(), activation,
+			weightRule ? weightRule->clone() : NULL, biasRule ? biasRule->clone() : NULL);
+
+		NetLayer* prev = weightLayer->prevLayer();
+		Matrix weights = weightLayer->weights();
+		Matrix bias = biasLayer->bias();
+
+		// destroyed layers disconnect themselves from the chain
+		for (int j = 0; j < count; j++)
+			delete _layers[i + j];
+		_layers.erase(_layers.begin() + i + 1, _layers.begin() + i + count);
+		_layers[i] = dense;
+
+		dense->insertAfter(prev);
+		*dense->parameters()[0] = weights;
+		*dense->parameters()[1] = bias;
+		fused++;
+	}
+
+	return fused;
+}
+
+// Converts network for 8-bit inference, input ranges are calibrated on given samples.
+int Net::quantize(const Matrix& samples)
+{
+	fuse();
+
+	// calibration pass keeps all outputs
+	const int interval = _checkpointInterval;
+	_checkpointInterval = 0;
+	processInput(samples);
+	_checkpointInterval = interval;
+
+	std::vector<QuantizedLayer*> quantized(_layers.size(), (QuantizedLayer*)NULL);
+	for (unsigned i = 1; i < _layers.size(); i++)
+	{
+		DenseLayer* dense = dynamic_cast<DenseLayer*>(_layers[i]);
+		WeightLayer* weightLayer = dynamic_cast<WeightLayer*>(_layers[i]);
+		if (!dense && !weightLayer)
+			continue;
+
+		// largest absolute input over the samples
+		const Matrix& in = _layers[i]->input();
+		float range = 0.0f;
+		for (int r = 0; r < in.rows(); r++)
+			for (int c = 0; c < in.columns(); c++)
+				range = std::max(range, std::fabs(in.at(r, c)));
+
+		quantized[i] = dense
+			? new QuantizedLayer(dense->weights(), dense->bias(), dense->activation(), range)
+			: new QuantizedLayer(weightLayer->weights(), Matrix(), Matrix::Identity, range);
+	}
+
+	int count = 0;
+	for (unsigned i = 1; i < _layers.size(); i++)
+	{
+		if (!quantized[i])
+			continue;
+
+		// destroyed layer disconnects itself from the chain
+		NetLayer* prev = _layers[i]->prevLayer();
+		delete _layers[i];
+		_layers[i] = quantized[i];
+		quantized[i]->insertAfter(prev);
+		count++;
+	}
+
+	return count;
+}
+
+// Loads network parameters from given file (text or binary format is detected). Structure has to be set first.
 void Net::loadFromFile(const char* filename)
 {
+	if (BinaryModel::isBinary(filename))
+	{
+		BinaryModel::load(_layers, filename);
+		return;
+	}
+
 	std::ifstream file(filename);
 
 	if (!file.is_open()) return;
@@ -72,8 +253,14 @@ void Net::loadFromFile(const char* filename)
 }
 
 // Saves network to given file.
-void Net::saveToFile(const char* filename) const
+void Net::saveToFile(const char* filename, bool binary) const
 {
+	if (binary)
+	{
+		BinaryModel::save(_layers, filename);
+		return;
+	}
+
 	std::ofstream file(filename);
 
 	for (unsigned i = 0; i < _layers.size(); i++)
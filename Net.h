@@ -8,11 +8,22 @@
 #include "Layers/RectifierLayer.h"
 #include "Layers/SoftplusLayer.h"
 #include "Layers/BiasLayer.h"
+#include "Layers/DenseLayer.h"
+#include "Layers/SoftmaxLayer.h"
+#include "Layers/ConvolutionLayer.h"
+#include "Layers/PoolingLayer.h"
+#include "Layers/LSTMLayer.h"
+#include "Layers/GRULayer.h"
+#include "Layers/QuantizedLayer.h"
 
 class Net
 {
 protected:
 	std::vector<NetLayer*> _layers;
+	int _checkpointInterval;
+
+	// Returns true when output of given layer is kept between forward and backward pass
+	bool _isCheckpoint(int layer) const;
 
 public:
 	// Creates new empty network
@@ -33,20 +44,54 @@ public:
 	// Returns output of the last layer. Call only if network has layers.
 	const Matrix& output() const { return _layers.back()->output(); }
 
-	// Runs whole network forward (from given input to output).
+	// Runs whole network forward (from given input to output). Input may contain batch of samples stored in columns,
+	// output then has one column per sample. Input is shared, not copied, so it may wrap external buffer
+	// (see Matrix constructors with external data).
 	void processInput(const Matrix& in);
 
-	// Processes error (from output to input). Call after each sample in the batch.
+	// Runs whole network forward on external input buffer wrapped without copying.
+	// Output is written to external buffer [out] when given. Input buffer has to stay valid until the next call
+	// (or until processError() when training).
+	void processInput(const float* in, float* out = NULL);
+
+	// Processes error (from output to input). Call after each sample or batch of samples (one error column per sample).
 	void processError(const Matrix& err);
 
+	// Processes error of the cross-entropy loss for given class of each sample (column) backward. Last layer has to
+	// be SoftmaxLayer (see SoftmaxLayer::crossEntropy()). Returns mean loss of the batch.
+	float processError(const std::vector<int>& labels);
+
 	// Updates parameters of all layers (from output to input). Call after each batch.
 	void updateParameters();
 
-	// Loads network parameters from given file. Structure has to be set first.
+	// Sets activation checkpointing: only outputs of the input, every [interval]-th layer and the output are kept
+	// after processInput(), the others are released and recomputed segment by segment in processError().
+	// Trades one extra forward pass for memory (interval about sqrt(layers) minimizes the peak). Outputs and errors
+	// of intermediate layers are released again after processError(). Gradients do not change. Outputs of recurrent
+	// layers are always kept.
+	// 0 or 1 keeps all outputs (default).
+	void setCheckpointInterval(int interval);
+
+	// Returns interval of activation checkpointing (0 when disabled)
+	int checkpointInterval() const { return _checkpointInterval; }
+
+	// Replaces chains WeightLayer -> BiasLayer [-> TanhLayer, RectifierLayer or SoftplusLayer] by fused DenseLayer.
+	// Parameters and states of learning rules are kept, accumulated gradients are dropped (call between batches).
+	// Note: changes number of layers (files saved by BinaryModel or Checkpoint before fusion do not match).
+	// Returns number of fused chains.
+	int fuse();
+
+	// Converts network for 8-bit inference: fuses layers (see fuse()) and replaces each DenseLayer and remaining
+	// WeightLayer by QuantizedLayer. Input ranges are calibrated on [samples] (representative inputs in columns).
+	// The network cannot be trained or saved afterwards. Returns number of quantized layers.
+	int quantize(const Matrix& samples);
+
+	// Loads network parameters from given file (text or binary format is detected). Structure has to be set first.
+	// Binary file is memory mapped and parameters share its pages until they are changed.
 	void loadFromFile(const char* filename);
 
-	// Saves network parameters to given file.
-	void saveToFile(const char* filename) const;
+	// Saves network parameters to given file. Binary format is exact and loads fast, see BinaryModel.
+	void saveToFile(const char* filename, bool binary = false) const;
 };
 
 #endif 
@@ -0,0 +1,260 @@
+#include "Test.h"
+#include "../Algebra/SymmetricMatrix.h"
+#include "../Algebra/PCA.h"
+#include "../Algebra/RecursiveLeastSquares.h"
+#include "../Algebra/SymmetricEigen.h"
+#include "../Algebra/Preconditioner.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+// Packed product matches lower triangle of the dense symmetric product exactly
+static void testSymmetricProduct()
+{
+	const int sizes[] = { 1, 7, 70, 300 };
+	for (int size : sizes)
+	{
+		Matrix m(size, 37);
+		m.rand(-1.0f, 1.0f);
+
+		const SymmetricMatrix s = SymmetricMatrix::product(m);
+		const Matrix dense = Matrix::syrk(m);
+		CHECK(s.size() == size);
+
+		bool same = true;
+		for (int r = 0; r < size; r++)
+			for (int c = 0; c <= r; c++)
+				same = same && (s.at(r, c) == dense.at(r, c));
+		CHECK(same);
+	}
+
+	CHECK(SymmetricMatrix::product(Matrix(3, 0)).toMatrix().sum() == 0.0f);
+}
+
+// Variances of principal components of samples along two axes
+static void testPCA()
+{
+	Matrix data(3, 4);
+	const float x[4] = { -2.0f, 2.0f, 0.0f, 0.0f };
+	const float y[4] = { 0.0f, 0.0f, -1.0f, 1.0f };
+	for (int c = 0; c < 4; c++)
+	{
+		data.at(0, c) = x[c] + 1.0f;
+		data.at(1, c) = y[c];
+		data.at(2, c) = 5.0f;
+	}
+
+	PCA pca;
+	pca.fit(data, 2);
+	CHECK(std::fabs(pca.variances().at(0, 0) - 8.0f / 3.0f) < 1e-5f);
+	CHECK(std::fabs(pca.variances().at(1, 0) - 2.0f / 3.0f) < 1e-5f);
+}
+
+// Returns largest absolute value of the elements
+static float maxAbs(const Matrix& mat)
+{
+	float res = 0.0f;
+	for (int r = 0; r < mat.rows(); r++)
+		for (int c = 0; c < mat.columns(); c++)
+			res = std::max(res, std::fabs(mat.at(r, c)));
+	return res;
+}
+
+// Checks top [count] eigenpairs of symmetric [mat] against its sorted eigenvalues [expected]: residuals, orthonormality
+static void checkEigen(const Matrix& mat, int count, const std::vector<float>& expected)
+{
+	const SymmetricEigen eig(mat, count);
+	const Matrix& values = eig.values();
+	const Matrix& vectors = eig.vectors();
+	CHECK(values.rows() == count && vectors.columns() == count && vectors.rows() == mat.rows());
+	if (vectors.columns() != count)
+		return;
+
+	const float scale = std::max(1.0f, maxAbs(mat));
+	for (int j = 0; j < count; j++)
+	{
+		CHECK(std::fabs(values.at(j, 0) - expected[j]) < 1e-5f * scale);
+
+		const Matrix v = vectors.block(0, j, mat.rows(), 1);
+		CHECK(maxAbs(mat * v - v * values.at(j, 0)) < 1e-5f * scale);
+
+		for (int i = 0; i <= j; i++)
+		{
+			const float dot = (vectors.block(0, i, mat.rows(), 1).t() * v).at(0, 0);
+			CHECK(std::fabs(dot - ((i == j) ? 1.0f : 0.0f)) < 1e-5f);
+		}
+	}
+}
+
+// Returns Q * diag(values) * trans(Q) for random orthogonal Q (Gram-Schmidt of random columns)
+static Matrix rotated(const std::vector<float>& values)
+{
+	const int n = (int)values.size();
+	Matrix q(n, n);
+	q.rand(-1.0f, 1.0f);
+	for (int j = 0; j < n; j++)
+	{
+		Matrix v = q.block(0, j, n, 1);
+		for (int i = 0; i < j; i++)
+		{
+			const Matrix u = q.block(0, i, n, 1);
+			v -= u * (u.t() * v).at(0, 0);
+		}
+		v /= std::sqrt((v.t() * v).at(0, 0));
+		for (int r = 0; r < n; r++)
+			q.at(r, j) = v.at(r, 0);
+	}
+
+	Matrix d(n, n);
+	d.clear();
+	for (int i = 0; i < n; i++)
+		d.at(i, i) = values[i];
+
+	return q * d * q.t();
+}
+
+// Identity, repeated eigenvalues (diagonal and rotated) and block-diagonal matrices, top-k and all eigenpairs
+static void testSymmetricEigen()
+{
+	for (int count = 1; count <= 5; count++)
+		checkEigen(Matrix::eye(5), count, std::vector<float>(5, 1.0f));
+
+	const std::vector<float> repeated = { 2.0f, 2.0f, 2.0f, 1.0f, 1.0f, 1.0f };
+	Matrix diagonal(6, 6);
+	diagonal.clear();
+	for (int i = 0; i < 6; i++)
+		diagonal.at(i, i) = repeated[i];
+
+	const Matrix dense = rotated(repeated);
+	for (int count = 1; count <= 6; count++)
+	{
+		checkEigen(diagonal, count, repeated);
+		checkEigen(dense, count, repeated);
+	}
+
+	// two dense blocks with interleaved eigenvalues (tridiagonal matrix splits between them)
+	const Matrix upper = rotated({ 5.0f, 3.0f, 1.0f });
+	const Matrix lower = rotated({ 4.0f, 3.0f, 2.0f, 0.5f });
+	Matrix blocks(7, 7);
+	blocks.clear();
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++)
+			blocks.at(r, c) = upper.at(r, c);
+	for (int r = 0; r < 4; r++)
+		for (int c = 0; c < 4; c++)
+			blocks.at(3 + r, 3 + c) = lower.at(r, c);
+
+	const std::vector<float> all = { 5.0f, 4.0f, 3.0f, 3.0f, 2.0f, 1.0f, 0.5f };
+	for (int count = 1; count <= 7; count++)
+		checkEigen(blocks, count, all);
+}
+
+// Block update with forgetting matches the same observations passed one by one
+static void testRecursiveLeastSquaresBlock()
+{
+	RecursiveLeastSquares sequential(3, 2, 1.0f), block(3, 2, 1.0f);
+	sequential.forgetting = 0.9f;
+	block.forgetting = 0.9f;
+
+	Matrix X(3, 12), Y(2, 12);
+	X.rand(-1.0f, 1.0f);
+	Y.rand(-1.0f, 1.0f);
+
+	for (int b = 0; b < 12; b += 4)
+	{
+		for (int j = b; j < b + 4; j++)
+			sequential.update(X.block(0, j, 3, 1), Y.block(0, j, 2, 1));
+		block.updateBlock(X.block(0, b, 3, 4), Y.block(0, b, 2, 4));
+	}
+
+	CHECK(block.samples() == sequential.samples());
+	CHECK(maxAbs(block.weights() - sequential.weights()) < 1e-4f);
+	CHECK(maxAbs(block.covariance() - sequential.covariance()) < 1e-4f * maxAbs(sequential.covariance()));
+}
+
+// Factorization from compressed sparse rows matches the dense one (unsorted rows, duplicates, lower triangle only)
+static void testIncompleteCholeskySparse()
+{
+	// 2D Laplacian on 4 x 4 grid with shifted diagonal
+	const int n = 16;
+	Matrix dense(n, n);
+	dense.clear();
+	for (int i = 0; i < n; i++)
+	{
+		dense.at(i, i) = 4.1f;
+		if (i % 4 > 0)
+			dense.at(i, i - 1) = dense.at(i - 1, i) = -1.0f;
+		if (i >= 4)
+			dense.at(i, i - 4) = dense.at(i - 4, i) = -1.0f;
+	}
+
+	// full matrix with columns in decreasing order and diagonal split to two entries, and lower triangle only
+	std::vector<int> fullStart(1, 0), fullColumns, lowerStart(1, 0), lowerColumns;
+	std::vector<float> fullValues, lowerValues;
+	for (int r = 0; r < n; r++)
+	{
+		for (int c = n - 1; c >= 0; c--)
+		{
+			const float x = dense.at(r, c);
+			if (x == 0.0f)
+				continue;
+
+			if (c == r)
+			{
+				fullColumns.push_back(c);
+				fullValues.push_back(1.0f);
+				fullColumns.push_back(c);
+				fullValues.push_back(x - 1.0f);
+			}
+			else
+			{
+				fullColumns.push_back(c);
+				fullValues.push_back(x);
+			}
+
+			if (c <= r)
+			{
+				lowerColumns.push_back(c);
+				lowerValues.push_back(x);
+			}
+		}
+		fullStart.push_back((int)fullColumns.size());
+		lowerStart.push_back((int)lowerColumns.size());
+	}
+
+	const IncompleteCholesky reference(dense);
+	const IncompleteCholesky full(n, fullStart, fullColumns, fullValues);
+	const IncompleteCholesky lower(n, lowerStart, lowerColumns, lowerValues);
+
+	Matrix r(n, 1);
+	r.rand(-1.0f, 1.0f);
+	const Matrix z = reference.apply(r);
+	CHECK(maxAbs(full.apply(r) - z) < 1e-6f);
+	CHECK(maxAbs(lower.apply(r) - z) < 1e-6f);
+
+	// preconditioner approximates inverse of the matrix
+	CHECK(maxAbs(dense * z - r) < 0.5f * maxAbs(r));
+
+	bool thrown = false;
+	try
+	{
+		lowerColumns[3] = n;
+		IncompleteCholesky invalid(n, lowerStart, lowerColumns, lowerValues);
+	}
+	catch (const std::invalid_argument&)
+	{
+		thrown = true;
+	}
+	CHECK(thrown);
+}
+
+int main()
+{
+	RUN(testSymmetricProduct);
+	RUN(testPCA);
+	RUN(testRecursiveLeastSquaresBlock);
+	RUN(testSymmetricEigen);
+	RUN(testIncompleteCholeskySparse);
+	return TEST_RESULT();
+}
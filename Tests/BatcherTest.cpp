@@ -0,0 +1,101 @@
+#include "Test.h"
+#include "../Batcher.h"
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// Requests submitted by several threads at once are coalesced into batches, each future receives the output
+// of its own sample
+static void testConcurrentSubmit()
+{
+	const int threads = 8;
+	const int requests = 25;
+
+	Net net;
+	std::srand(7);
+	net.addLayer(new InputLayer(4));
+	net.addLayer(new DenseLayer(6, Matrix::Tanh, NULL, NULL));
+	net.addLayer(new DenseLayer(3, Matrix::Identity, NULL, NULL));
+
+	// distinct sample of each request, outputs computed one by one before the batcher owns the network
+	Matrix samples(4, threads * requests);
+	samples.rand(-1.0f, 1.0f);
+	Matrix expected(3, samples.columns());
+	for (int c = 0; c < samples.columns(); c++)
+	{
+		net.processInput(samples.block(0, c, 4, 1));
+		for (int r = 0; r < 3; r++)
+			expected.at(r, c) = net.output().at(r, 0);
+	}
+
+	std::vector<int> mismatches(threads, 0);
+	{
+		Batcher batcher(net, 16, 500);
+		std::vector<std::thread> clients;
+		for (int t = 0; t < threads; t++)
+		{
+			clients.push_back(std::thread([&, t]()
+			{
+				// several requests in flight from each thread
+				std::vector<std::future<std::vector<float>>> results;
+				for (int i = 0; i < requests; i++)
+				{
+					const int c = t * requests + i;
+					std::vector<float> input(4);
+					for (int r = 0; r < 4; r++)
+						input[r] = samples.at(r, c);
+					results.push_back(batcher.submit(input));
+				}
+
+				for (int i = 0; i < requests; i++)
+				{
+					const std::vector<float> output = results[i].get();
+					const int c = t * requests + i;
+					if (output.size() != 3)
+					{
+						mismatches[t]++;
+						continue;
+					}
+					for (int r = 0; r < 3; r++)
+						if (std::fabs(output[r] - expected.at(r, c)) > 1e-5f)
+							mismatches[t]++;
+				}
+			}));
+		}
+
+		for (int t = 0; t < threads; t++)
+			clients[t].join();
+	}
+
+	for (int t = 0; t < threads; t++)
+		CHECK(mismatches[t] == 0);
+}
+
+// Input of a wrong size is rejected by submit()
+static void testInvalidInput()
+{
+	Net net;
+	net.addLayer(new InputLayer(4));
+	net.addLayer(new DenseLayer(2, Matrix::Identity, NULL, NULL));
+	Batcher batcher(net, 4, 100);
+
+	bool thrown = false;
+	try
+	{
+		batcher.submit(std::vector<float>(3, 0.0f));
+	}
+	catch (const std::invalid_argument&)
+	{
+		thrown = true;
+	}
+	CHECK(thrown);
+	CHECK(batcher.process(std::vector<float>(4, 0.5f)).size() == 2);
+}
+
+int main()
+{
+	RUN(testConcurrentSubmit);
+	RUN(testInvalidInput);
+	return TEST_RESULT();
+}
@@ -0,0 +1,99 @@
+#include "Test.h"
+#include "../Net.h"
+#include "../IO/Checkpoint.h"
+#include "../Learning/Adam.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+
+// Creates network of layers with learning rules of weights and bias in one layer with parameters given by [seed]
+static void createNet(Net& net, unsigned seed)
+{
+	std::srand(seed);
+	net.addLayer(new InputLayer(5));
+	net.addLayer(new ConvolutionLayer(Window::line(1, 5, 3, 1, 1), 2, new Adam(), new Adam()));
+	net.addLayer(new GRULayer(6, new Adam(), new Adam()));
+	net.addLayer(new DenseLayer(8, Matrix::Tanh, new Adam(), new Adam()));
+	net.addLayer(new DenseLayer(3, Matrix::Identity, new Adam(), new Adam()));
+}
+
+// Runs [steps] training steps on fixed batch (sequence of 4 steps)
+static void train(Net& net, int steps)
+{
+	Matrix in(5, 4), target(3, 4);
+	for (int r = 0; r < 5; r++)
+		for (int c = 0; c < 4; c++)
+			in.at(r, c) = 0.1f * (r - c);
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 4; c++)
+			target.at(r, c) = 0.2f * (r + c) - 0.5f;
+
+	for (int i = 0; i < steps; i++)
+	{
+		// hidden state is not part of the checkpoint, each batch starts new sequence
+		for (unsigned l = 0; l < net.layers().size(); l++)
+			if (RecurrentLayer* recurrent = dynamic_cast<RecurrentLayer*>(net.layers()[l]))
+				recurrent->reset();
+
+		net.processInput(in);
+		net.processError(net.output() - target);
+		net.updateParameters();
+	}
+}
+
+// Returns true when all parameters of the networks are equal
+static bool equal(const Net& a, const Net& b)
+{
+	for (unsigned l = 0; l < a.layers().size(); l++)
+	{
+		std::vector<Matrix*> pa = a.layers()[l]->parameters();
+		std::vector<Matrix*> pb = b.layers()[l]->parameters();
+		for (unsigned p = 0; p < pa.size(); p++)
+			if (abs(*pa[p] - *pb[p]).sum() != 0.0f)
+				return false;
+	}
+	return true;
+}
+
+// Resumed training continues exactly: state of all learning rules (bias ones too) is restored
+static void testResumeAllRules()
+{
+	const std::string filename = (std::filesystem::temp_directory_path() / "checkpoint_test.ck").string();
+
+	Net original;
+	createNet(original, 3);
+	train(original, 5);
+	{
+		Checkpoint checkpoint(filename.c_str());
+		checkpoint.save(original.layers());
+		train(original, 2);
+		checkpoint.save(original.layers(), true);
+		CHECK(checkpoint.wait());
+	}
+	train(original, 5);
+
+	Net resumed;
+	createNet(resumed, 11);
+	train(resumed, 1); // states of the rules are replaced
+	CHECK(Checkpoint::load(resumed.layers(), filename.c_str()));
+	train(resumed, 5);
+
+	CHECK(equal(original, resumed));
+	for (unsigned l = 0; l < original.layers().size(); l++)
+	{
+		std::vector<LearningRule*> a = original.layers()[l]->learningRules();
+		std::vector<LearningRule*> b = resumed.layers()[l]->learningRules();
+		CHECK(a.size() == b.size());
+		for (unsigned k = 0; k < a.size() && k < b.size(); k++)
+			CHECK(a[k]->state().size() == b[k]->state().size());
+	}
+
+	std::remove(filename.c_str());
+	std::remove((filename + ".1").c_str());
+}
+
+int main()
+{
+	RUN(testResumeAllRules);
+	return TEST_RESULT();
+}
@@ -0,0 +1,71 @@
+#include "Test.h"
+#include "../Net.h"
+#include "../IO/CodeExporter.h"
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+// Exports [net], compiles generated source with its test program by the C compiler and runs it. Returns false
+// when the program fails (results differ or it crashes).
+static bool compileAndRun(Net& net, const char* name)
+{
+	const std::filesystem::path dir = std::filesystem::temp_directory_path();
+	const std::string source = (dir / (std::string(name) + ".h")).string();
+	const std::string test = (dir / (std::string(name) + "_test.c")).string();
+	const std::string program = (dir / (std::string(name) + "_test")).string();
+
+	Matrix in(net.layers().front()->size(), 8);
+	in.rand(-1.0f, 1.0f);
+	net.processInput(in);
+	const Matrix out = net.output();
+
+	CodeExporter exporter(name);
+	if (!exporter.save(source.c_str(), net.layers()) || !exporter.saveTest(test.c_str(), source.c_str(), in, out))
+		return false;
+
+	const std::string build = "cc -std=c99 -O1 -ffp-contract=off -fstack-protector-all -o " + program + " " + test + " -lm";
+	if (std::system(build.c_str()) != 0)
+		return false;
+
+	const bool ok = (std::system(program.c_str()) == 0);
+	std::filesystem::remove(source);
+	std::filesystem::remove(test);
+	std::filesystem::remove(program);
+	return ok;
+}
+
+// Element-wise steps before the first weights need buffers of the input size
+static void testWideInput()
+{
+	Net net;
+	net.addLayer(new InputLayer(100));
+	net.addLayer(new TanhLayer(100));
+	net.addLayer(new WeightLayer(4, NULL));
+	CHECK(compileAndRun(net, "wide_input"));
+}
+
+// Buffers hold the largest hidden layer, also after element-wise steps
+static void testHiddenLayers()
+{
+	Net net;
+	net.addLayer(new InputLayer(3));
+	net.addLayer(new WeightLayer(40, NULL));
+	net.addLayer(new BiasLayer(40, NULL));
+	net.addLayer(new RectifierLayer(40));
+	net.addLayer(new DenseLayer(7, Matrix::Tanh, NULL, NULL));
+	net.addLayer(new WeightLayer(2, NULL));
+	CHECK(compileAndRun(net, "hidden_layers"));
+}
+
+int main()
+{
+	if (std::system("cc --version > /dev/null 2>&1") != 0)
+	{
+		std::fprintf(stderr, "C compiler (cc) not found, test skipped.\n");
+		return 0;
+	}
+
+	RUN(testWideInput);
+	RUN(testHiddenLayers);
+	return TEST_RESULT();
+}
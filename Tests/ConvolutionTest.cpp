@@ -0,0 +1,112 @@
+#include "Test.h"
+#include "GradientCheck.h"
+#include <cstdlib>
+
+// Checks error of the input and gradients of [parameters] (captured by [rules] as batch averages) against
+// central differences of the squared error loss with step [eps]
+static void checkGradients(Net& net, Matrix in, const Matrix& target, const std::vector<Matrix*>& parameters,
+	const std::vector<GradientCapture*>& rules, float eps, double tolerance)
+{
+	net.processInput(in);
+	net.processError(net.output() - target);
+	const Matrix inputError = net.layers()[0]->error();
+	net.updateParameters();
+
+	auto loss = [&]() { net.processInput(in); return squaredError(net.output(), target); };
+	CHECK(gradientMismatches(in, inputError, 1.0f, loss, eps, tolerance) == 0);
+	for (unsigned k = 0; k < parameters.size(); k++)
+		CHECK(gradientMismatches(*parameters[k], rules[k]->gradient, (float)in.columns(), loss, eps, tolerance) == 0);
+}
+
+// Checks gradients of convolution with given geometry (input, weights and bias)
+static void checkConvolution(const Window& window, int filters, int count)
+{
+	std::srand(7);
+	GradientCapture* weightRule = new GradientCapture();
+	GradientCapture* biasRule = new GradientCapture();
+	ConvolutionLayer* convolution = new ConvolutionLayer(window, filters, weightRule, biasRule);
+
+	Net net;
+	net.addLayer(new InputLayer(window.inputSize()));
+	net.addLayer(convolution);
+
+	// bias is zero after initialization, set it to test its effect on the output
+	std::vector<Matrix*> parameters = convolution->parameters();
+	parameters[1]->rand(-0.5f, 0.5f);
+
+	Matrix in(window.inputSize(), count), target(convolution->size(), count);
+	in.rand(-1.0f, 1.0f);
+	target.rand(-1.0f, 1.0f);
+	checkGradients(net, in, target, parameters, { weightRule, biasRule }, 1e-2f, 2e-3);
+}
+
+// Gradients of convolution match finite differences for stride, padding and dilation (1D and 2D)
+static void testConvolutionGradients()
+{
+	checkConvolution(Window::line(1, 9, 3), 2, 3);
+	checkConvolution(Window::line(2, 11, 3, 2, 1, 2), 3, 2);
+	checkConvolution(Window(2, 5, 6, 3, 2), 2, 2);
+	checkConvolution(Window(2, 6, 5, 3, 3, 2, 1), 3, 3);
+	checkConvolution(Window(1, 7, 7, 2, 3, 1, 2, 2), 2, 2);
+}
+
+// Checks error of the input of pooling with given geometry
+static void checkPooling(const Window& window, PoolingLayer::Mode mode, int count)
+{
+	std::srand(5);
+	PoolingLayer* pooling = new PoolingLayer(window, mode);
+
+	Net net;
+	net.addLayer(new InputLayer(window.inputSize()));
+	net.addLayer(pooling);
+
+	// inputs far apart, so the maximum of a window does not change with the step
+	Matrix in(window.inputSize(), count), target(pooling->size(), count);
+	for (int c = 0; c < count; c++)
+		for (int r = 0; r < in.rows(); r++)
+			in.at(r, c) = 0.1f * ((r * 7 + c * 5) % 23) - 1.1f;
+	target.rand(-1.0f, 1.0f);
+	checkGradients(net, in, target, {}, {}, 1e-2f, 2e-3);
+}
+
+// Error of max and average pooling matches finite differences (overlapping windows, stride and padding)
+static void testPoolingGradients()
+{
+	const PoolingLayer::Mode modes[] = { PoolingLayer::Max, PoolingLayer::Average };
+	for (PoolingLayer::Mode mode : modes)
+	{
+		checkPooling(Window::line(2, 10, 2, 2), mode, 3);
+		checkPooling(Window::line(1, 11, 3, 2, 1, 2), mode, 2);
+		checkPooling(Window(2, 6, 6, 2, 2, 2), mode, 2);
+		checkPooling(Window(1, 7, 6, 3, 3, 2, 1), mode, 3);
+	}
+}
+
+// Gradients of convolution followed by pooling match finite differences
+static void testConvolutionPooling()
+{
+	std::srand(11);
+	const Window window(1, 6, 6, 3, 3, 1, 1);
+	GradientCapture* weightRule = new GradientCapture();
+	GradientCapture* biasRule = new GradientCapture();
+	ConvolutionLayer* convolution = new ConvolutionLayer(window, 2, weightRule, biasRule);
+
+	Net net;
+	net.addLayer(new InputLayer(window.inputSize()));
+	net.addLayer(convolution);
+	net.addLayer(new PoolingLayer(Window(2, 6, 6, 2, 2, 2), PoolingLayer::Average));
+	net.addLayer(new DenseLayer(3, Matrix::Tanh, NULL, NULL));
+
+	Matrix in(window.inputSize(), 3), target(3, 3);
+	in.rand(-1.0f, 1.0f);
+	target.rand(-1.0f, 1.0f);
+	checkGradients(net, in, target, convolution->parameters(), { weightRule, biasRule }, 1e-2f, 2e-3);
+}
+
+int main()
+{
+	RUN(testConvolutionGradients);
+	RUN(testPoolingGradients);
+	RUN(testConvolutionPooling);
+	return TEST_RESULT();
+}
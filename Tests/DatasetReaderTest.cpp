@@ -0,0 +1,66 @@
+#include "Test.h"
+#include "../IO/DatasetReader.h"
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+// Writes given text to a temporary file, returns its name
+static std::string writeText(const char* name, const char* text)
+{
+	const std::string filename = (std::filesystem::temp_directory_path() / name).string();
+	FILE* file = fopen(filename.c_str(), "wb");
+	fputs(text, file);
+	fclose(file);
+	return filename;
+}
+
+// CSV numbers are parsed independently of the locale (signs, exponents, separators, header)
+static void testCSV()
+{
+	const std::string filename = writeText("DatasetReaderTest.csv",
+		"x,y,target\n0.5,-1.25,+3\n1e-3;2.5E2;-0\n\n 7, 8\t,1e60\n");
+
+	DatasetReader reader(filename.c_str(), DatasetReader::CSV, 2, 1, 8);
+	DatasetReader::Batch batch;
+	CHECK(reader.next(batch));
+	CHECK(batch.size() == 3);
+	if (batch.size() == 3)
+	{
+		CHECK(batch.inputs.at(0, 0) == 0.5f && batch.inputs.at(1, 0) == -1.25f && batch.targets.at(0, 0) == 3.0f);
+		CHECK(batch.inputs.at(0, 1) == 1e-3f && batch.inputs.at(1, 1) == 250.0f && batch.targets.at(0, 1) == 0.0f);
+		CHECK(batch.inputs.at(0, 2) == 7.0f && batch.inputs.at(1, 2) == 8.0f && std::isinf(batch.targets.at(0, 2)));
+	}
+	CHECK(!reader.next(batch));
+
+	std::remove(filename.c_str());
+}
+
+// Invalid number is reported by next()
+static void testInvalidCSV()
+{
+	const std::string filename = writeText("DatasetReaderTest.csv", "1,2,3\n4,x,6\n");
+
+	bool thrown = false;
+	try
+	{
+		DatasetReader reader(filename.c_str(), DatasetReader::CSV, 2, 1, 8);
+		DatasetReader::Batch batch;
+		while (reader.next(batch));
+	}
+	catch (const std::runtime_error&)
+	{
+		thrown = true;
+	}
+	CHECK(thrown);
+
+	std::remove(filename.c_str());
+}
+
+int main()
+{
+	RUN(testCSV);
+	RUN(testInvalidCSV);
+	return TEST_RESULT();
+}
@@ -0,0 +1,61 @@
+#ifndef _GRADIENT_CHECK_H_
+#define _GRADIENT_CHECK_H_
+
+#include "../Net.h"
+#include <cmath>
+
+// Finite difference checks of backward passes (gradient tests of the layers).
+
+// Learning rule keeping the last (average) gradient without changing the parameters
+class GradientCapture : public LearningRule
+{
+public:
+	Matrix gradient;
+
+	// Keeps [grads], parameters are not changed
+	virtual void update(Matrix& params, const Matrix& grads) { gradient = grads; }
+
+	// Returns new capturing rule (recurrent layers clone the weight rule)
+	virtual LearningRule* clone() const { return new GradientCapture(); }
+};
+
+// Returns squared error loss 0.5 * sum((output - target)^2) of the whole batch (error of the output is output - target)
+static double squaredError(const Matrix& out, const Matrix& target)
+{
+	double res = 0.0;
+	for (int r = 0; r < out.rows(); r++)
+		for (int c = 0; c < out.columns(); c++)
+		{
+			const double d = (double)out.at(r, c) - target.at(r, c);
+			res += 0.5 * d * d;
+		}
+	return res;
+}
+
+// Returns number of entries of [values] where [scale] * [gradient] does not match central difference of [loss]
+// (called without arguments after each change) with step [eps]. Values are restored.
+template <class Loss>
+static int gradientMismatches(Matrix& values, const Matrix& gradient, float scale, Loss loss, float eps, double tolerance)
+{
+	if (gradient.rows() != values.rows() || gradient.columns() != values.columns())
+		return values.rows() * values.columns();
+
+	int res = 0;
+	for (int r = 0; r < values.rows(); r++)
+		for (int c = 0; c < values.columns(); c++)
+		{
+			const float x = values.at(r, c);
+			values.at(r, c) = x + eps;
+			const double plus = loss();
+			values.at(r, c) = x - eps;
+			const double minus = loss();
+			values.at(r, c) = x;
+
+			const double numeric = (plus - minus) / (2.0 * eps);
+			if (std::fabs(gradient.at(r, c) * scale - numeric) > tolerance * (1.0 + std::fabs(numeric)))
+				res++;
+		}
+	return res;
+}
+
+#endif //_GRADIENT_CHECK_H_
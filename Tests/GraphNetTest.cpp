@@ -0,0 +1,99 @@
+#include "Test.h"
+#include "GradientCheck.h"
+#include "../GraphNet.h"
+#include "../Learning/Adam.h"
+#include <cstdlib>
+
+// Creates graph with shared nodes, concatenation and splits, weights learned by given rules:
+//   a = W1 * x, s = a + a (one consumer using a twice), b = tanh(a) (another consumer of a),
+//   c = [s; b; x], outputs W2 * c[2..7] and c[0..2]
+static void createGraph(GraphNet& graph, unsigned seed, LearningRule* first, LearningRule* second)
+{
+	std::srand(seed);
+	const int x = graph.addInput(3);
+	const int a = graph.addLayer(new WeightLayer(4, first), x);
+	const int s = graph.addSum({ a, a });
+	const int b = graph.addLayer(new TanhLayer(4), a);
+	const int c = graph.addConcat({ s, b, x });
+	graph.addLayer(new WeightLayer(2, second), graph.addSplit(c, 2, 6));
+	graph.addOutput(graph.nodes() - 1);
+	graph.addOutput(graph.addSplit(c, 0, 3));
+}
+
+// Error of the input and gradients match finite differences: errors of a node used twice by one consumer and by
+// several consumers are summed, concatenation and splits pass errors to the right rows
+static void testGradients()
+{
+	GradientCapture* first = new GradientCapture();
+	GradientCapture* second = new GradientCapture();
+	GraphNet graph;
+	createGraph(graph, 3, first, second);
+
+	Matrix in(3, 4), target0(2, 4), target1(3, 4);
+	in.rand(-1.0f, 1.0f);
+	target0.rand(-1.0f, 1.0f);
+	target1.rand(-1.0f, 1.0f);
+
+	graph.processInput(in);
+	graph.processError({ graph.output(0) - target0, graph.output(1) - target1 });
+	const Matrix inputError = graph.inputError();
+	graph.updateParameters();
+
+	auto loss = [&]()
+	{
+		graph.processInput(in);
+		return squaredError(graph.output(0), target0) + squaredError(graph.output(1), target1);
+	};
+	CHECK(gradientMismatches(in, inputError, 1.0f, loss, 1e-2f, 2e-3) == 0);
+
+	std::vector<NetLayer*> layers = graph.layers();
+	CHECK(layers.size() == 3);
+	CHECK(gradientMismatches(*layers[0]->parameters()[0], first->gradient, 4.0f, loss, 1e-2f, 2e-3) == 0);
+	CHECK(gradientMismatches(*layers[2]->parameters()[0], second->gradient, 4.0f, loss, 1e-2f, 2e-3) == 0);
+}
+
+// Serial and threaded schedules give bit-identical outputs, errors and parameters
+static void testThreads()
+{
+	GraphNet serial(1), threaded(4);
+	createGraph(serial, 8, new Adam(), new Adam());
+	createGraph(threaded, 8, new Adam(), new Adam());
+	CHECK(threaded.threads() == 4);
+
+	Matrix in(3, 16), target0(2, 16), target1(3, 16);
+	in.rand(-1.0f, 1.0f);
+	target0.rand(-1.0f, 1.0f);
+	target1.rand(-1.0f, 1.0f);
+
+	for (int i = 0; i < 5; i++)
+	{
+		serial.processInput(in);
+		threaded.processInput(in);
+		CHECK(abs(serial.output(0) - threaded.output(0)).sum() == 0.0f);
+		CHECK(abs(serial.output(1) - threaded.output(1)).sum() == 0.0f);
+
+		serial.processError({ serial.output(0) - target0, serial.output(1) - target1 });
+		threaded.processError({ threaded.output(0) - target0, threaded.output(1) - target1 });
+		CHECK(abs(serial.inputError() - threaded.inputError()).sum() == 0.0f);
+
+		serial.updateParameters();
+		threaded.updateParameters();
+	}
+
+	std::vector<NetLayer*> a = serial.layers();
+	std::vector<NetLayer*> b = threaded.layers();
+	for (unsigned l = 0; l < a.size(); l++)
+	{
+		std::vector<Matrix*> p = a[l]->parameters();
+		std::vector<Matrix*> q = b[l]->parameters();
+		for (unsigned k = 0; k < p.size(); k++)
+			CHECK(abs(*p[k] - *q[k]).sum() == 0.0f);
+	}
+}
+
+int main()
+{
+	RUN(testGradients);
+	RUN(testThreads);
+	return TEST_RESULT();
+}
@@ -0,0 +1,104 @@
+#include "Test.h"
+#include "../InferenceNet.h"
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+// Creates Input(5) -> Weight(12) -> Bias(12) -> Tanh(12) -> Weight(7) -> Bias(7) -> Rectifier(7) -> Weight(3)
+// -> Bias(3) -> Softplus(3) with parameters given by [seed]
+static void createNet(Net& net, unsigned seed)
+{
+	std::srand(seed);
+	net.addLayer(new InputLayer(5));
+	net.addLayer(new WeightLayer(12, NULL));
+	net.addLayer(new BiasLayer(12, NULL));
+	net.addLayer(new TanhLayer(12));
+	net.addLayer(new WeightLayer(7, NULL));
+	net.addLayer(new BiasLayer(7, NULL));
+	net.addLayer(new RectifierLayer(7));
+	net.addLayer(new WeightLayer(3, NULL));
+	net.addLayer(new BiasLayer(3, NULL));
+	net.addLayer(new SoftplusLayer(3));
+
+	// bias is zero after initialization
+	for (unsigned l = 0; l < net.layers().size(); l++)
+		if (dynamic_cast<BiasLayer*>(net.layers()[l]))
+			net.layers()[l]->parameters()[0]->rand(-0.5f, 0.5f);
+}
+
+// Checks that compiled [net] gives bit-identical outputs for batches of 1 to 300 samples
+static void checkBatches(Net& net)
+{
+	const InferenceNet inference(net);
+	CHECK(inference.inputs() == 5 && inference.outputs() == 3);
+	InferenceNet::Context context(inference, 300);
+
+	Matrix samples(5, 300);
+	samples.rand(-2.0f, 2.0f);
+
+	// samples one after another
+	std::vector<float> in(5 * 300), out(3 * 300);
+	for (int c = 0; c < 300; c++)
+		for (int r = 0; r < 5; r++)
+			in[c * 5 + r] = samples.at(r, c);
+
+	int mismatches = 0;
+	for (int count = 1; count <= 300; count++)
+	{
+		const Matrix batch = samples.block(0, 0, 5, count);
+		net.processInput(batch);
+		const Matrix& expected = net.output();
+
+		inference.process(&in[0], &out[0], context, count);
+		for (int c = 0; c < count; c++)
+			for (int r = 0; r < 3; r++)
+				if (out[c * 3 + r] != expected.at(r, c))
+					mismatches++;
+
+		if (count % 37 == 1 && abs(inference.process(batch) - expected).sum() != 0.0f)
+			mismatches++;
+	}
+	CHECK(mismatches == 0);
+}
+
+// Results are bit-identical to Net::processInput() for separate and fused layers
+static void testBitIdentical()
+{
+	Net net;
+	createNet(net, 5);
+	checkBatches(net);
+
+	CHECK(net.fuse() == 3);
+	checkBatches(net);
+}
+
+// Request larger than the batch of the context throws
+static void testContextBatch()
+{
+	Net net;
+	createNet(net, 2);
+	const InferenceNet inference(net);
+	InferenceNet::Context context(inference, 4);
+	CHECK(context.batch() == 4);
+
+	std::vector<float> in(5 * 5, 0.5f), out(3 * 5);
+	inference.process(&in[0], &out[0], context, 4);
+
+	bool thrown = false;
+	try
+	{
+		inference.process(&in[0], &out[0], context, 5);
+	}
+	catch (const std::invalid_argument&)
+	{
+		thrown = true;
+	}
+	CHECK(thrown);
+}
+
+int main()
+{
+	RUN(testBitIdentical);
+	RUN(testContextBatch);
+	return TEST_RESULT();
+}
@@ -0,0 +1,119 @@
+#include "Test.h"
+#include "../Net.h"
+#include "../Learning/Adam.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Number of heap allocations of the program (all threads), counted by the replaced global operator new
+static std::atomic<size_t> heapAllocations(0);
+
+// Counting allocation functions (all other forms of operator new and delete use these)
+void* operator new(size_t size)
+{
+	heapAllocations.fetch_add(1, std::memory_order_relaxed);
+	void* p = std::malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+// Runs one training step of [net] on fixed batch (cross-entropy when [labels] are given)
+static void step(Net& net, const Matrix& in, const Matrix& target, const std::vector<int>& labels)
+{
+	net.processInput(in);
+	if (labels.empty())
+		net.processError(net.output() - target);
+	else
+		net.processError(labels);
+	net.updateParameters();
+}
+
+// Checks that training steps of [net] do not allocate from the heap after warm-up (released storage pooled)
+static void checkSteps(Net& net, int inputs, int outputs, bool classify)
+{
+	Matrix in(inputs, 8), target(outputs, 8);
+	in.rand(-1.0f, 1.0f);
+	target.rand(-1.0f, 1.0f);
+	std::vector<int> labels;
+	if (classify)
+		labels = { 0, 1, 2, 0, 1, 2, 2, 1 };
+
+	// warm-up (state of learning rules, released storage of all sizes)
+	for (int i = 0; i < 3; i++)
+		step(net, in, target, labels);
+
+	const size_t matrices = Matrix::allocations();
+	const size_t allocations = heapAllocations;
+	for (int i = 0; i < 10; i++)
+		step(net, in, target, labels);
+	CHECK(Matrix::allocations() == matrices);
+	CHECK(heapAllocations == allocations);
+}
+
+// Training steps of the same sizes do not allocate after warm-up when released storage is pooled
+static void testTrainingWithoutAllocations()
+{
+	Matrix::setPoolLimit(64 << 20);
+
+	// fused layers, squared error
+	Net dense;
+	std::srand(3);
+	dense.addLayer(new InputLayer(6));
+	dense.addLayer(new DenseLayer(16, Matrix::Tanh, new Adam(), new Adam()));
+	dense.addLayer(new DenseLayer(16, Matrix::Tanh, new Adam(), new Adam()));
+	dense.addLayer(new DenseLayer(2, Matrix::Identity, new Adam(), new Adam()));
+	checkSteps(dense, 6, 2, false);
+
+	// separate layers, cross-entropy
+	Net classifier;
+	classifier.addLayer(new InputLayer(6));
+	classifier.addLayer(new WeightLayer(8, new Adam()));
+	classifier.addLayer(new BiasLayer(8, new Adam()));
+	classifier.addLayer(new TanhLayer(8));
+	classifier.addLayer(new WeightLayer(3, new Adam()));
+	classifier.addLayer(new BiasLayer(3, new Adam()));
+	classifier.addLayer(new SoftmaxLayer(3));
+	checkSteps(classifier, 6, 3, true);
+
+	// convolution and pooling
+	Net convolution;
+	convolution.addLayer(new InputLayer(12));
+	convolution.addLayer(new ConvolutionLayer(Window::line(1, 12, 3, 1, 1), 4, new Adam(), new Adam()));
+	convolution.addLayer(new PoolingLayer(Window::line(4, 12, 2, 2), PoolingLayer::Max));
+	convolution.addLayer(new DenseLayer(2, Matrix::Identity, new Adam(), new Adam()));
+	checkSteps(convolution, 12, 2, false);
+
+	Matrix::setPoolLimit(0);
+}
+
+// Released storage is returned to the heap when pooling is disabled (default)
+static void testPoolDisabled()
+{
+	Matrix::setPoolLimit(0);
+
+	Matrix a(7, 9);
+	a.rand(-1.0f, 1.0f);
+	Matrix product = a * a.t();
+
+	const size_t allocations = Matrix::allocations();
+	product = a * a.t();
+	CHECK(Matrix::allocations() > allocations);
+}
+
+int main()
+{
+	RUN(testPoolDisabled);
+	RUN(testTrainingWithoutAllocations);
+	return TEST_RESULT();
+}
@@ -0,0 +1,103 @@
+#include "Test.h"
+#include "../Net.h"
+#include "../Learning/Adam.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+// Creates Input(4) -> Weight -> Bias -> Tanh -> Weight -> Bias -> Softmax(3) with parameters given by [seed]
+static void createClassifier(Net& net, unsigned seed)
+{
+	std::srand(seed);
+	net.addLayer(new InputLayer(4));
+	net.addLayer(new WeightLayer(6, new Adam()));
+	net.addLayer(new BiasLayer(6, new Adam()));
+	net.addLayer(new TanhLayer(6));
+	net.addLayer(new WeightLayer(3, new Adam()));
+	net.addLayer(new BiasLayer(3, new Adam()));
+	net.addLayer(new SoftmaxLayer(3));
+}
+
+// Cross-entropy loss and gradients do not change with checkpointing (input of softmax released)
+static void testCrossEntropyCheckpointing()
+{
+	Net plain, checkpointed;
+	createClassifier(plain, 7);
+	createClassifier(checkpointed, 7);
+	checkpointed.setCheckpointInterval(2);
+
+	Matrix in(4, 5);
+	in.rand(-1.0f, 1.0f);
+	const std::vector<int> labels = { 0, 2, 1, 1, 0 };
+
+	for (int i = 0; i < 3; i++)
+	{
+		plain.processInput(in);
+		checkpointed.processInput(in);
+		const float loss = plain.processError(labels);
+		CHECK(checkpointed.processError(labels) == loss);
+		CHECK(std::isfinite(loss));
+
+		plain.updateParameters();
+		checkpointed.updateParameters();
+	}
+
+	for (unsigned l = 0; l < plain.layers().size(); l++)
+	{
+		std::vector<Matrix*> a = plain.layers()[l]->parameters();
+		std::vector<Matrix*> b = checkpointed.layers()[l]->parameters();
+		for (unsigned p = 0; p < a.size(); p++)
+			CHECK(abs(*a[p] - *b[p]).sum() == 0.0f);
+	}
+}
+
+// Creates Input(4) -> Weight(3) -> Bias(3) with parameters given by [seed]
+static void createLinear(Net& net, unsigned seed)
+{
+	std::srand(seed);
+	net.addLayer(new InputLayer(4));
+	net.addLayer(new WeightLayer(3, NULL));
+	net.addLayer(new BiasLayer(3, NULL));
+}
+
+// Text model loaded over parameters wrapping a binary model (read-only mapped pages) and over shared parameters
+static void testTextAfterBinary()
+{
+	const std::string dir = std::filesystem::temp_directory_path().string();
+	const std::string bin = dir + "/NetTest.bin", txt = dir + "/NetTest.txt", other = dir + "/NetTest2.txt";
+
+	Net net, source;
+	createLinear(net, 1);
+	createLinear(source, 2);
+	net.saveToFile(bin.c_str(), true);
+	source.saveToFile(txt.c_str());
+	net.saveToFile(other.c_str());
+
+	net.loadFromFile(bin.c_str());
+	net.loadFromFile(txt.c_str());
+	for (unsigned l = 0; l < net.layers().size(); l++)
+	{
+		std::vector<Matrix*> a = net.layers()[l]->parameters();
+		std::vector<Matrix*> b = source.layers()[l]->parameters();
+		for (unsigned p = 0; p < a.size(); p++)
+			CHECK(abs(*a[p] - *b[p]).sum() == 0.0f);
+	}
+
+	// copy sharing storage with the parameters is not changed by the load
+	Matrix snapshot = *net.layers()[1]->parameters()[0];
+	net.loadFromFile(other.c_str());
+	CHECK(abs(snapshot - *source.layers()[1]->parameters()[0]).sum() == 0.0f);
+
+	std::remove(bin.c_str());
+	std::remove(txt.c_str());
+	std::remove(other.c_str());
+}
+
+int main()
+{
+	RUN(testCrossEntropyCheckpointing);
+	RUN(testTextAfterBinary);
+	return TEST_RESULT();
+}
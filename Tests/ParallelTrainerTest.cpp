@@ -0,0 +1,168 @@
+#include "Test.h"
+#include "../Net.h"
+#include "../Learning/Adam.h"
+#include "../Learning/ParallelTrainer.h"
+#include <cstdlib>
+#include <stdexcept>
+
+// Creates Input(4) -> Dense(8, Tanh) -> Weight(3) -> Bias(3) with parameters given by [seed]
+static void createNet(Net& net, unsigned seed)
+{
+	std::srand(seed);
+	net.addLayer(new InputLayer(4));
+	net.addLayer(new DenseLayer(8, Matrix::Tanh, new Adam(), new Adam()));
+	net.addLayer(new WeightLayer(3, new Adam()));
+	net.addLayer(new BiasLayer(3, new Adam()));
+}
+
+// Fills batch of 32 samples
+static void createBatch(Matrix& inputs, Matrix& targets)
+{
+	inputs.resize(4, 32);
+	targets.resize(3, 32);
+	for (int c = 0; c < 32; c++)
+	{
+		for (int r = 0; r < 4; r++)
+			inputs.at(r, c) = 0.05f * ((r * 7 + c * 3) % 17) - 0.4f;
+		for (int r = 0; r < 3; r++)
+			targets.at(r, c) = 0.1f * ((r + c) % 5) - 0.2f;
+	}
+}
+
+// Deterministic results do not depend on the number of worker threads (workers kept between batches)
+static void testDeterministicThreads()
+{
+	Net single, multi;
+	createNet(single, 11);
+	createNet(multi, 11);
+
+	ParallelTrainer a(single, 1, true, 4);
+	ParallelTrainer b(multi, 4, true, 4);
+
+	Matrix inputs, targets;
+	createBatch(inputs, targets);
+	for (int i = 0; i < 5; i++)
+	{
+		a.train(inputs, targets);
+		b.train(inputs, targets);
+	}
+
+	for (unsigned l = 0; l < single.layers().size(); l++)
+	{
+		std::vector<Matrix*> p = single.layers()[l]->parameters();
+		std::vector<Matrix*> q = multi.layers()[l]->parameters();
+		for (unsigned k = 0; k < p.size(); k++)
+			CHECK(abs(*p[k] - *q[k]).sum() == 0.0f);
+	}
+}
+
+// Replicas share parameters of the network, creating the trainer does not use std::rand
+static void testReplicasNotInitialized()
+{
+	Net net;
+	createNet(net, 5);
+
+	std::srand(17);
+	const int expected = std::rand();
+
+	std::srand(17);
+	ParallelTrainer trainer(net, 4, true, 8);
+	CHECK(std::rand() == expected);
+}
+
+// Exception of a task is rethrown by train(), trainer can be used afterwards
+static void testException()
+{
+	Net net;
+	createNet(net, 3);
+	ParallelTrainer trainer(net, 4, true, 4);
+
+	Matrix inputs, targets;
+	createBatch(inputs, targets);
+
+	trainer.errorFunction = [](const Matrix&, const Matrix&) -> Matrix { throw std::runtime_error("Test: Error."); };
+	bool thrown = false;
+	try
+	{
+		trainer.train(inputs, targets);
+	}
+	catch (const std::runtime_error&)
+	{
+		thrown = true;
+	}
+	CHECK(thrown);
+
+	trainer.errorFunction = [](const Matrix& output, const Matrix& target) { return output - target; };
+	trainer.train(inputs, targets);
+	trainer.trainAsync(inputs, targets, 4);
+}
+
+// Returns squared error loss of the network on given batch
+static float loss(Net& net, const Matrix& inputs, const Matrix& targets)
+{
+	net.processInput(inputs);
+	const Matrix difference = net.output() - targets;
+	float res = 0.0f;
+	for (int r = 0; r < difference.rows(); r++)
+		for (int c = 0; c < difference.columns(); c++)
+			res += 0.5f * difference.at(r, c) * difference.at(r, c);
+	return res;
+}
+
+// Asynchronous training decreases the loss, keeps states of the network's rules and leaves parameters owned
+// by the network (valid after the trainer and its workers are destroyed, copy-on-write)
+static void testAsync()
+{
+	Net net;
+	createNet(net, 6);
+	ParallelTrainer* trainer = new ParallelTrainer(net, 4);
+
+	Matrix inputs, targets;
+	createBatch(inputs, targets);
+
+	// states of the rules after synchronous training
+	trainer->train(inputs, targets);
+	std::vector<std::vector<Matrix> > states;
+	for (unsigned l = 0; l < net.layers().size(); l++)
+		for (LearningRule* rule : net.layers()[l]->learningRules())
+			states.push_back(rule->state());
+
+	const float before = loss(net, inputs, targets);
+	for (int epoch = 0; epoch < 30; epoch++)
+		trainer->trainAsync(inputs, targets, 4);
+	const float after = loss(net, inputs, targets);
+	CHECK(after < before);
+
+	delete trainer;
+	CHECK(loss(net, inputs, targets) == after);
+
+	unsigned index = 0;
+	for (unsigned l = 0; l < net.layers().size(); l++)
+		for (LearningRule* rule : net.layers()[l]->learningRules())
+		{
+			const std::vector<Matrix> state = rule->state();
+			CHECK(state.size() == states[index].size());
+			for (unsigned k = 0; k < state.size() && k < states[index].size(); k++)
+				CHECK(abs(state[k] - states[index][k]).sum() == 0.0f);
+			index++;
+		}
+
+	// copy-on-write works again: change of a parameter does not change its copy
+	for (unsigned l = 0; l < net.layers().size(); l++)
+		for (Matrix* param : net.layers()[l]->parameters())
+		{
+			const Matrix copy = *param;
+			const float value = copy.at(0, 0);
+			param->at(0, 0) += 1.0f;
+			CHECK(copy.at(0, 0) == value && param->at(0, 0) != value);
+		}
+}
+
+int main()
+{
+	RUN(testDeterministicThreads);
+	RUN(testReplicasNotInitialized);
+	RUN(testException);
+	RUN(testAsync);
+	return TEST_RESULT();
+}
@@ -0,0 +1,106 @@
+#include "Test.h"
+#include "../Net.h"
+#include "../Learning/Adam.h"
+#include "../Learning/PipelineTrainer.h"
+#include <cstdlib>
+#include <stdexcept>
+
+// Creates Input(4) -> Dense(8, Tanh) -> Dense(8, Tanh) -> Weight(3) -> Bias(3) with parameters given by [seed]
+static void createNet(Net& net, unsigned seed)
+{
+	std::srand(seed);
+	net.addLayer(new InputLayer(4));
+	net.addLayer(new DenseLayer(8, Matrix::Tanh, new Adam(), new Adam()));
+	net.addLayer(new DenseLayer(8, Matrix::Tanh, new Adam(), new Adam()));
+	net.addLayer(new WeightLayer(3, new Adam()));
+	net.addLayer(new BiasLayer(3, new Adam()));
+}
+
+// Fills batch of 16 samples
+static void createBatch(Matrix& inputs, Matrix& targets)
+{
+	inputs.resize(4, 16);
+	targets.resize(3, 16);
+	for (int c = 0; c < 16; c++)
+	{
+		for (int r = 0; r < 4; r++)
+			inputs.at(r, c) = 0.05f * ((r * 5 + c * 3) % 13) - 0.3f;
+		for (int r = 0; r < 3; r++)
+			targets.at(r, c) = 0.1f * ((r + c) % 4) - 0.15f;
+	}
+}
+
+// Returns true when parameters of both networks are equal
+static bool sameParameters(Net& a, Net& b)
+{
+	for (unsigned l = 0; l < a.layers().size(); l++)
+	{
+		std::vector<Matrix*> p = a.layers()[l]->parameters();
+		std::vector<Matrix*> q = b.layers()[l]->parameters();
+		for (unsigned k = 0; k < p.size(); k++)
+			if (abs(*p[k] - *q[k]).sum() != 0.0f)
+				return false;
+	}
+	return true;
+}
+
+// Results do not depend on the number of stages or on the schedule (stage threads kept between batches)
+static void testStages()
+{
+	Net single, gpipe, interleaved;
+	createNet(single, 9);
+	createNet(gpipe, 9);
+	createNet(interleaved, 9);
+
+	PipelineTrainer a(single, 1, 4);
+	PipelineTrainer b(gpipe, 3, 4, PipelineTrainer::GPipe);
+	PipelineTrainer c(interleaved, 4, 4, PipelineTrainer::OneForwardOneBackward);
+	CHECK(b.stages() == 3 && c.stages() == 4);
+
+	Matrix inputs, targets;
+	createBatch(inputs, targets);
+	for (int i = 0; i < 5; i++)
+	{
+		a.train(inputs, targets);
+		b.train(inputs, targets);
+		c.train(inputs, targets);
+	}
+
+	CHECK(sameParameters(single, gpipe));
+	CHECK(sameParameters(single, interleaved));
+}
+
+// Exception of a stage is rethrown by train(), stage threads keep running the next batches
+static void testException()
+{
+	Net net;
+	createNet(net, 4);
+	PipelineTrainer trainer(net, 3, 2);
+
+	Matrix inputs, targets;
+	createBatch(inputs, targets);
+
+	trainer.errorFunction = [](const Matrix&, const Matrix&) -> Matrix { throw std::runtime_error("Test: Error."); };
+	bool thrown = false;
+	try
+	{
+		trainer.train(inputs, targets);
+	}
+	catch (const std::runtime_error&)
+	{
+		thrown = true;
+	}
+	CHECK(thrown);
+
+	trainer.errorFunction = [](const Matrix& output, const Matrix& target) { return output - target; };
+	for (int i = 0; i < 3; i++)
+		trainer.train(inputs, targets);
+	CHECK(trainer.elapsedTime() > 0);
+}
+
+int main()
+{
+	RUN(testStages);
+	RUN(testException);
+	return TEST_RESULT();
+}
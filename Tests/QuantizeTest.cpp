@@ -0,0 +1,103 @@
+#include "Test.h"
+#include "../Net.h"
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+// Creates Input(8) -> Dense(16, Tanh) -> Weight(8) -> Bias(8) -> Tanh(8) -> Weight(3) with parameters given by [seed]
+static void createNet(Net& net, unsigned seed)
+{
+	std::srand(seed);
+	net.addLayer(new InputLayer(8));
+	net.addLayer(new DenseLayer(16, Matrix::Tanh, NULL, NULL));
+	net.addLayer(new WeightLayer(8, NULL));
+	net.addLayer(new BiasLayer(8, NULL));
+	net.addLayer(new TanhLayer(8));
+	net.addLayer(new WeightLayer(3, NULL));
+}
+
+// Returns [count] samples in columns
+static Matrix createSamples(int count)
+{
+	Matrix res(8, count);
+	res.rand(-1.0f, 1.0f);
+	return res;
+}
+
+// Output of the quantized network stays close to the float network (also for samples outside calibration)
+static void testAccuracy()
+{
+	Net reference, quantized;
+	createNet(reference, 4);
+	createNet(quantized, 4);
+
+	CHECK(quantized.quantize(createSamples(64)) == 3);
+	CHECK(quantized.layers().size() == 4);
+
+	const Matrix samples = createSamples(32);
+	reference.processInput(samples);
+	quantized.processInput(samples);
+
+	const Matrix& expected = reference.output();
+	const Matrix& output = quantized.output();
+	CHECK(output.rows() == 3 && output.columns() == 32);
+	float difference = 0.0f, largest = 0.0f;
+	for (int r = 0; r < expected.rows(); r++)
+		for (int c = 0; c < expected.columns(); c++)
+		{
+			difference = std::max(difference, std::fabs(output.at(r, c) - expected.at(r, c)));
+			largest = std::max(largest, std::fabs(expected.at(r, c)));
+		}
+	CHECK(difference < 0.03f * std::max(largest, 1.0f));
+}
+
+// Batches of at least 4 samples (widened rows) give the same outputs as smaller batches
+static void testBatchSizes()
+{
+	Net net;
+	createNet(net, 6);
+	net.quantize(createSamples(64));
+
+	const Matrix samples = createSamples(11);
+	net.processInput(samples);
+	const Matrix expected = net.output();
+
+	const int batches[] = { 1, 2, 3 };
+	for (int batch : batches)
+	{
+		for (int c = 0; c + batch <= samples.columns(); c += batch)
+		{
+			net.processInput(samples.block(0, c, 8, batch));
+			CHECK(abs(net.output() - expected.block(0, c, 3, batch)).sum() == 0.0f);
+		}
+	}
+}
+
+// Quantized network cannot be trained
+static void testProcessError()
+{
+	Net net;
+	createNet(net, 2);
+	net.quantize(createSamples(16));
+
+	const Matrix samples = createSamples(4);
+	net.processInput(samples);
+	bool thrown = false;
+	try
+	{
+		net.processError(net.output());
+	}
+	catch (const std::runtime_error&)
+	{
+		thrown = true;
+	}
+	CHECK(thrown);
+}
+
+int main()
+{
+	RUN(testAccuracy);
+	RUN(testBatchSizes);
+	RUN(testProcessError);
+	return TEST_RESULT();
+}
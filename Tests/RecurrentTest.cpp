@@ -0,0 +1,134 @@
+#include "Test.h"
+#include "GradientCheck.h"
+#include <cmath>
+#include <cstdlib>
+
+// Creates Input(3) -> [Layer](4) with learning rules capturing gradients and random bias
+template <class Layer>
+static Layer* createNet(Net& net, unsigned seed)
+{
+	std::srand(seed);
+	Layer* layer = new Layer(4, new GradientCapture(), new GradientCapture());
+	net.addLayer(new InputLayer(3));
+	net.addLayer(layer);
+	layer->parameters()[2]->rand(-0.5f, 0.5f);
+	return layer;
+}
+
+// Checks backpropagation through the steps of a window of [sequences] after [prefix] steps of the same sequences:
+// error of the input, and gradients of all parameters when the window starts from the reset state
+template <class Layer>
+static void checkGradients(int sequences, int steps, int prefix)
+{
+	Net net;
+	Layer* layer = createNet<Layer>(net, 13);
+
+	Matrix before(3, prefix * sequences), in(3, steps * sequences), target(4, steps * sequences);
+	before.rand(-1.0f, 1.0f);
+	in.rand(-1.0f, 1.0f);
+	target.rand(-1.0f, 1.0f);
+
+	// output of the window from the state after the prefix (truncated: the prefix does not get error)
+	auto forward = [&]()
+	{
+		layer->reset(sequences);
+		if (prefix > 0)
+			net.processInput(before);
+		net.processInput(in);
+	};
+	auto loss = [&]() { forward(); return squaredError(net.output(), target); };
+
+	forward();
+	net.processError(net.output() - target);
+	const Matrix inputError = net.layers()[0]->error();
+	net.updateParameters();
+	CHECK(gradientMismatches(in, inputError, 1.0f, loss, 5e-3f, 2e-3) == 0);
+
+	// parameters change the state after the prefix as well, so they are checked from the reset state
+	if (prefix > 0)
+		return;
+	std::vector<Matrix*> parameters = layer->parameters();
+	std::vector<LearningRule*> rules = layer->learningRules();
+	CHECK(parameters.size() == 3 && rules.size() == 3);
+	for (unsigned k = 0; k < parameters.size(); k++)
+	{
+		const Matrix& gradient = static_cast<GradientCapture*>(rules[k])->gradient;
+		CHECK(gradientMismatches(*parameters[k], gradient, (float)in.columns(), loss, 5e-3f, 2e-3) == 0);
+	}
+}
+
+// BPTT gradients of LSTM and GRU match finite differences (1 and several sequences, window after another one)
+static void testGradients()
+{
+	checkGradients<LSTMLayer>(1, 5, 0);
+	checkGradients<LSTMLayer>(3, 4, 0);
+	checkGradients<LSTMLayer>(2, 3, 2);
+	checkGradients<GRULayer>(1, 5, 0);
+	checkGradients<GRULayer>(3, 4, 0);
+	checkGradients<GRULayer>(2, 3, 2);
+}
+
+// Returns maximum absolute difference of matrices of the same size
+static float maxDifference(const Matrix& a, const Matrix& b)
+{
+	float res = 0.0f;
+	for (int r = 0; r < a.rows(); r++)
+		for (int c = 0; c < a.columns(); c++)
+			res = std::max(res, std::fabs(a.at(r, c) - b.at(r, c)));
+	return res;
+}
+
+// Checks that windows of given lengths (summing to 6 steps) give the same outputs and state as one window
+template <class Layer>
+static void checkStreaming(int sequences, const std::vector<int>& windows)
+{
+	Net net;
+	Layer* layer = createNet<Layer>(net, 21);
+
+	const int steps = 6;
+	Matrix in(3, steps * sequences);
+	in.rand(-1.0f, 1.0f);
+
+	layer->reset(sequences);
+	net.processInput(in);
+	const Matrix expected = net.output();
+	const Matrix state = layer->state();
+
+	layer->reset(sequences);
+	Matrix output(4, steps * sequences);
+	int step = 0;
+	for (int length : windows)
+	{
+		const int column = step * sequences;
+		net.processInput(in.block(0, column, 3, length * sequences));
+		for (int r = 0; r < 4; r++)
+			for (int c = 0; c < length * sequences; c++)
+				output.at(r, column + c) = net.output().at(r, c);
+		step += length;
+	}
+
+	CHECK(step == steps);
+	CHECK(maxDifference(output, expected) < 1e-5f);
+	CHECK(maxDifference(layer->state(), state) < 1e-5f);
+}
+
+// Streaming (split windows, single steps) gives the same outputs as the whole window
+static void testStreaming()
+{
+	const std::vector<int> split = { 2, 3, 1 };
+	const std::vector<int> single = { 1, 1, 1, 1, 1, 1 };
+	for (int sequences = 1; sequences <= 3; sequences += 2)
+	{
+		checkStreaming<LSTMLayer>(sequences, split);
+		checkStreaming<LSTMLayer>(sequences, single);
+		checkStreaming<GRULayer>(sequences, split);
+		checkStreaming<GRULayer>(sequences, single);
+	}
+}
+
+int main()
+{
+	RUN(testGradients);
+	RUN(testStreaming);
+	return TEST_RESULT();
+}
@@ -0,0 +1,25 @@
+#ifndef _TEST_H_
+#define _TEST_H_
+
+#include <cstdio>
+#include <exception>
+
+// Minimal checks of the test programs. Each test file is a program built with all sources of the library, e.g.
+//   g++ -std=c++17 -O2 -pthread -I. Tests/NetTest.cpp *.cpp Algebra/*.cpp IO/*.cpp Layers/*.cpp Learning/*.cpp
+// and returns non-zero when a check fails.
+
+// Number of failed checks
+static int testFailures = 0;
+
+// Reports failed condition (test continues)
+#define CHECK(cond) \
+	do { if (!(cond)) { std::fprintf(stderr, "%s:%d: Check failed: %s\n", __FILE__, __LINE__, #cond); testFailures++; } } while (0)
+
+// Runs test function, reports exceptions as failures
+#define RUN(test) \
+	do { try { test(); } catch (const std::exception& e) { std::fprintf(stderr, "%s: Exception: %s\n", #test, e.what()); testFailures++; } } while (0)
+
+// Returns exit code of the test program
+#define TEST_RESULT() (testFailures == 0 ? 0 : 1)
+
+#endif //_TEST_H_